@@ -113,7 +113,7 @@ void CActiveMasternodeManager::Init()
         // Check socket connectivity
         LogPrintf("CActiveDeterministicMasternodeManager::Init -- Checking inbound connection to '%s'\n", activeMasternodeInfo.service.ToString());
         SOCKET hSocket;
-        bool fConnected = ConnectSocket(activeMasternodeInfo.service, hSocket, nConnectTimeout) && IsSelectableSocket(hSocket);
+        bool fConnected = ConnectSocket(activeMasternodeInfo.service, hSocket, nConnectTimeout);
         CloseSocket(hSocket);
 
         if (!fConnected) {
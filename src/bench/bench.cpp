@@ -35,6 +35,7 @@ benchmark::BenchRunner::RunAll(double elapsedTimeForOne)
     for (const auto &p: benchmarks()) {
         State state(p.first, elapsedTimeForOne);
         p.second(state);
+        state.Report();
     }
     perf_fini();
 }
@@ -94,11 +95,24 @@ bool benchmark::State::KeepRunning()
 
     assert(count != 0 && "count == 0 => (now == 0 && beginTime == 0) => return above");
 
-    // Output results
-    double average = (now-beginTime)/count;
-    int64_t averageCycles = (nowCycles-beginCycles)/count;
-    std::cout << std::fixed << std::setprecision(15) << name << "," << count << "," << minTime << "," << maxTime << "," << average << ","
-              << minCycles << "," << maxCycles << "," << averageCycles << "\n";
+    average = (now-beginTime)/count;
+    averageCycles = (nowCycles-beginCycles)/count;
 
     return false;
 }
+
+void benchmark::State::Report() const
+{
+    if (count == 0)
+        return;
+
+    // Extra results follow the timings as name=value fields, so that the columns stay the same for all benchmarks
+    std::cout << std::fixed << std::setprecision(15) << name << "," << count << "," << minTime << "," << maxTime << "," << average << ","
+              << minCycles << "," << maxCycles << "," << averageCycles;
+    std::cout << std::setprecision(2);
+    if (itemsPerIteration)
+        std::cout << ",items_per_second=" << itemsPerIteration / average;
+    for (const auto& counter : counters)
+        std::cout << "," << counter.first << "=" << counter.second;
+    std::cout << "\n";
+}
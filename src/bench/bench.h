@@ -47,8 +47,14 @@ namespace benchmark {
         uint64_t lastCycles;
         uint64_t minCycles;
         uint64_t maxCycles;
+        uint64_t itemsPerIteration;
+        double average;
+        int64_t averageCycles;
     public:
-        State(std::string _name, double _maxElapsed) : name(_name), maxElapsed(_maxElapsed), count(0) {
+        //! Further results, reported with the timings, e.g. how often something expensive ran per iteration
+        std::map<std::string, double> counters;
+
+        State(std::string _name, double _maxElapsed) : name(_name), maxElapsed(_maxElapsed), count(0), itemsPerIteration(0) {
             minTime = std::numeric_limits<double>::max();
             maxTime = std::numeric_limits<double>::min();
             minCycles = std::numeric_limits<uint64_t>::max();
@@ -57,6 +63,9 @@ namespace benchmark {
             countMaskInv = 1./(countMask + 1);
         }
         bool KeepRunning();
+        //! Also report the items processed per second, for iterations which each process this many
+        void SetItemsPerIteration(uint64_t n) { itemsPerIteration = n; }
+        void Report() const;
     };
 
     typedef boost::function<void(State&)> BenchFunction;
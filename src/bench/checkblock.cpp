@@ -50,5 +50,70 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+// Validates the block as DeserializeAndCheckBlockTest does and counts how often its header is hashed: every GetHash()
+// call ran X11 before hashes were memoized (header_hashes_per_block), x11_per_block is how many still do
+static void DeserializeCheckAndHashBlockTest(benchmark::State& state)
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    char a;
+    stream.write(&a, 1); // Prevent compaction
+
+    Consensus::Params params = Params(CBaseChainParams::MAIN).GetConsensus();
+
+    uint64_t nBlocks = 0;
+    uint64_t nGetHashStart = CBlockHeader::nGetHashCount;
+    uint64_t nX11Start = CBlockHeader::nX11HashCount;
+    while (state.KeepRunning()) {
+        CBlock block;
+        stream >> block;
+        assert(stream.Rewind(sizeof(raw_bench::block813851)));
+
+        CValidationState validationState;
+        assert(CheckBlock(block, validationState, params, block.GetBlockTime()));
+        nBlocks++;
+    }
+    state.counters["header_hashes_per_block"] = (double)(CBlockHeader::nGetHashCount - nGetHashStart) / nBlocks;
+    state.counters["x11_per_block"] = (double)(CBlockHeader::nX11HashCount - nX11Start) / nBlocks;
+}
+
+// Hashing the header of a deserialized block as often as ProcessNewBlock, AcceptBlock, CheckBlock and ConnectBlock
+// do, once through the memoized hash and once recomputing it every time
+static void HashBlockHeader(benchmark::State& state, bool fCached)
+{
+    static const int HASH_CALLS_PER_BLOCK = 8;
+
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    while (state.KeepRunning()) {
+        block.InvalidateHashCache();
+        for (int i = 0; i < HASH_CALLS_PER_BLOCK; i++) {
+            if (fCached) {
+                block.GetHash();
+            } else {
+                block.GetHashUncached();
+            }
+        }
+    }
+}
+
+static void HashBlockHeaderCached(benchmark::State& state)
+{
+    HashBlockHeader(state, true);
+}
+
+static void HashBlockHeaderUncached(benchmark::State& state)
+{
+    HashBlockHeader(state, false);
+}
+
 BENCHMARK(DeserializeBlockTest);
 BENCHMARK(DeserializeAndCheckBlockTest);
+BENCHMARK(DeserializeCheckAndHashBlockTest);
+BENCHMARK(HashBlockHeaderCached);
+BENCHMARK(HashBlockHeaderUncached);
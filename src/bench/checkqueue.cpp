@@ -6,6 +6,7 @@
 #include "util.h"
 #include "validation.h"
 #include "checkqueue.h"
+#include "key.h"
 #include "prevector.h"
 #include <vector>
 #include <boost/thread/thread.hpp>
@@ -99,5 +100,59 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     tg.interrupt_all();
     tg.join_all();
 }
+// This Benchmark runs the signature checks of a transaction spending nInputs
+// outputs of one address, like an ABN or GSC transmission, on all cores.
+static void CCheckQueueSpeedECDSA(benchmark::State& state, size_t nInputs)
+{
+    struct ECDSAJob {
+        CPubKey pubkey;
+        uint256 hash;
+        std::vector<unsigned char> sig;
+        bool operator()()
+        {
+            return pubkey.Verify(hash, sig);
+        }
+        void swap(ECDSAJob& x)
+        {
+            std::swap(pubkey, x.pubkey);
+            std::swap(hash, x.hash);
+            sig.swap(x.sig);
+        }
+    };
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<ECDSAJob> vJobs(nInputs);
+    for (size_t i = 0; i < nInputs; i++) {
+        vJobs[i].pubkey = key.GetPubKey();
+        vJobs[i].hash = ::SerializeHash((int)i);
+        key.Sign(vJobs[i].hash, vJobs[i].sig);
+    }
+
+    CCheckQueue<ECDSAJob> queue {QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    for (auto x = 0; x < std::max(MIN_CORES, GetNumCores()) - 1; ++x) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+    while (state.KeepRunning()) {
+        CCheckQueueControl<ECDSAJob> control(&queue);
+        // Add swaps the jobs out, so hand it a copy
+        std::vector<ECDSAJob> vChecks(vJobs);
+        control.Add(vChecks);
+        assert(control.Wait());
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+#define BENCH_CCheckQueueSpeedECDSA(nInputs) \
+    static void CCheckQueueSpeedECDSA_##nInputs(benchmark::State& state) \
+    { \
+        CCheckQueueSpeedECDSA(state, nInputs); \
+    } \
+    BENCHMARK(CCheckQueueSpeedECDSA_##nInputs)
+
 BENCHMARK(CCheckQueueSpeed);
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+BENCH_CCheckQueueSpeedECDSA(100)
+BENCH_CCheckQueueSpeedECDSA(500)
+BENCH_CCheckQueueSpeedECDSA(2000)
@@ -0,0 +1,54 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "random.h"
+#include "evo/deterministicmns.h"
+
+static CDeterministicMNList BuildMNList(size_t mnCount)
+{
+    CDeterministicMNList mnList(GetRandHash(), 1, 0);
+    for (size_t i = 0; i < mnCount; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>();
+        dmn->proTxHash = GetRandHash();
+        dmn->internalId = i;
+        dmn->collateralOutpoint = COutPoint(GetRandHash(), 0);
+        dmn->nOperatorReward = 0;
+
+        uint160 keyIDOwner;
+        GetRandBytes(keyIDOwner.begin(), keyIDOwner.size());
+
+        auto dmnState = std::make_shared<CDeterministicMNState>();
+        dmnState->keyIDOwner = CKeyID(keyIDOwner);
+        dmnState->UpdateConfirmedHash(dmn->proTxHash, GetRandHash());
+        dmn->pdmnState = dmnState;
+
+        mnList.AddMN(dmn);
+    }
+    return mnList;
+}
+
+static void CalculateQuorum(benchmark::State& state, size_t mnCount, size_t quorumSize)
+{
+    auto mnList = BuildMNList(mnCount);
+    uint256 modifier = GetRandHash();
+
+    while (state.KeepRunning()) {
+        auto members = mnList.CalculateQuorum(quorumSize, modifier);
+        modifier = members[0]->proTxHash;
+    }
+}
+
+#define BENCH_CalculateQuorum(mnCount, quorumSize) \
+    static void DMN_CalculateQuorum_##mnCount##_##quorumSize(benchmark::State& state) \
+    { \
+        CalculateQuorum(state, mnCount, quorumSize); \
+    } \
+    BENCHMARK(DMN_CalculateQuorum_##mnCount##_##quorumSize)
+
+BENCH_CalculateQuorum(100, 50)
+BENCH_CalculateQuorum(500, 50)
+BENCH_CalculateQuorum(500, 400)
+BENCH_CalculateQuorum(2000, 50)
+BENCH_CalculateQuorum(2000, 400)
@@ -6,6 +6,8 @@
 
 #include "key.h"
 
+#include <cassert>
+
 static void ECDSASign(benchmark::State& state)
 {
     std::vector<CKey> keys;
@@ -72,6 +74,48 @@ static void ECDSAVerify_LargeBlock(benchmark::State& state)
     }
 }
 
+// Checks the signatures of a transaction spending nInputs outputs of nKeys
+// addresses, ABN and GSC transmissions usually spend from a single one
+static void ECDSAVerifyInputs(benchmark::State& state, size_t nInputs, size_t nKeys)
+{
+    std::vector<CKey> keys(nKeys);
+    for (CKey& k : keys) {
+        k.MakeNewKey(true);
+    }
+    std::vector<CPubKey> pubkeys;
+    std::vector<uint256> hashes;
+    std::vector<std::vector<unsigned char>> sigs;
+    for (size_t i = 0; i < nInputs; i++) {
+        const CKey& k = keys[i % nKeys];
+        pubkeys.emplace_back(k.GetPubKey());
+        hashes.emplace_back(::SerializeHash((int)i));
+        std::vector<unsigned char> sig;
+        k.Sign(hashes[i], sig);
+        sigs.emplace_back(sig);
+    }
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < nInputs; i++) {
+            assert(pubkeys[i].Verify(hashes[i], sigs[i]));
+        }
+    }
+}
+
+#define BENCH_ECDSAVerifyInputs(nInputs, nKeys) \
+    static void ECDSAVerifyInputs_##nInputs##_##nKeys(benchmark::State& state) \
+    { \
+        ECDSAVerifyInputs(state, nInputs, nKeys); \
+    } \
+    BENCHMARK(ECDSAVerifyInputs_##nInputs##_##nKeys)
+
 BENCHMARK(ECDSASign)
 BENCHMARK(ECDSAVerify)
 BENCHMARK(ECDSAVerify_LargeBlock)
+
+BENCH_ECDSAVerifyInputs(100, 1)
+BENCH_ECDSAVerifyInputs(100, 100)
+BENCH_ECDSAVerifyInputs(500, 1)
+BENCH_ECDSAVerifyInputs(500, 500)
+BENCH_ECDSAVerifyInputs(2000, 1)
+BENCH_ECDSAVerifyInputs(2000, 2000)
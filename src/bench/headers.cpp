@@ -0,0 +1,79 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chainparams.h"
+#include "pow.h"
+#include "random.h"
+#include "util.h"
+#include "validation.h"
+#include "arith_uint256.h"
+
+#include <boost/thread/thread.hpp>
+
+static const size_t HEADERS_BATCH = 2000; // MAX_HEADERS_RESULTS
+static const int FIRST_PREV_HEIGHT = 200000;
+static const int64_t FIRST_PREV_TIME = 1560000000;
+
+// A run of headers as in a full headers message, above the anti-GPU height and at the lowest difficulty, so that
+// each of them passes the full BibleHash check. Like in the HEADERS handler, their X11 hashes are memoized already.
+static std::vector<CBlockHeader> BuildHeaders(const Consensus::Params& params)
+{
+    std::vector<CBlockHeader> headers(HEADERS_BATCH);
+    uint256 hashPrev = GetRandHash();
+    int64_t nPrevTime = FIRST_PREV_TIME;
+    for (size_t i = 0; i < headers.size(); i++) {
+        CBlockHeader& header = headers[i];
+        header.nVersion = 0x20000000;
+        header.hashPrevBlock = hashPrev;
+        header.nTime = nPrevTime + 7 * 60;
+        header.nBits = UintToArith256(params.powLimit).GetCompact();
+        header.nNonce = 0;
+        do {
+            header.hashMerkleRoot = GetRandHash();
+        } while (!CheckProofOfWork(header.GetHash(), header.nBits, params, header.GetBlockTime(), nPrevTime, FIRST_PREV_HEIGHT + i, header.nNonce, NULL, false));
+        hashPrev = header.GetHash();
+        nPrevTime = header.GetBlockTime();
+    }
+    return headers;
+}
+
+// Proof of work checks of a headers message one after another, as AcceptBlockHeader did them under cs_main
+static void HeadersPoWSerial(benchmark::State& state)
+{
+    const Consensus::Params& params = Params(CBaseChainParams::MAIN).GetConsensus();
+    std::vector<CBlockHeader> headers = BuildHeaders(params);
+
+    // items per second is headers per second
+    state.SetItemsPerIteration(headers.size());
+    while (state.KeepRunning()) {
+        int64_t nPrevTime = FIRST_PREV_TIME;
+        for (size_t i = 0; i < headers.size(); i++) {
+            assert(CheckProofOfWork(headers[i].GetHash(), headers[i].nBits, params, headers[i].GetBlockTime(), nPrevTime, FIRST_PREV_HEIGHT + i, headers[i].nNonce, NULL, false));
+            nPrevTime = headers[i].GetBlockTime();
+        }
+    }
+}
+
+// The same checks through CheckHeadersPoW, on the calling thread and one header check thread per other core
+static void HeadersPoWParallel(benchmark::State& state)
+{
+    const Consensus::Params& params = Params(CBaseChainParams::MAIN).GetConsensus();
+    std::vector<CBlockHeader> headers = BuildHeaders(params);
+
+    boost::thread_group tg;
+    for (int i = 0; i < GetNumCores() - 1; i++) {
+        tg.create_thread(&ThreadHeaderPoWCheck);
+    }
+    state.SetItemsPerIteration(headers.size());
+    while (state.KeepRunning()) {
+        std::vector<CHeaderPoWPrecheck> vPrecheck(headers.size());
+        assert(CheckHeadersPoW(headers, FIRST_PREV_TIME, FIRST_PREV_HEIGHT, params, vPrecheck));
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(HeadersPoWSerial);
+BENCHMARK(HeadersPoWParallel);
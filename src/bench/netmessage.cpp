@@ -0,0 +1,92 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "hash.h"
+#include "net.h"
+#include "streams.h"
+
+#include "bench/data/block813851.raw.h"
+
+// Size of the chunks we get from a single recv() call
+static const size_t SOCKET_CHUNK_SIZE = 0x10000;
+
+// Builds a ~2 MB "block" message (header + payload) by repeating the transactions of the bench block
+static std::vector<char> BuildBlockMessage()
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    std::vector<CTransactionRef> vtx = block.vtx;
+    while (::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION) < 2 * 1000 * 1000) {
+        block.vtx.insert(block.vtx.end(), vtx.begin(), vtx.end());
+    }
+
+    CDataStream payload(SER_NETWORK, PROTOCOL_VERSION);
+    payload << block;
+
+    CMessageHeader hdr(Params(CBaseChainParams::MAIN).MessageStart(), NetMsgType::BLOCK, payload.size());
+    uint256 hash = Hash(payload.begin(), payload.end());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+
+    CDataStream msg(SER_NETWORK, PROTOCOL_VERSION);
+    msg << hdr;
+    msg.write(payload.data(), payload.size());
+    return std::vector<char>(msg.begin(), msg.end());
+}
+
+static void ReceiveBlockMessage(benchmark::State& state, bool fDirect)
+{
+    const std::vector<char> data = BuildBlockMessage();
+    const auto& messageStart = Params(CBaseChainParams::MAIN).MessageStart();
+    char pchBuf[SOCKET_CHUNK_SIZE];
+
+    while (state.KeepRunning()) {
+        CNetMessage msg(messageStart, SER_NETWORK, PROTOCOL_VERSION);
+        size_t nPos = 0;
+        while (!msg.complete()) {
+            size_t nChunk = std::min(SOCKET_CHUNK_SIZE, data.size() - nPos);
+            if (fDirect && msg.in_data) {
+                // recv() directly into the message
+                char* pchDest;
+                unsigned int nBytes = msg.prepareDirectRead(pchDest, nChunk);
+                memcpy(pchDest, &data[nPos], nBytes);
+                msg.commitDirectRead(nBytes);
+                nPos += nBytes;
+            } else {
+                // recv() into a temporary buffer which is then copied into the message
+                memcpy(pchBuf, &data[nPos], nChunk);
+                size_t nBufPos = 0;
+                while (nBufPos < nChunk) {
+                    int nHandled = msg.in_data ? msg.readData(pchBuf + nBufPos, nChunk - nBufPos) : msg.readHeader(pchBuf + nBufPos, nChunk - nBufPos);
+                    assert(nHandled > 0);
+                    nBufPos += nHandled;
+                }
+                nPos += nChunk;
+            }
+        }
+        assert(memcmp(msg.GetMessageHash().begin(), msg.hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) == 0);
+
+        CBlock block;
+        msg.vRecv >> block;
+    }
+}
+
+static void ReceiveBlockMessage_Copy(benchmark::State& state)
+{
+    ReceiveBlockMessage(state, false);
+}
+
+static void ReceiveBlockMessage_Direct(benchmark::State& state)
+{
+    ReceiveBlockMessage(state, true);
+}
+
+BENCHMARK(ReceiveBlockMessage_Copy);
+BENCHMARK(ReceiveBlockMessage_Direct);
@@ -47,7 +47,8 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
 
 
 
-ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
+ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn,
+                                              const std::vector<std::pair<uint256, CTransactionRef>>& retained_txn, CCriticalSection* retained_cs) {
     if (cmpctblock.header.IsNull() || (cmpctblock.shorttxids.empty() && cmpctblock.prefilledtxn.empty()))
         return READ_STATUS_INVALID;
     if (cmpctblock.shorttxids.size() + cmpctblock.prefilledtxn.size() > MaxBlockSize(true) / MIN_TRANSACTION_SIZE)
@@ -133,35 +134,50 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     }
     }
 
-    for (size_t i = 0; i < extra_txn.size(); i++) {
-        uint64_t shortid = cmpctblock.GetShortID(extra_txn[i].first);
-        std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
-        if (idit != shorttxids.end()) {
-            if (!have_txn[idit->second]) {
-                txn_available[idit->second] = extra_txn[i].second;
-                have_txn[idit->second]  = true;
-                mempool_count++;
-                extra_count++;
-            } else {
-                // If we find two mempool/extra txn that match the short id, just
-                // request it.
-                // This should be rare enough that the extra bandwidth doesn't matter,
-                // but eating a round-trip due to FillBlock failure would be annoying
-                // Note that we dont want duplication between extra_txn and mempool to
-                // trigger this case, so we compare hashes first
-                if (txn_available[idit->second] &&
-                        txn_available[idit->second]->GetHash() != extra_txn[i].second->GetHash()) {
-                    txn_available[idit->second].reset();
-                    mempool_count--;
-                    extra_count--;
+    {
+    LOCK(retained_cs);
+    for (const std::vector<std::pair<uint256, CTransactionRef>>* txn : {&extra_txn, &retained_txn}) {
+        if (mempool_count == shorttxids.size())
+            break;
+        for (size_t i = 0; i < txn->size(); i++) {
+            const std::pair<uint256, CTransactionRef>& extra = (*txn)[i];
+            if (!extra.second)
+                continue;
+            uint64_t shortid = cmpctblock.GetShortID(extra.first);
+            std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
+            if (idit != shorttxids.end()) {
+                if (!have_txn[idit->second]) {
+                    txn_available[idit->second] = extra.second;
+                    have_txn[idit->second]  = true;
+                    mempool_count++;
+                    if (txn == &retained_txn)
+                        retained_count++;
+                    else
+                        extra_count++;
+                } else {
+                    // If we find two mempool/extra txn that match the short id, just
+                    // request it.
+                    // This should be rare enough that the extra bandwidth doesn't matter,
+                    // but eating a round-trip due to FillBlock failure would be annoying
+                    // Note that we dont want duplication between extra_txn and mempool to
+                    // trigger this case, so we compare hashes first
+                    if (txn_available[idit->second] &&
+                            txn_available[idit->second]->GetHash() != extra.second->GetHash()) {
+                        txn_available[idit->second].reset();
+                        mempool_count--;
+                        size_t& pool_count = txn == &retained_txn ? retained_count : extra_count;
+                        if (pool_count)
+                            pool_count--;
+                    }
                 }
             }
+            // Though ideally we'd continue scanning for the two-txn-match-shortid case,
+            // the performance win of an early exit here is too good to pass up and worth
+            // the extra risk.
+            if (mempool_count == shorttxids.size())
+                break;
         }
-        // Though ideally we'd continue scanning for the two-txn-match-shortid case,
-        // the performance win of an early exit here is too good to pass up and worth
-        // the extra risk.
-        if (mempool_count == shorttxids.size())
-            break;
+    }
     }
 
 	if (fDebugSpam)
@@ -211,7 +227,7 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
     }
 
     if (fDebugSpam)
-		LogPrint("cmpctblock", "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool (incl at least %lu from extra pool) and %lu txn requested\n", hash.ToString(), prefilled_count, mempool_count, extra_count, vtx_missing.size());
+		LogPrint("cmpctblock", "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool (incl at least %lu from extra pool and %lu from retained pool) and %lu txn requested\n", hash.ToString(), prefilled_count, mempool_count, extra_count, retained_count, vtx_missing.size());
     if (vtx_missing.size() < 5) 
 	{
         for (const auto& tx : vtx_missing)
@@ -9,6 +9,7 @@
 
 #include <memory>
 
+class CCriticalSection;
 class CTxMemPool;
 
 // Dumb helper to handle CTransaction compression at serialize-time
@@ -194,15 +195,23 @@ public:
 class PartiallyDownloadedBlock {
 protected:
     std::vector<CTransactionRef> txn_available;
-    size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
+    size_t prefilled_count = 0, mempool_count = 0, extra_count = 0, retained_count = 0;
     CTxMemPool* pool;
 public:
     CBlockHeader header;
     PartiallyDownloadedBlock(CTxMemPool* poolIn) : pool(poolIn) {}
 
-    // extra_txn is a list of extra transactions to look at, in <hash, reference> form
-    ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
+    // extra_txn and retained_txn are lists of extra transactions to look at, in <hash, reference> form,
+    // retained_txn holding those expected to be mined (islocked and BiblePay special transactions).
+    // If retained_cs is given, it guards retained_txn and is only held once the mempool scan is done,
+    // as retained_txn is filled from mempool removal notifications (sent under pool->cs).
+    ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn,
+                        const std::vector<std::pair<uint256, CTransactionRef>>& retained_txn = std::vector<std::pair<uint256, CTransactionRef>>(),
+                        CCriticalSection* retained_cs = nullptr);
     bool IsTxAvailable(size_t index) const;
+    //! Transactions found locally (prefilled ones excluded), and how many of those came from retained_txn
+    size_t GetLocalCount() const { return mempool_count; }
+    size_t GetRetainedCount() const { return retained_count; }
     ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing);
 };
 
@@ -554,8 +554,52 @@ struct ContributionVerifier {
                 batchState.verifyResults.assign(batchState.count, 1);
                 HandleVerifyDone(batchIdx, batchState.count);
             } else {
-                // at least one entry in the batch is invalid, revert to per-contribution verification (but parallelized)
-                AsyncVerifyBatchOneByOne(batchIdx);
+                // at least one entry in the batch is invalid, bisect the batch so that we only need to verify the
+                // invalid entries and their direct neighbours individually (parallelized)
+                AsyncVerifyBisect(batchIdx, 0, batchState.count);
+            }
+        };
+        PushOrDoWork(std::move(f));
+    }
+
+    // Called when we know that the aggregation of the given range (relative to the batch) is invalid
+    void AsyncVerifyBisect(size_t batchIdx, size_t offset, size_t count)
+    {
+        if (count == 1) {
+            // aggregation of a single entry is the entry itself, so no need to verify it again
+            batchStates[batchIdx].verifyResults[offset] = 0;
+            HandleVerifyDone(batchIdx, 1);
+            return;
+        }
+
+        size_t half = count / 2;
+        AsyncVerifyRangeAggregated(batchIdx, offset, half);
+        AsyncVerifyRangeAggregated(batchIdx, offset + half, count - half);
+    }
+
+    void AsyncVerifyRangeAggregated(size_t batchIdx, size_t offset, size_t count)
+    {
+        auto f = [this, batchIdx, offset, count](int threadId) {
+            auto& batchState = batchStates[batchIdx];
+            size_t start = batchState.start + offset;
+
+            // ranges are small at this point, so aggregate them synchronously
+            auto vvec = std::make_shared<BLSVerificationVector>(*vvecs[start]);
+            CBLSSecretKey skShare = skShares[start];
+            for (size_t i = start + 1; i < start + count; i++) {
+                for (size_t j = 0; j < vvec->size(); j++) {
+                    (*vvec)[j].AggregateInsecure((*vvecs[i])[j]);
+                }
+                skShare.AggregateInsecure(skShares[i]);
+            }
+
+            if (Verify(vvec, skShare)) {
+                for (size_t i = 0; i < count; i++) {
+                    batchState.verifyResults[offset + i] = 1;
+                }
+                HandleVerifyDone(batchIdx, count);
+            } else {
+                AsyncVerifyBisect(batchIdx, offset, count);
             }
         };
         PushOrDoWork(std::move(f));
@@ -733,7 +777,12 @@ void CBLSWorker::AsyncVerifyContributionShares(const CBLSId& forId, const std::v
         return;
     }
 
-    auto verifier = new ContributionVerifier(forId, vvecs, skShares, 8, parallel, aggregated, workerPool, std::move(doneCallback));
+    // Use one aggregated batch per worker thread (but not smaller than 8 entries). As failed batches are bisected, large
+    // batches only cost a few more verifications when some entries are invalid, while the common case (all entries
+    // are valid) only needs a single verification per batch
+    size_t workerCount = (size_t)std::max(1, workerPool.size());
+    size_t batchSize = std::max((size_t)8, (vvecs.size() + workerCount - 1) / workerCount);
+    auto verifier = new ContributionVerifier(forId, vvecs, skShares, batchSize, parallel, aggregated, workerPool, std::move(doneCallback));
     verifier->Start();
 }
 
@@ -96,7 +96,7 @@ static CBlock FindDevNetGenesisBlock(const Consensus::Params& params, const CBlo
     for (uint32_t nNonce = 0; nNonce < UINT32_MAX; nNonce++) {
         block.nNonce = nNonce;
 
-        uint256 hash = block.GetHash();
+        uint256 hash = block.GetHashUncached();
         if (UintToArith256(hash) <= bnTarget)
             return block;
     }
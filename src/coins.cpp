@@ -8,7 +8,10 @@
 #include "memusage.h"
 #include "random.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <map>
+#include <vector>
 #include <boost/foreach.hpp>
 
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
@@ -16,6 +19,18 @@ uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) { return false; }
 CCoinsViewCursor *CCoinsView::Cursor() const { return 0; }
 
+bool CCoinsView::BatchWriteDirty(const CCoinsMap &mapCoins, const uint256 &hashBlock)
+{
+    // Views which consume what they are given get copies of the dirty entries
+    CCoinsMapMemoryResource mapDirtyMemoryResource;
+    CCoinsMap mapDirty(0, SaltedOutpointHasher(), std::equal_to<COutPoint>(), &mapDirtyMemoryResource);
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY)
+            mapDirty.insert(*it);
+    }
+    return BatchWrite(mapDirty, hashBlock);
+}
+
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
 {
     Coin coin;
@@ -28,12 +43,15 @@ bool CCoinsViewBacked::HaveCoin(const COutPoint &outpoint) const { return base->
 uint256 CCoinsViewBacked::GetBestBlock() const { return base->GetBestBlock(); }
 void CCoinsViewBacked::SetBackend(CCoinsView &viewIn) { base = &viewIn; }
 bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) { return base->BatchWrite(mapCoins, hashBlock); }
+bool CCoinsViewBacked::BatchWriteDirty(const CCoinsMap &mapCoins, const uint256 &hashBlock) { return base->BatchWriteDirty(mapCoins, hashBlock); }
 CCoinsViewCursor *CCoinsViewBacked::Cursor() const { return base->Cursor(); }
 size_t CCoinsViewBacked::EstimateSize() const { return base->EstimateSize(); }
 
 SaltedOutpointHasher::SaltedOutpointHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
 
-CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn), cachedCoinsUsage(0) {}
+CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn),
+    cacheCoins(0, SaltedOutpointHasher(), std::equal_to<COutPoint>(), &cacheCoinsMemoryResource),
+    cachedCoinsUsage(0), nAccessEpoch(0), nHits(0), nMisses(0), nEvicted(0) {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
     return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
@@ -41,12 +59,17 @@ size_t CCoinsViewCache::DynamicMemoryUsage() const {
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
-    if (it != cacheCoins.end())
+    if (it != cacheCoins.end()) {
+        nHits++;
+        it->second.nLastUsed = nAccessEpoch;
         return it;
+    }
+    nMisses++;
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
     CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    ret->second.nLastUsed = nAccessEpoch;
     if (ret->second.coin.IsSpent()) {
         // The parent only has an empty entry for this outpoint; we can consider our
         // version as fresh.
@@ -83,6 +106,7 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
     }
     it->second.coin = std::move(coin);
     it->second.flags |= CCoinsCacheEntry::DIRTY | (fresh ? CCoinsCacheEntry::FRESH : 0);
+    it->second.nLastUsed = nAccessEpoch;
     cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
 }
 
@@ -96,6 +120,16 @@ void AddCoins(CCoinsViewCache& cache, const CTransaction &tx, int nHeight) {
     }
 }
 
+void CCoinsViewCache::AddPrefetchedCoin(const COutPoint& outpoint, Coin&& coin) {
+    if (coin.IsSpent())
+        return;
+    std::pair<CCoinsMap::iterator, bool> ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(coin)));
+    if (ret.second) {
+        ret.first->second.nLastUsed = nAccessEpoch;
+        cachedCoinsUsage += ret.first->second.coin.DynamicMemoryUsage();
+    }
+}
+
 bool CCoinsViewCache::SpendCoin(const COutPoint &outpoint, Coin* moveout) {
     CCoinsMap::iterator it = FetchCoin(outpoint);
     if (it == cacheCoins.end()) return false;
@@ -141,6 +175,7 @@ uint256 CCoinsViewCache::GetBestBlock() const {
 
 void CCoinsViewCache::SetBestBlock(const uint256 &hashBlockIn) {
     hashBlock = hashBlockIn;
+    nAccessEpoch++;
 }
 
 bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn) {
@@ -157,6 +192,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                     entry.coin = std::move(it->second.coin);
                     cachedCoinsUsage += entry.coin.DynamicMemoryUsage();
                     entry.flags = CCoinsCacheEntry::DIRTY;
+                    entry.nLastUsed = nAccessEpoch;
                     // We can mark it FRESH in the parent if it was FRESH in the child
                     // Otherwise it might have just been flushed from the parent's cache
                     // and already exist in the grandparent
@@ -184,6 +220,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
                     itUs->second.coin = std::move(it->second.coin);
                     cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
                     itUs->second.flags |= CCoinsCacheEntry::DIRTY;
+                    itUs->second.nLastUsed = nAccessEpoch;
                     // NOTE: It is possible the child has a FRESH flag here in
                     // the event the entry we found in the parent is pruned. But
                     // we must not copy that FRESH flag to the parent as that
@@ -196,6 +233,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
         mapCoins.erase(itOld);
     }
     hashBlock = hashBlockIn;
+    nAccessEpoch++;
     return true;
 }
 
@@ -203,9 +241,133 @@ bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock);
     cacheCoins.clear();
     cachedCoinsUsage = 0;
+    ReallocateCache();
     return fOk;
 }
 
+bool CCoinsViewCache::FlushAndTrim(size_t nTargetUsage) {
+    // The entries stay cached, so the base view writes them from where they are
+    if (!base->BatchWriteDirty(cacheCoins, hashBlock))
+        return false;
+
+    // Everything is in the base view now: drop the pruned entries, keep the others as unmodified
+    // and sum up the memory held by the entries of each access epoch, including their bucket.
+    const size_t nNodeUsage = memusage::MallocUsage(sizeof(memusage::unordered_node<CCoinsMap::value_type>)) + sizeof(void*) * 2;
+    std::map<uint32_t, size_t> mapEpochUsage;
+    size_t nLiveUsage = 0;
+    for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+        if (it->second.coin.IsSpent()) {
+            cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+            it = cacheCoins.erase(it);
+            continue;
+        }
+        it->second.flags = 0;
+        mapEpochUsage[it->second.nLastUsed] += nNodeUsage + it->second.coin.DynamicMemoryUsage();
+        nLiveUsage += nNodeUsage + it->second.coin.DynamicMemoryUsage();
+        it++;
+    }
+
+    if (DynamicMemoryUsage() <= nTargetUsage)
+        return true;
+
+    // The pool only gives memory back by whole chunks, so the entries which stay are compacted into
+    // as few of them as they fit in at the end. Leave room for one that is partly used.
+    size_t nChunkUsage = memusage::MallocUsage(cacheCoinsMemoryResource.ChunkSizeBytes());
+    size_t nKeepUsage = nTargetUsage > nChunkUsage ? nTargetUsage - nChunkUsage : 0;
+    if (nLiveUsage > nKeepUsage) {
+        // Find the newest epoch that has to go; everything older is evicted completely and
+        // the entries of that epoch only until enough memory is freed.
+        size_t nExcess = nLiveUsage - nKeepUsage;
+        size_t nFreedOlder = 0;
+        uint32_t nCutoff = 0;
+        for (std::map<uint32_t, size_t>::const_iterator it = mapEpochUsage.begin(); it != mapEpochUsage.end(); it++) {
+            nCutoff = it->first;
+            if (nFreedOlder + it->second >= nExcess)
+                break;
+            nFreedOlder += it->second;
+        }
+        size_t nFreedCutoff = 0;
+        for (CCoinsMap::iterator it = cacheCoins.begin(); it != cacheCoins.end();) {
+            bool fEvict = it->second.nLastUsed < nCutoff;
+            if (it->second.nLastUsed == nCutoff && nFreedOlder + nFreedCutoff < nExcess) {
+                nFreedCutoff += nNodeUsage + it->second.coin.DynamicMemoryUsage();
+                fEvict = true;
+            }
+            if (fEvict) {
+                cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+                it = cacheCoins.erase(it);
+                nEvicted++;
+            } else {
+                it++;
+            }
+        }
+    }
+
+    CompactCache();
+    return true;
+}
+
+void CCoinsViewCache::CompactCache() {
+    // Keep the chunks of the pool holding the most entries, enough of them for all entries at the
+    // largest node size, and move the entries out of the other chunks into the free blocks of
+    // those. Unlike rebuilding the map, this never holds a second copy of the cache, only the keys
+    // of the entries which are moved.
+    CCoinsMapMemoryResource& resource = cacheCoinsMemoryResource;
+    // The bucket array of a map with so few buckets comes from the pool as well, from a chunk
+    // which cannot be told, and must not be freed with a retired one. Such a map is tiny anyway.
+    if (cacheCoins.bucket_count() * sizeof(void*) <= CCoinsMapMemoryResource::MAX_BLOCK_SIZE)
+        return;
+    resource.IndexChunks();
+    std::vector<size_t> vInUse(resource.NumAllocatedChunks(), 0);
+    for (CCoinsMap::const_iterator it = cacheCoins.begin(); it != cacheCoins.end(); it++) {
+        int nChunk = resource.ChunkIndex(&*it);
+        if (nChunk >= 0)
+            vInUse[nChunk]++;
+    }
+    std::vector<size_t> vByUse(vInUse.size());
+    for (size_t i = 0; i < vByUse.size(); i++)
+        vByUse[i] = i;
+    std::sort(vByUse.begin(), vByUse.end(), [&vInUse](size_t a, size_t b) { return vInUse[a] > vInUse[b]; });
+
+    const size_t nPerChunk = std::max<size_t>(1, resource.ChunkSizeBytes() / CCoinsMapMemoryResource::MAX_BLOCK_SIZE);
+    size_t nKeepChunks = (cacheCoins.size() + nPerChunk - 1) / nPerChunk;
+    std::vector<bool> vRetire(vInUse.size(), false);
+    bool fRetire = false;
+    for (size_t i = nKeepChunks; i < vByUse.size(); i++) {
+        vRetire[vByUse[i]] = true;
+        fRetire = true;
+    }
+    if (!fRetire) {
+        resource.ReleaseRetiredChunks();
+        return;
+    }
+    resource.RetireChunks(vRetire);
+
+    // Where a re-inserted entry ends up in the iteration order is up to the map, so the entries to
+    // move are looked up first. The map does not grow, so it is not rehashed in between.
+    std::vector<COutPoint> vMove;
+    for (CCoinsMap::const_iterator it = cacheCoins.begin(); it != cacheCoins.end(); it++) {
+        if (resource.IsRetired(&*it))
+            vMove.push_back(it->first);
+    }
+    for (const COutPoint& outpoint : vMove) {
+        CCoinsMap::iterator it = cacheCoins.find(outpoint);
+        CCoinsCacheEntry entry = std::move(it->second);
+        cacheCoins.erase(it);
+        cacheCoins.emplace(outpoint, std::move(entry));
+    }
+    resource.ReleaseRetiredChunks();
+    cacheCoins.rehash(0);
+}
+
+void CCoinsViewCache::ReallocateCache() {
+    assert(cacheCoins.empty());
+    cacheCoins.~CCoinsMap();
+    cacheCoinsMemoryResource.~CCoinsMapMemoryResource();
+    ::new (&cacheCoinsMemoryResource) CCoinsMapMemoryResource();
+    ::new (&cacheCoins) CCoinsMap(0, SaltedOutpointHasher(), std::equal_to<COutPoint>(), &cacheCoinsMemoryResource);
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -11,6 +11,7 @@
 #include "hash.h"
 #include "memusage.h"
 #include "serialize.h"
+#include "support/allocators/pool.h"
 #include "uint256.h"
 
 #include <assert.h>
@@ -102,6 +103,7 @@ struct CCoinsCacheEntry
 {
     Coin coin; // The actual cached data.
     unsigned char flags;
+    uint32_t nLastUsed; // Access epoch of the owning cache when this entry was last used, see CCoinsViewCache::FlushAndTrim.
 
     enum Flags {
         DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
@@ -113,11 +115,17 @@ struct CCoinsCacheEntry
          */
     };
 
-    CCoinsCacheEntry() : flags(0) {}
-    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
+    CCoinsCacheEntry() : flags(0), nLastUsed(0) {}
+    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0), nLastUsed(0) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/**
+ * The nodes of a CCoinsMap are allocated from a pool owned by the cache, which frees them all at once
+ * when the cache is emptied. A node holds the key, the entry, the link of the hash map and the cached hash.
+ */
+typedef PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>, sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4> CCoinsMapAllocator;
+typedef CCoinsMapAllocator::ResourceType CCoinsMapMemoryResource;
+typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher, std::equal_to<COutPoint>, CCoinsMapAllocator> CCoinsMap;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -160,6 +168,9 @@ public:
     //! The passed mapCoins can be modified.
     virtual bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock);
 
+    //! Like BatchWrite, but only reads the dirty entries of mapCoins and leaves the map as it is.
+    virtual bool BatchWriteDirty(const CCoinsMap &mapCoins, const uint256 &hashBlock);
+
     //! Get a cursor to iterate over the whole state
     virtual CCoinsViewCursor *Cursor() const;
 
@@ -184,6 +195,7 @@ public:
     uint256 GetBestBlock() const override;
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWriteDirty(const CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
     size_t EstimateSize() const override;
 };
@@ -198,11 +210,20 @@ protected:
      * declared as "const".  
      */
     mutable uint256 hashBlock;
+    mutable CCoinsMapMemoryResource cacheCoinsMemoryResource;
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    /* Advanced whenever a new best block is set, entries used since are tagged with it. */
+    uint32_t nAccessEpoch;
+
+    /* Lookups answered from this cache or from the base view, and entries dropped by FlushAndTrim. */
+    mutable uint64_t nHits;
+    mutable uint64_t nMisses;
+    uint64_t nEvicted;
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -241,6 +262,13 @@ public:
      */
     void AddCoin(const COutPoint& outpoint, Coin&& coin, bool potential_overwrite);
 
+    /**
+     * Add an unmodified coin that was read from the backing view ahead of its
+     * use, so that several such reads can be done in parallel. Has no effect
+     * if this cache already holds an entry for the outpoint.
+     */
+    void AddPrefetchedCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -255,6 +283,15 @@ public:
      */
     bool Flush();
 
+    /**
+     * Push the modifications applied to this cache to its base like Flush(), but
+     * keep the entries cached, now unmodified. Then drop the entries which were
+     * used longest ago until the cache takes at most nTargetUsage bytes, so that
+     * the hot part of the UTXO set does not have to be read back after a flush.
+     * If false is returned, the state of this cache (and its backing view) will be undefined.
+     */
+    bool FlushAndTrim(size_t nTargetUsage);
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -267,6 +304,13 @@ public:
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    //! Number of coin lookups answered from this cache, and from its base view
+    uint64_t GetHits() const { return nHits; }
+    uint64_t GetMisses() const { return nMisses; }
+
+    //! Number of unmodified entries dropped by FlushAndTrim
+    uint64_t GetEvicted() const { return nEvicted; }
+
     /** 
      * Amount of biblepay coming in to a transaction
      * Note that lightweight clients may not know anything besides the hash of previous transactions,
@@ -283,6 +327,12 @@ public:
 private:
     CCoinsMap::iterator FetchCoin(const COutPoint &outpoint) const;
 
+    //! Give the memory of the (empty) cache back to the system and start over with a new pool
+    void ReallocateCache();
+
+    //! Give back the chunks of the pool the entries do not need, by moving them into the others
+    void CompactCache();
+
     /**
      * By making the copy constructor private, we prevent accidentally using it when one intends to create a cache on top of a base cache.
      */
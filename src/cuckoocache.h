@@ -451,6 +451,23 @@ public:
             }
         return false;
     }
+
+    /** for_each_live calls f on every element which has not been erased,
+     * those of the old epoch before those of the current one, so that
+     * inserting them in this order into a new cache keeps their relative age.
+     *
+     * Requires no concurrent insert.
+     *
+     * @param f callable taking a const Element&
+     */
+    template <typename F>
+    void for_each_live(F f) const
+    {
+        for (bool epoch : {false, true})
+            for (uint32_t i = 0; i < size; ++i)
+                if (epoch_flags[i] == epoch && !collection_flags.bit_is_set(i))
+                    f(table[i]);
+    }
 };
 } // namespace CuckooCache
 
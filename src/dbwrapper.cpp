@@ -7,6 +7,8 @@
 #include "util.h"
 #include "random.h"
 
+#include "sync.h"
+
 #include <boost/filesystem.hpp>
 
 #include <leveldb/cache.h>
@@ -15,6 +17,12 @@
 #include <memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <set>
+#include <sstream>
+
+//! all open databases, for getdbstats
+static CCriticalSection cs_dbwrappers;
+static std::set<const CDBWrapper*> setDBWrappers;
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -73,12 +81,58 @@ public:
     }
 };
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+CDBWrapperOptions CDBWrapperOptions::FromCacheSize(size_t nCacheSize)
+{
+    CDBWrapperOptions dbOptions;
+    dbOptions.nBlockCacheSize = nCacheSize / 2;
+    dbOptions.nWriteBufferSize = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
+    return dbOptions;
+}
+
+/**
+ * -dbtune=<name>:<option>=<value>, where option is one of
+ *   blockcache=<MiB>, writebuffer=<MiB>, bloombits=<n> (0 disables the bloom filter), blocksize=<KiB>
+ */
+void CDBWrapperOptions::ApplyTuningArgs(const std::string& strName)
+{
+    if (!mapMultiArgs.count("-dbtune")) {
+        return;
+    }
+    for (const auto& strTune : mapMultiArgs.at("-dbtune")) {
+        size_t nColon = strTune.find(':');
+        size_t nEquals = strTune.find('=', nColon);
+        if (nColon == std::string::npos || nEquals == std::string::npos) {
+            LogPrintf("%s: ignoring invalid -dbtune=%s\n", __func__, strTune);
+            continue;
+        }
+        if (strTune.substr(0, nColon) != strName) {
+            continue;
+        }
+        std::string strOption = strTune.substr(nColon + 1, nEquals - nColon - 1);
+        int64_t nValue = atoi64(strTune.substr(nEquals + 1));
+        if (nValue < 0) {
+            LogPrintf("%s: ignoring invalid -dbtune=%s\n", __func__, strTune);
+        } else if (strOption == "blockcache") {
+            nBlockCacheSize = nValue << 20;
+        } else if (strOption == "writebuffer") {
+            nWriteBufferSize = std::max<int64_t>(nValue << 20, 64 << 10);
+        } else if (strOption == "bloombits") {
+            nBloomBits = (int)nValue;
+        } else if (strOption == "blocksize") {
+            nBlockSize = std::max<int64_t>(nValue << 10, 1 << 10);
+        } else {
+            LogPrintf("%s: ignoring unknown -dbtune option %s\n", __func__, strOption);
+        }
+    }
+}
+
+static leveldb::Options GetOptions(const CDBWrapperOptions& dbOptions)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    options.block_cache = leveldb::NewLRUCache(dbOptions.nBlockCacheSize);
+    options.write_buffer_size = dbOptions.nWriteBufferSize;
+    options.filter_policy = dbOptions.nBloomBits > 0 ? leveldb::NewBloomFilterPolicy(dbOptions.nBloomBits) : nullptr;
+    options.block_size = dbOptions.nBlockSize;
     options.compression = leveldb::kNoCompression;
     options.max_open_files = 64;
     options.info_log = new CBitcoinLevelDBLogger();
@@ -90,14 +144,23 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+CDBWrapper::CDBWrapper(const boost::filesystem::path& pathIn, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate) :
+    CDBWrapper(pathIn, CDBWrapperOptions::FromCacheSize(nCacheSize), fMemory, fWipe, obfuscate)
+{
+}
+
+CDBWrapper::CDBWrapper(const boost::filesystem::path& pathIn, const CDBWrapperOptions& dbOptionsIn, bool fMemory, bool fWipe, bool obfuscate) :
+    strName(fMemory ? "memory" : pathIn.filename().string()),
+    path(pathIn),
+    dbOptions(dbOptionsIn)
 {
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    dbOptions.ApplyTuningArgs(strName);
+    options = GetOptions(dbOptions);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -139,10 +202,19 @@ CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, b
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+    LogPrint("leveldb", "%s: block cache %d, write buffer %d, bloom bits %d, block size %d\n", strName,
+        dbOptions.nBlockCacheSize, dbOptions.nWriteBufferSize, dbOptions.nBloomBits, dbOptions.nBlockSize);
+
+    LOCK(cs_dbwrappers);
+    setDBWrappers.emplace(this);
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(cs_dbwrappers);
+        setDBWrappers.erase(this);
+    }
     delete pdb;
     pdb = NULL;
     delete options.filter_policy;
@@ -159,9 +231,57 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 {
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     dbwrapper_private::HandleError(status);
+    nBatches.fetch_add(1, std::memory_order_relaxed);
+    nBytesWritten.fetch_add(batch.SizeEstimate(), std::memory_order_relaxed);
     return true;
 }
 
+CDBWrapperStats CDBWrapper::GetStats() const
+{
+    CDBWrapperStats stats;
+    stats.strName = strName;
+    stats.strPath = path.string();
+    stats.options = dbOptions;
+    stats.nReads = nReads;
+    stats.nReadsFound = nReadsFound;
+    stats.nBytesRead = nBytesRead;
+    stats.nIterators = nIterators;
+    stats.nIteratorBytesRead = nIteratorBytesRead;
+    stats.nBatches = nBatches;
+    stats.nBytesWritten = nBytesWritten;
+
+    std::string strValue;
+    stats.nMemoryUsage = pdb->GetProperty("leveldb.approximate-memory-usage", &strValue) ? atoi64(strValue) : 0;
+
+    // "leveldb.stats" is a table with 3 header lines, followed by one line per non-empty level:
+    // Level Files Size(MB) Time(sec) Read(MB) Write(MB)
+    if (pdb->GetProperty("leveldb.stats", &strValue)) {
+        std::istringstream ss(strValue);
+        std::string strLine;
+        for (int i = 0; std::getline(ss, strLine); i++) {
+            if (i < 3) {
+                continue;
+            }
+            std::istringstream ssLine(strLine);
+            CDBWrapperStats::LevelStats level;
+            if (ssLine >> level.nLevel >> level.nFiles >> level.nSizeMB >> level.nCompactionTime >> level.nCompactionReadMB >> level.nCompactionWriteMB) {
+                stats.vecLevels.emplace_back(level);
+            }
+        }
+    }
+    return stats;
+}
+
+std::vector<CDBWrapperStats> GetDBWrapperStats()
+{
+    std::vector<CDBWrapperStats> vecStats;
+    LOCK(cs_dbwrappers);
+    for (const auto* pdbwrapper : setDBWrappers) {
+        vecStats.emplace_back(pdbwrapper->GetStats());
+    }
+    return vecStats;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -193,6 +313,7 @@ CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
 void CDBIterator::Next() { piter->Next(); }
+void CDBIterator::CountBytesRead(size_t nBytes) { parent.nIteratorBytesRead.fetch_add(nBytes, std::memory_order_relaxed); }
 
 namespace dbwrapper_private {
 
@@ -12,6 +12,7 @@
 #include "utilstrencodings.h"
 #include "version.h"
 
+#include <atomic>
 #include <typeindex>
 
 #include <boost/filesystem/path.hpp>
@@ -30,6 +31,51 @@ public:
 
 class CDBWrapper;
 
+/**
+ * Per-database LevelDB tuning. Defaults are derived from the cache size passed to CDBWrapper and can be
+ * overridden per database with -dbtune=<name>:<option>=<value>, see ApplyTuningArgs.
+ */
+struct CDBWrapperOptions
+{
+    size_t nBlockCacheSize{0};
+    size_t nWriteBufferSize{0};
+    //! bits per key of the bloom filter, 0 disables the filter
+    int nBloomBits{10};
+    //! approximate size of the blocks read from disk, larger blocks mean more read-ahead for scans
+    size_t nBlockSize{4096};
+
+    static CDBWrapperOptions FromCacheSize(size_t nCacheSize);
+    /** Applies all -dbtune options for the database with the given name */
+    void ApplyTuningArgs(const std::string& strName);
+};
+
+/** Usage counters and LevelDB internals of a single database, as returned by GetDBWrapperStats */
+struct CDBWrapperStats
+{
+    struct LevelStats {
+        int nLevel;
+        int nFiles;
+        double nSizeMB;
+        double nCompactionTime;
+        double nCompactionReadMB;
+        double nCompactionWriteMB;
+    };
+
+    std::string strName;
+    std::string strPath;
+    CDBWrapperOptions options;
+
+    uint64_t nReads;
+    uint64_t nReadsFound;
+    uint64_t nBytesRead;
+    uint64_t nIterators;
+    uint64_t nIteratorBytesRead;
+    uint64_t nBatches;
+    uint64_t nBytesWritten;
+    uint64_t nMemoryUsage;
+    std::vector<LevelStats> vecLevels;
+};
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private {
@@ -179,6 +225,7 @@ public:
 
     template<typename V> bool GetValue(V& value) {
         leveldb::Slice slValue = piter->value();
+        CountBytesRead(slValue.size());
         try {
             CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
             ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
@@ -193,12 +240,29 @@ public:
         return piter->value().size();
     }
 
+private:
+    void CountBytesRead(size_t nBytes);
 };
 
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
+    friend class CDBIterator;
 private:
+    //! name used for -dbtune and getdbstats (the name of the database directory)
+    std::string strName;
+    boost::filesystem::path path;
+    CDBWrapperOptions dbOptions;
+
+    //! usage counters, see CDBWrapperStats
+    mutable std::atomic<uint64_t> nReads{0};
+    mutable std::atomic<uint64_t> nReadsFound{0};
+    mutable std::atomic<uint64_t> nBytesRead{0};
+    mutable std::atomic<uint64_t> nIterators{0};
+    mutable std::atomic<uint64_t> nIteratorBytesRead{0};
+    std::atomic<uint64_t> nBatches{0};
+    std::atomic<uint64_t> nBytesWritten{0};
+
     //! custom environment this database is using (may be NULL in case of default environment)
     leveldb::Env* penv;
 
@@ -241,8 +305,16 @@ public:
      *                        with a zero'd byte array.
      */
     CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    /**
+     * @param[in] dbOptions   Explicit cache, write buffer, bloom filter and block size settings. -dbtune
+     *                        options for this database are applied on top of them.
+     */
+    CDBWrapper(const boost::filesystem::path& path, const CDBWrapperOptions& dbOptions, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
     ~CDBWrapper();
 
+    const std::string& GetName() const { return strName; }
+    CDBWrapperStats GetStats() const;
+
     template <typename K>
     bool ReadDataStream(const K& key, CDataStream& ssValue) const
     {
@@ -257,6 +329,7 @@ public:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 
         std::string strValue;
+        nReads.fetch_add(1, std::memory_order_relaxed);
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
@@ -264,6 +337,8 @@ public:
             LogPrintf("LevelDB read failure: %s\n", status.ToString());
             dbwrapper_private::HandleError(status);
         }
+        nReadsFound.fetch_add(1, std::memory_order_relaxed);
+        nBytesRead.fetch_add(strValue.size(), std::memory_order_relaxed);
         CDataStream ssValueTmp(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
         ssValueTmp.Xor(obfuscate_key);
         ssValue = std::move(ssValueTmp);
@@ -349,8 +424,13 @@ public:
         return WriteBatch(batch, true);
     }
 
+    /**
+     * Iterators are meant for scans and don't populate the block cache, so that scanning a large range
+     * doesn't evict the entries used by point lookups.
+     */
     CDBIterator *NewIterator()
     {
+        nIterators.fetch_add(1, std::memory_order_relaxed);
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
     }
 
@@ -398,6 +478,9 @@ public:
 
 };
 
+/** Returns stats of all currently open databases */
+std::vector<CDBWrapperStats> GetDBWrapperStats();
+
 template<typename CDBTransaction>
 class CDBTransactionIterator
 {
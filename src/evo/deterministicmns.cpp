@@ -259,18 +259,21 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t m
 {
     auto scores = CalculateScores(modifier);
 
+    // we only need the top maxSize entries, so there is no need to sort the whole list
+    size_t resultSize = std::min(maxSize, scores.size());
+
     // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+    std::partial_sort(scores.begin(), scores.begin() + resultSize, scores.end(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
         if (a.first == b.first) {
             // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
         }
-        return a.first < b.first;
+        return b.first < a.first;
     });
 
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(resultSize);
     for (size_t i = 0; i < result.size(); i++) {
         result[i] = std::move(scores[i].second);
     }
@@ -500,7 +503,8 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
 }
 
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
-    evoDb(_evoDb)
+    evoDb(_evoDb),
+    mnListsHistoricCache(HISTORIC_LISTS_CACHE_SIZE)
 {
 }
 
@@ -540,11 +544,15 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
         diff = oldList.BuildDiff(newList);
 
         evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
-        if ((nHeight % SNAPSHOT_LIST_PERIOD) == 0 || oldList.GetHeight() == -1) {
+        size_t nDiffSize = ::GetSerializeSize(diff, SER_DISK, CLIENT_VERSION);
+        if (ShouldWriteSnapshot(pindex, nDiffSize, oldList.GetHeight() == -1)) {
             evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
-            LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
-                __func__, nHeight, newList.GetAllMNsCount());
+            LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d, nDiffSizeSinceSnapshot=%d\n",
+                __func__, nHeight, newList.GetAllMNsCount(), nDiffSizeSinceSnapshot);
+            nLastSnapshotHeight = nHeight;
+            nDiffSizeSinceSnapshot = 0;
         }
+        snapshotStateBlockHash = newList.GetBlockHash();
     }
 
     // Don't hold cs while calling signals
@@ -590,6 +598,7 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
         evoDb.Erase(std::make_pair(DB_LIST_SNAPSHOT, blockHash));
 
         mnListsCache.erase(blockHash);
+        mnListsHistoricCache.erase(blockHash);
     }
 
     if (diff.HasChanges()) {
@@ -898,14 +907,12 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
 
     while (true) {
         // try using cache before reading from disk
-        auto it = mnListsCache.find(pindex->GetBlockHash());
-        if (it != mnListsCache.end()) {
-            snapshot = it->second;
+        if (GetCachedList(pindex->GetBlockHash(), snapshot)) {
             break;
         }
 
         if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            AddListToCache(snapshot);
             break;
         }
 
@@ -930,12 +937,58 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
             snapshot.SetHeight(diffIndex->nHeight);
         }
 
-        mnListsCache.emplace(diffIndex->GetBlockHash(), snapshot);
+        AddListToCache(snapshot);
     }
 
     return snapshot;
 }
 
+std::vector<CDeterministicMNList> CDeterministicMNManager::GetListsForBlockRange(const CBlockIndex* pindexStart, const CBlockIndex* pindexEnd)
+{
+    assert(pindexEnd->GetAncestor(pindexStart->nHeight) == pindexStart);
+
+    LOCK(cs);
+
+    std::vector<const CBlockIndex*> indexes;
+    indexes.reserve(pindexEnd->nHeight - pindexStart->nHeight);
+    for (auto pindex = pindexEnd; pindex != pindexStart; pindex = pindex->pprev) {
+        indexes.emplace_back(pindex);
+    }
+
+    std::vector<CDeterministicMNList> ret;
+    ret.reserve(indexes.size() + 1);
+    ret.emplace_back(GetListForBlock(pindexStart));
+
+    for (auto it = indexes.rbegin(); it != indexes.rend(); ++it) {
+        auto pindex = *it;
+        CDeterministicMNList list;
+        if (GetCachedList(pindex->GetBlockHash(), list)) {
+            ret.emplace_back(std::move(list));
+            continue;
+        }
+
+        CDeterministicMNListDiff diff;
+        if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
+            // no diff means that we're before DIP3, so fall back to the slow path (which will return an empty list)
+            ret.emplace_back(GetListForBlock(pindex));
+            continue;
+        }
+
+        // the new list shares all unchanged entries with the previous one
+        list = ret.back();
+        if (diff.HasChanges()) {
+            list = list.ApplyDiff(pindex, diff);
+        } else {
+            list.SetBlockHash(pindex->GetBlockHash());
+            list.SetHeight(pindex->nHeight);
+        }
+        AddListToCache(list);
+        ret.emplace_back(std::move(list));
+    }
+
+    return ret;
+}
+
 CDeterministicMNList CDeterministicMNManager::GetListAtChainTip()
 {
     LOCK(cs);
@@ -978,6 +1031,68 @@ bool CDeterministicMNManager::IsDIP3Enforced(int nHeight)
     return nHeight >= Params().GetConsensus().DIP0003EnforcementHeight;
 }
 
+bool CDeterministicMNManager::GetCachedList(const uint256& blockHash, CDeterministicMNList& listRet)
+{
+    AssertLockHeld(cs);
+
+    auto it = mnListsCache.find(blockHash);
+    if (it != mnListsCache.end()) {
+        listRet = it->second;
+        return true;
+    }
+    return mnListsHistoricCache.get(blockHash, listRet);
+}
+
+void CDeterministicMNManager::AddListToCache(const CDeterministicMNList& list)
+{
+    AssertLockHeld(cs);
+
+    // lists close to the tip are needed for block processing, so they are kept until CleanupCache removes them.
+    // Everything older only goes into the LRU cache to not let historical lookups grow mnListsCache unbounded
+    if (tipIndex && list.GetHeight() + LISTS_CACHE_SIZE < tipIndex->nHeight) {
+        // bound the LRU cache by bytes as well. Lists share most of their entries, but count each one in full as
+        // the cache may hold lists far apart from each other. The cache grows to twice its size before truncating
+        size_t nListUsage = std::max<size_t>(1, list.GetAllMNsCount() * LIST_ENTRY_USAGE_ESTIMATE);
+        mnListsHistoricCache.set_max_size(std::max<size_t>(1, std::min(HISTORIC_LISTS_CACHE_SIZE, HISTORIC_LISTS_CACHE_MAX_BYTES / 2 / nListUsage)));
+        mnListsHistoricCache.insert(list.GetBlockHash(), list);
+    } else {
+        mnListsCache.emplace(list.GetBlockHash(), list);
+    }
+}
+
+bool CDeterministicMNManager::ShouldWriteSnapshot(const CBlockIndex* pindex, size_t nDiffSize, bool fNoPrevList)
+{
+    AssertLockHeld(cs);
+
+    if (fNoPrevList) {
+        return true;
+    }
+
+    if (pindex->pprev->GetBlockHash() != snapshotStateBlockHash) {
+        nLastSnapshotHeight = -1;
+    }
+    if (nLastSnapshotHeight == -1) {
+        // we don't know when the last snapshot was written (after a restart, a reorg or a block which failed to connect),
+        // so look for it. If there is none within SNAPSHOT_LIST_MAX_PERIOD blocks, write one now to never replay more
+        // diffs than that on lookups
+        nDiffSizeSinceSnapshot = 0;
+        const CBlockIndex* pindexSnapshot = pindex->pprev;
+        for (int i = 1; i < SNAPSHOT_LIST_MAX_PERIOD && pindexSnapshot; i++, pindexSnapshot = pindexSnapshot->pprev) {
+            if (evoDb.Exists(std::make_pair(DB_LIST_SNAPSHOT, pindexSnapshot->GetBlockHash()))) {
+                nLastSnapshotHeight = pindexSnapshot->nHeight;
+                break;
+            }
+        }
+        if (nLastSnapshotHeight == -1) {
+            return true;
+        }
+    }
+
+    nDiffSizeSinceSnapshot += nDiffSize;
+    return nDiffSizeSinceSnapshot >= SNAPSHOT_DIFF_SIZE_THRESHOLD ||
+           pindex->nHeight - nLastSnapshotHeight >= SNAPSHOT_LIST_MAX_PERIOD;
+}
+
 void CDeterministicMNManager::CleanupCache(int nHeight)
 {
     AssertLockHeld(cs);
@@ -10,8 +10,10 @@
 #include "dbwrapper.h"
 #include "evodb.h"
 #include "providertx.h"
+#include "saltedhasher.h"
 #include "simplifiedmns.h"
 #include "sync.h"
+#include "unordered_lru_cache.h"
 
 #include "immer/map.hpp"
 #include "immer/map_transient.hpp"
@@ -626,7 +628,18 @@ public:
 class CDeterministicMNManager
 {
     static const int SNAPSHOT_LIST_PERIOD = 205; // once per day
+    // Snapshots are written adaptively: as soon as the accumulated size of all diffs since the last snapshot exceeds
+    // SNAPSHOT_DIFF_SIZE_THRESHOLD, or at the latest after SNAPSHOT_LIST_MAX_PERIOD blocks. Lookups never replay more
+    // diffs than with the old fixed period, busy periods just get more snapshots
+    static const int SNAPSHOT_LIST_MAX_PERIOD = SNAPSHOT_LIST_PERIOD;
+    static const size_t SNAPSHOT_DIFF_SIZE_THRESHOLD = 256 * 1024;
     static const int LISTS_CACHE_SIZE = 205;
+    // Lists older than LISTS_CACHE_SIZE blocks are kept in an LRU cache instead, so that repeated historical lookups
+    // (e.g. quorum member selection or "protx diff") don't need to replay diffs again
+    static const size_t HISTORIC_LISTS_CACHE_SIZE = 256;
+    static const size_t HISTORIC_LISTS_CACHE_MAX_BYTES = 64 * 1024 * 1024;
+    // rough memory usage of one list entry: the MN, its state and the nodes of the three immer maps
+    static const size_t LIST_ENTRY_USAGE_ESTIMATE = sizeof(CDeterministicMN) + sizeof(CDeterministicMNState) + 3 * 64;
 
 public:
     CCriticalSection cs;
@@ -635,8 +648,16 @@ private:
     CEvoDB& evoDb;
 
     std::map<uint256, CDeterministicMNList> mnListsCache;
+    unordered_lru_cache<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsHistoricCache;
     const CBlockIndex* tipIndex{nullptr};
 
+    // -1 means that we don't know when the last snapshot was written (e.g. after a restart or a reorg)
+    int nLastSnapshotHeight{-1};
+    size_t nDiffSizeSinceSnapshot{0};
+    // the block these two were last updated for. They are changed before the evodb transaction of that block commits,
+    // so they are only used for its child and looked up again otherwise (the block failed to connect or was undone)
+    uint256 snapshotStateBlockHash;
+
 public:
     CDeterministicMNManager(CEvoDB& _evoDb);
 
@@ -652,6 +673,9 @@ public:
 
     CDeterministicMNList GetListForBlock(const CBlockIndex* pindex);
     CDeterministicMNList GetListAtChainTip();
+    // Returns the lists for all blocks from pindexStart to pindexEnd (both inclusive, pindexStart must be an ancestor
+    // of pindexEnd). Only the first list is looked up, all others are built by applying diffs, sharing structure
+    std::vector<CDeterministicMNList> GetListsForBlockRange(const CBlockIndex* pindexStart, const CBlockIndex* pindexEnd);
 
     // Test if given TX is a ProRegTx which also contains the collateral at index n
     bool IsProTxWithCollateral(const CTransactionRef& tx, uint32_t n);
@@ -664,6 +688,9 @@ public:
     void UpgradeDBIfNeeded();
 
 private:
+    bool GetCachedList(const uint256& blockHash, CDeterministicMNList& listRet);
+    void AddListToCache(const CDeterministicMNList& list);
+    bool ShouldWriteSnapshot(const CBlockIndex* pindex, size_t nDiffSize, bool fNoPrevList);
     void CleanupCache(int nHeight);
 };
 
@@ -13,7 +13,87 @@
 
 #include <boost/filesystem.hpp>
 
-/** 
+#include <map>
+#include <set>
+
+/**
+ * Storage backends for CFlatDB.
+ *
+ * FLATDB_BACKEND_FILE keeps the whole object in a single checksummed file which is rewritten on every dump.
+ * FLATDB_BACKEND_LOG keeps <name>.log, an append-only log of content addressed chunks of the serialized object.
+ * A dump only appends the chunks which changed since earlier dumps, plus a small snapshot record listing the
+ * chunks of the object. The file is only rewritten when the log is compacted. Loading streams the chunks of
+ * the newest snapshot straight from disk and verifies them while deserializing.
+ */
+enum FlatDBBackend {
+    FLATDB_BACKEND_FILE,
+    FLATDB_BACKEND_LOG
+};
+
+/** Log is compacted once it grows beyond this multiple of the data referenced by the newest snapshot */
+static const int FLATDB_LOG_COMPACT_RATIO = 3;
+static const uint32_t FLATDB_LOG_VERSION = 2;
+/**
+ * The file backend streams the object from disk through a buffer of at most this size instead of reading the
+ * whole file first. It must hold the largest single read of the deserializer (vectors are read in 5MB blocks).
+ */
+static const uint64_t FLATDB_READ_BUFFER_SIZE = 8 * 1024 * 1024;
+
+/** Chunk boundaries are content defined, so inserting data only changes the chunks around it */
+static const uint32_t FLATDB_CHUNK_MIN_SIZE = 2 * 1024;
+static const uint32_t FLATDB_CHUNK_MAX_SIZE = 64 * 1024;
+static const uint64_t FLATDB_CHUNK_BOUNDARY_MASK = (8 * 1024) - 1; // 8KB average above the minimum
+
+/** Splits data into chunks with a gear rolling hash, returns the size of each chunk */
+inline std::vector<uint32_t> SplitFlatDBChunks(const char* pch, size_t nSize)
+{
+    static const std::vector<uint64_t> vGear = [] {
+        // any fixed table works, it only has to be the same on every run so that unchanged data gives the same chunks
+        std::vector<uint64_t> v(256);
+        uint64_t x = 0x9e3779b97f4a7c15ULL;
+        for (auto& g : v) {
+            x += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            g = z ^ (z >> 31);
+        }
+        return v;
+    }();
+
+    std::vector<uint32_t> vSizes;
+    size_t nStart = 0;
+    while (nStart < nSize) {
+        size_t nEnd = std::min(nSize, nStart + FLATDB_CHUNK_MAX_SIZE);
+        size_t nPos = std::min(nEnd, nStart + FLATDB_CHUNK_MIN_SIZE);
+        uint64_t h = 0;
+        for (; nPos < nEnd; nPos++) {
+            h = (h << 1) + vGear[(unsigned char)pch[nPos]];
+            if ((h & FLATDB_CHUNK_BOUNDARY_MASK) == 0) {
+                nPos++;
+                break;
+            }
+        }
+        vSizes.push_back(nPos - nStart);
+        nStart = nPos;
+    }
+    return vSizes;
+}
+
+/** Backend selected for the given store via -flatdblog=<file> (or -flatdblog=all) */
+inline FlatDBBackend GetFlatDBBackend(const std::string& strFilename)
+{
+    if (mapMultiArgs.count("-flatdblog")) {
+        for (const auto& strStore : mapMultiArgs.at("-flatdblog")) {
+            if (strStore == strFilename || strStore == "all" || strStore == "1") {
+                return FLATDB_BACKEND_LOG;
+            }
+        }
+    }
+    return FLATDB_BACKEND_FILE;
+}
+
+/**
 *   Generic Dumping and Loading
 *   ---------------------------
 */
@@ -33,9 +113,138 @@ private:
         IncorrectFormat
     };
 
+    enum LogRecordType : uint8_t {
+        LOG_RECORD_CHUNK = 1,
+        LOG_RECORD_SNAPSHOT = 2
+    };
+
+    struct LogRecord {
+        uint8_t nType;
+        long nOffset; // position of the payload
+        uint32_t nSize;
+        uint256 hash; // Hash(type | payload), which is also the id of a chunk
+    };
+
+    static uint256 HashLogRecord(uint8_t nType, const char* pch, size_t nSize)
+    {
+        uint256 hash;
+        CHash256().Write(&nType, 1).Write((const unsigned char*)pch, nSize).Finalize(hash.begin());
+        return hash;
+    }
+
+    /**
+     * Stream over the chunks of one snapshot in the log. Every chunk is hashed while it is read and compared to its id
+     * when the next one is started or Finish() is called, so the data is verified and deserialized in a single pass.
+     */
+    class CChunkReader
+    {
+    private:
+        FILE* file;
+        const std::vector<LogRecord>& vChunks;
+        size_t nNextChunk;
+        uint32_t nLeft;
+        CHash256 hasher;
+
+        void VerifyChunk()
+        {
+            uint256 hash;
+            hasher.Finalize(hash.begin());
+            if (hash != vChunks[nNextChunk - 1].hash)
+                throw std::ios_base::failure("CChunkReader: chunk checksum mismatch");
+        }
+
+        void NextChunk()
+        {
+            if (nNextChunk > 0)
+                VerifyChunk();
+            if (nNextChunk == vChunks.size())
+                throw std::ios_base::failure("CChunkReader: end of snapshot");
+            const LogRecord& chunk = vChunks[nNextChunk++];
+            if (fseek(file, chunk.nOffset, SEEK_SET) != 0)
+                throw std::ios_base::failure("CChunkReader: seek failed");
+            nLeft = chunk.nSize;
+            hasher.Reset().Write(&chunk.nType, 1);
+        }
+
+    public:
+        CChunkReader(FILE* fileIn, const std::vector<LogRecord>& vChunksIn) :
+            file(fileIn), vChunks(vChunksIn), nNextChunk(0), nLeft(0) {}
+
+        int GetType() const { return SER_DISK; }
+        int GetVersion() const { return CLIENT_VERSION; }
+
+        void read(char* pch, size_t nSize)
+        {
+            while (nSize > 0) {
+                if (nLeft == 0)
+                    NextChunk();
+                size_t nNow = std::min<size_t>(nSize, nLeft);
+                if (fread(pch, 1, nNow, file) != nNow)
+                    throw std::ios_base::failure("CChunkReader: end of file");
+                hasher.Write((const unsigned char*)pch, nNow);
+                pch += nNow;
+                nSize -= nNow;
+                nLeft -= nNow;
+            }
+        }
+
+        void ignore(size_t nSize)
+        {
+            char data[1024];
+            while (nSize > 0) {
+                size_t nNow = std::min<size_t>(nSize, sizeof(data));
+                read(data, nNow);
+                nSize -= nNow;
+            }
+        }
+
+        // the object must have used up the snapshot exactly
+        void Finish()
+        {
+            if (nLeft != 0 || nNextChunk != vChunks.size())
+                throw std::ios_base::failure("CChunkReader: snapshot size mismatch");
+            if (nNextChunk > 0)
+                VerifyChunk();
+        }
+
+        template<typename Obj>
+        CChunkReader& operator>>(Obj& obj)
+        {
+            ::Unserialize(*this, obj);
+            return *this;
+        }
+    };
+
     boost::filesystem::path pathDB;
+    boost::filesystem::path pathLog;
     std::string strFilename;
     std::string strMagicMessage;
+    FlatDBBackend backend;
+
+    // write to a temporary file first and move it over the old one once it is safely on disk
+    bool WriteFileAtomic(const boost::filesystem::path& path, const CDataStream& ssData)
+    {
+        boost::filesystem::path pathTmp = path;
+        pathTmp += ".new";
+
+        FILE *file = fopen(pathTmp.string().c_str(), "wb");
+        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+        if (fileout.IsNull())
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
+
+        try {
+            fileout.write(ssData.data(), ssData.size());
+        }
+        catch (std::exception &e) {
+            return error("%s: Serialize or I/O error - %s", __func__, e.what());
+        }
+        FileCommit(fileout.Get());
+        fileout.fclose();
+
+        if (!RenameOver(pathTmp, path))
+            return error("%s: Rename-into-place failed for %s", __func__, path.string());
+        return true;
+    }
 
     bool Write(const T& objToSave)
     {
@@ -51,20 +260,8 @@ private:
         uint256 hash = Hash(ssObj.begin(), ssObj.end());
         ssObj << hash;
 
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
-        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-        if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
-
-        // Write and commit header, data
-        try {
-            fileout << ssObj;
-        }
-        catch (std::exception &e) {
-            return error("%s: Serialize or I/O error - %s", __func__, e.what());
-        }
-        fileout.fclose();
+        if (!WriteFileAtomic(pathDB, ssObj))
+            return false;
 
         LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToSave.ToString());
@@ -86,95 +283,390 @@ private:
             return FileError;
         }
 
-        // use file size to size memory buffer
-        int fileSize = boost::filesystem::file_size(pathDB);
-        int dataSize = fileSize - sizeof(uint256);
-        // Don't try to resize to a negative number if file is small
-        if (dataSize < 0)
-            dataSize = 0;
-        std::vector<unsigned char> vchData;
-        vchData.resize(dataSize);
-        uint256 hashIn;
+        // stream the object straight from the file while hashing it, the checksum is the last 32 bytes
+        int64_t nDataSize = std::max<int64_t>(0, (int64_t)boost::filesystem::file_size(pathDB) - (int64_t)sizeof(uint256));
+        uint64_t nBufSize = std::max<uint64_t>(sizeof(uint256), std::min<uint64_t>(FLATDB_READ_BUFFER_SIZE, nDataSize + sizeof(uint256)));
+        CBufferedFile filebuf(filein.release(), nBufSize, 0, SER_DISK, CLIENT_VERSION);
+        filebuf.SetLimit(nDataSize);
+        CHashVerifier<CBufferedFile> verifier(&filebuf);
 
-        // read data and checksum from file
+        ReadResult result = Ok;
+        std::string strError;
         try {
-            filein.read((char *)&vchData[0], dataSize);
-            filein >> hashIn;
+            unsigned char pchMsgTmp[4];
+            std::string strMagicMessageTmp;
+            // de-serialize file header (file specific magic message) and ..
+            verifier >> strMagicMessageTmp;
+
+            // ... verify the message matches predefined one
+            if (strMagicMessage != strMagicMessageTmp)
+            {
+                result = IncorrectMagicMessage;
+            } else {
+                // de-serialize file header (network specific magic number) and ..
+                verifier >> FLATDATA(pchMsgTmp);
+
+                // ... verify the network matches ours
+                if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+                {
+                    result = IncorrectMagicNumber;
+                } else {
+                    // de-serialize data into T object
+                    verifier >> objToLoad;
+                }
+            }
+        }
+        catch (std::exception &e) {
+            result = IncorrectFormat;
+            strError = e.what();
+        }
+
+        // the checksum covers everything up to it, even what was not deserialized
+        uint256 hashIn;
+        try {
+            verifier.ignore(nDataSize - filebuf.GetPos());
+            filebuf.SetLimit();
+            filebuf >> hashIn;
         }
         catch (std::exception &e) {
+            objToLoad.Clear();
             error("%s: Deserialize or I/O error - %s", __func__, e.what());
             return HashReadError;
         }
-        filein.fclose();
-
-        CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
 
         // verify stored checksum matches input data
-        uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-        if (hashIn != hashTmp)
+        if (hashIn != verifier.GetHash())
         {
+            objToLoad.Clear();
             error("%s: Checksum mismatch, data corrupted", __func__);
             return IncorrectHash;
         }
 
+        if (result == IncorrectMagicMessage) {
+            error("%s: Invalid magic message", __func__);
+            return result;
+        }
+        if (result == IncorrectMagicNumber) {
+            error("%s: Invalid network magic number", __func__);
+            return result;
+        }
+        if (result == IncorrectFormat) {
+            objToLoad.Clear();
+            error("%s: Deserialize or I/O error - %s", __func__, strError);
+            return result;
+        }
 
-        unsigned char pchMsgTmp[4];
-        std::string strMagicMessageTmp;
-        try {
-            // de-serialize file header (file specific magic message) and ..
-            ssObj >> strMagicMessageTmp;
+        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToLoad.ToString());
+        if(!fDryRun) {
+            LogPrintf("%s: Cleaning....\n", __func__);
+            objToLoad.CheckAndRemove();
+            LogPrintf("     %s\n", objToLoad.ToString());
+        }
 
-            // ... verify the message matches predefined one
-            if (strMagicMessage != strMagicMessageTmp)
-            {
-                error("%s: Invalid magic message", __func__);
-                return IncorrectMagicMessage;
-            }
+        return Ok;
+    }
 
+    /**
+    *   Append-only log backend
+    *   -----------------------
+    *   header:  magic message | network magic | log version
+    *   records: type (uint8) | payload size (uint32) | payload | Hash(type | payload)
+    *
+    *   A chunk record holds a piece of the serialized object and is identified by its hash. A snapshot record
+    *   holds the size of the serialized object and the ids of its chunks, in order. A dump appends the chunks
+    *   which are not in the log yet and then a snapshot record, so a torn append only ever loses the newest
+    *   snapshot.
+    */
+
+    void SerializeLogHeader(CDataStream& ss) const
+    {
+        ss << strMagicMessage;
+        ss << FLATDATA(Params().MessageStart());
+        ss << FLATDB_LOG_VERSION;
+    }
 
-            // de-serialize file header (network specific magic number) and ..
-            ssObj >> FLATDATA(pchMsgTmp);
+    static void SerializeLogRecord(CDataStream& ss, uint8_t nType, const char* pch, uint32_t nSize, const uint256& hash)
+    {
+        ss << nType;
+        ss << nSize;
+        ss.write(pch, nSize);
+        ss << hash;
+    }
 
-            // ... verify the network matches ours
-            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
-            {
+    // Walks the record headers and checksums without reading any payload. fClean is set if the last record ends
+    // exactly at EOF.
+    ReadResult ScanLog(std::vector<LogRecord>& vRecords, bool& fClean)
+    {
+        vRecords.clear();
+        fClean = false;
+
+        FILE *file = fopen(pathLog.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return FileError;
+
+        int64_t nFileSize = boost::filesystem::file_size(pathLog);
+
+        try {
+            std::string strMagicMessageTmp;
+            unsigned char pchMsgTmp[4];
+            uint32_t nVersion;
+            filein >> strMagicMessageTmp;
+            if (strMagicMessage != strMagicMessageTmp) {
+                error("%s: Invalid magic message", __func__);
+                return IncorrectMagicMessage;
+            }
+            filein >> FLATDATA(pchMsgTmp);
+            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
                 error("%s: Invalid network magic number", __func__);
                 return IncorrectMagicNumber;
             }
-
-            // de-serialize data into T object
-            ssObj >> objToLoad;
+            filein >> nVersion;
+            if (nVersion != FLATDB_LOG_VERSION) {
+                error("%s: Unknown log version %d", __func__, nVersion);
+                return IncorrectFormat;
+            }
         }
         catch (std::exception &e) {
-            objToLoad.Clear();
             error("%s: Deserialize or I/O error - %s", __func__, e.what());
             return IncorrectFormat;
         }
 
-        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
-        LogPrintf("     %s\n", objToLoad.ToString());
-        if(!fDryRun) {
-            LogPrintf("%s: Cleaning....\n", __func__);
-            objToLoad.CheckAndRemove();
+        while (true) {
+            long nPos = ftell(filein.Get());
+            if (nPos == nFileSize) {
+                fClean = true;
+                break;
+            }
+            LogRecord record;
+            try {
+                filein >> record.nType;
+                filein >> record.nSize;
+            }
+            catch (std::exception &e) {
+                break;
+            }
+            record.nOffset = nPos + sizeof(record.nType) + sizeof(record.nSize);
+            if (record.nOffset + (int64_t)record.nSize + (int64_t)sizeof(uint256) > nFileSize)
+                break; // torn append
+            if (fseek(filein.Get(), record.nSize, SEEK_CUR) != 0)
+                break;
+            try {
+                filein >> record.hash;
+            }
+            catch (std::exception &e) {
+                break;
+            }
+            vRecords.push_back(record);
+        }
+        return Ok;
+    }
+
+    // Reads and verifies a snapshot record and looks up its chunks
+    bool ReadSnapshot(CAutoFile& filein, const LogRecord& record, const std::map<uint256, LogRecord>& mapChunks,
+                      std::vector<LogRecord>& vChunksRet)
+    {
+        std::vector<char> vchPayload(record.nSize);
+        uint64_t nObjSize = 0;
+        std::vector<uint256> vChunkIds;
+        try {
+            if (fseek(filein.Get(), record.nOffset, SEEK_SET) != 0)
+                return false;
+            filein.read(vchPayload.data(), vchPayload.size());
+            if (HashLogRecord(record.nType, vchPayload.data(), vchPayload.size()) != record.hash)
+                return false;
+            CDataStream ssSnapshot(vchPayload.data(), vchPayload.data() + vchPayload.size(), SER_DISK, CLIENT_VERSION);
+            ssSnapshot >> nObjSize;
+            ssSnapshot >> vChunkIds;
+        }
+        catch (std::exception &e) {
+            return false;
+        }
+
+        vChunksRet.clear();
+        uint64_t nChunksSize = 0;
+        for (const uint256& id : vChunkIds) {
+            auto it = mapChunks.find(id);
+            if (it == mapChunks.end())
+                return false;
+            vChunksRet.push_back(it->second);
+            nChunksSize += it->second.nSize;
+        }
+        return nChunksSize == nObjSize;
+    }
+
+    ReadResult ReadLog(T& objToLoad, bool fDryRun = false)
+    {
+        int64_t nStart = GetTimeMillis();
+
+        std::vector<LogRecord> vRecords;
+        bool fClean;
+        ReadResult result = ScanLog(vRecords, fClean);
+        if (result != Ok)
+            return result;
+        if (!fClean)
+            LogPrintf("%s: %s ends with an incomplete record, ignoring it\n", __func__, pathLog.filename().string());
+
+        FILE *file = fopen(pathLog.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull()) {
+            error("%s: Failed to open file %s", __func__, pathLog.string());
+            return FileError;
+        }
+
+        std::map<uint256, LogRecord> mapChunks;
+        int nSnapshots = 0;
+        for (const LogRecord& record : vRecords) {
+            if (record.nType == LOG_RECORD_CHUNK)
+                mapChunks.emplace(record.hash, record);
+            else if (record.nType == LOG_RECORD_SNAPSHOT)
+                nSnapshots++;
+        }
+        if (nSnapshots == 0) {
+            error("%s: No snapshots in %s", __func__, pathLog.string());
+            return IncorrectFormat;
+        }
+
+        // newest snapshot which reads back completely wins
+        int nSnapshot = nSnapshots + 1;
+        for (auto it = vRecords.rbegin(); it != vRecords.rend(); ++it) {
+            if (it->nType != LOG_RECORD_SNAPSHOT)
+                continue;
+            nSnapshot--;
+            std::vector<LogRecord> vChunks;
+            if (!ReadSnapshot(filein, *it, mapChunks, vChunks)) {
+                error("%s: Snapshot %d of %d at offset %d is corrupted or incomplete", __func__, nSnapshot, nSnapshots, it->nOffset);
+                continue;
+            }
+            try {
+                CChunkReader reader(filein.Get(), vChunks);
+                reader >> objToLoad;
+                reader.Finish();
+            }
+            catch (std::exception &e) {
+                objToLoad.Clear();
+                error("%s: Snapshot %d of %d: Deserialize or I/O error - %s", __func__, nSnapshot, nSnapshots, e.what());
+                continue;
+            }
+
+            LogPrintf("Loaded info from %s (snapshot %d of %d, %d chunks)  %dms\n", pathLog.filename().string(),
+                nSnapshot, nSnapshots, vChunks.size(), GetTimeMillis() - nStart);
             LogPrintf("     %s\n", objToLoad.ToString());
+            if(!fDryRun) {
+                LogPrintf("%s: Cleaning....\n", __func__);
+                objToLoad.CheckAndRemove();
+                LogPrintf("     %s\n", objToLoad.ToString());
+            }
+            return Ok;
         }
+        return IncorrectHash;
+    }
 
-        return Ok;
+    bool WriteLog(const T& objToSave)
+    {
+        int64_t nStart = GetTimeMillis();
+
+        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+        ssObj << objToSave;
+
+        std::vector<LogRecord> vRecords;
+        bool fClean = false;
+        bool fCompact = ScanLog(vRecords, fClean) != Ok || !fClean;
+        std::set<uint256> setStored;
+        for (const LogRecord& record : vRecords) {
+            if (record.nType == LOG_RECORD_CHUNK)
+                setStored.insert(record.hash);
+        }
+
+        // the new snapshot, the chunks missing from the log, and all of its chunks in case the log gets compacted
+        CDataStream ssNew(SER_DISK, CLIENT_VERSION);
+        CDataStream ssAll(SER_DISK, CLIENT_VERSION);
+        std::vector<uint256> vChunkIds;
+        std::set<uint256> setWritten;
+        size_t nPos = 0;
+        for (uint32_t nChunkSize : SplitFlatDBChunks(ssObj.data(), ssObj.size())) {
+            const char* pch = ssObj.data() + nPos;
+            nPos += nChunkSize;
+            uint256 id = HashLogRecord(LOG_RECORD_CHUNK, pch, nChunkSize);
+            vChunkIds.push_back(id);
+            if (!setWritten.insert(id).second)
+                continue;
+            SerializeLogRecord(ssAll, LOG_RECORD_CHUNK, pch, nChunkSize, id);
+            if (!setStored.count(id))
+                SerializeLogRecord(ssNew, LOG_RECORD_CHUNK, pch, nChunkSize, id);
+        }
+        CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+        ssSnapshot << (uint64_t)ssObj.size();
+        ssSnapshot << vChunkIds;
+        uint256 hashSnapshot = HashLogRecord(LOG_RECORD_SNAPSHOT, ssSnapshot.data(), ssSnapshot.size());
+        SerializeLogRecord(ssNew, LOG_RECORD_SNAPSHOT, ssSnapshot.data(), ssSnapshot.size(), hashSnapshot);
+        SerializeLogRecord(ssAll, LOG_RECORD_SNAPSHOT, ssSnapshot.data(), ssSnapshot.size(), hashSnapshot);
+
+        if (!fCompact) {
+            int64_t nLogSize = boost::filesystem::file_size(pathLog);
+            fCompact = nLogSize + (int64_t)ssNew.size() > FLATDB_LOG_COMPACT_RATIO * (int64_t)ssAll.size();
+        }
+
+        size_t nWritten;
+        if (fCompact) {
+            CDataStream ssLog(SER_DISK, CLIENT_VERSION);
+            SerializeLogHeader(ssLog);
+            ssLog.write(ssAll.data(), ssAll.size());
+            if (!WriteFileAtomic(pathLog, ssLog))
+                return false;
+            nWritten = ssLog.size();
+        } else {
+            FILE *file = fopen(pathLog.string().c_str(), "ab");
+            CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+            if (fileout.IsNull())
+                return error("%s: Failed to open file %s", __func__, pathLog.string());
+            try {
+                fileout.write(ssNew.data(), ssNew.size());
+            }
+            catch (std::exception &e) {
+                return error("%s: Serialize or I/O error - %s", __func__, e.what());
+            }
+            FileCommit(fileout.Get());
+            fileout.fclose();
+            nWritten = ssNew.size();
+        }
+
+        LogPrintf("Written info to %s (%s, %d of %d bytes)  %dms\n", pathLog.filename().string(),
+            fCompact ? "compacted" : "appended", nWritten, ssObj.size(), GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToSave.ToString());
+
+        return true;
     }
 
 
 public:
-    CFlatDB(std::string strFilenameIn, std::string strMagicMessageIn)
+    CFlatDB(std::string strFilenameIn, std::string strMagicMessageIn) :
+        CFlatDB(strFilenameIn, strMagicMessageIn, GetFlatDBBackend(strFilenameIn))
+    {
+    }
+
+    CFlatDB(std::string strFilenameIn, std::string strMagicMessageIn, FlatDBBackend backendIn)
     {
         pathDB = GetDataDir() / strFilenameIn;
+        pathLog = pathDB;
+        pathLog.replace_extension(".log");
         strFilename = strFilenameIn;
         strMagicMessage = strMagicMessageIn;
+        backend = backendIn;
     }
 
     bool Load(T& objToLoad)
     {
-        LogPrintf("Reading info from %s...\n", strFilename);
-        ReadResult readResult = Read(objToLoad);
+        ReadResult readResult;
+        if (backend == FLATDB_BACKEND_LOG && (boost::filesystem::exists(pathLog) || !boost::filesystem::exists(pathDB))) {
+            LogPrintf("Reading info from %s...\n", pathLog.filename().string());
+            readResult = ReadLog(objToLoad);
+        } else {
+            // FLATDB_BACKEND_LOG falls back to the old file once, when switching backends
+            LogPrintf("Reading info from %s...\n", strFilename);
+            readResult = Read(objToLoad);
+        }
         if (readResult == FileError)
             LogPrintf("Missing file %s, will try to recreate\n", strFilename);
         else if (readResult != Ok)
@@ -197,6 +689,18 @@ public:
     {
         int64_t nStart = GetTimeMillis();
 
+        if (backend == FLATDB_BACKEND_LOG) {
+            // no need to verify the old data first, records are checksummed individually and a
+            // broken log is replaced by compaction
+            LogPrintf("Writing info to %s...\n", pathLog.filename().string());
+            if (!WriteLog(objToSave))
+                return false;
+            if (boost::filesystem::exists(pathDB))
+                boost::filesystem::remove(pathDB);
+            LogPrintf("%s dump finished  %dms\n", pathLog.filename().string(), GetTimeMillis() - nStart);
+            return true;
+        }
+
         LogPrintf("Verifying %s format...\n", strFilename);
         T tmpObjToLoad;
         ReadResult readResult = Read(tmpObjToLoad, true);
@@ -217,7 +721,10 @@ public:
         }
 
         LogPrintf("Writing info to %s...\n", strFilename);
-        Write(objToSave);
+        if (Write(objToSave) && boost::filesystem::exists(pathLog)) {
+            // don't let a stale log shadow this file if the log backend is selected again later
+            boost::filesystem::remove(pathLog);
+        }
         LogPrintf("%s dump finished  %dms\n", strFilename, GetTimeMillis() - nStart);
 
         return true;
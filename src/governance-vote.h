@@ -67,8 +67,8 @@ private:
     int64_t nTime;
     std::vector<unsigned char> vchSig;
 
-    /** Memory only. */
-    const uint256 hash;
+    /** Memory only. Not const, so that votes can be stored in (sorted) vectors */
+    uint256 hash;
     void UpdateHash() const;
 
 public:
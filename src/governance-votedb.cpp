@@ -4,125 +4,104 @@
 
 #include "governance-votedb.h"
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
-    nMemoryVotes(0),
-    listVotes(),
-    mapVoteIndex()
+#include <algorithm>
+
+static bool CompareVoteHash(const CGovernanceVote& vote, const uint256& nHash)
 {
+    return vote.GetHash() < nHash;
 }
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) :
-    nMemoryVotes(other.nMemoryVotes),
-    listVotes(other.listVotes),
-    mapVoteIndex()
+CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
+    nMemoryVotes(0),
+    vecVotes()
 {
-    RebuildIndex();
 }
 
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
 {
     uint256 nHash = vote.GetHash();
+    vote_v_it it = std::lower_bound(vecVotes.begin(), vecVotes.end(), nHash, CompareVoteHash);
     // make sure to never add/update already known votes
-    if (HasVote(nHash))
+    if (it != vecVotes.end() && it->GetHash() == nHash)
         return;
-    listVotes.push_front(vote);
-    mapVoteIndex.emplace(nHash, listVotes.begin());
+    vecVotes.insert(it, vote);
     ++nMemoryVotes;
     RemoveOldVotes(vote);
 }
 
+CGovernanceObjectVoteFile::vote_v_cit CGovernanceObjectVoteFile::FindVote(const uint256& nHash) const
+{
+    vote_v_cit it = std::lower_bound(vecVotes.begin(), vecVotes.end(), nHash, CompareVoteHash);
+    if (it == vecVotes.end() || it->GetHash() != nHash) {
+        return vecVotes.end();
+    }
+    return it;
+}
+
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
 {
-    return mapVoteIndex.find(nHash) != mapVoteIndex.end();
+    return FindVote(nHash) != vecVotes.end();
 }
 
 bool CGovernanceObjectVoteFile::SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const
 {
-    vote_m_cit it = mapVoteIndex.find(nHash);
-    if (it == mapVoteIndex.end()) {
+    vote_v_cit it = FindVote(nHash);
+    if (it == vecVotes.end()) {
         return false;
     }
-    ss << *(it->second);
+    ss << *it;
     return true;
 }
 
-std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
-{
-    std::vector<CGovernanceVote> vecResult;
-    for (vote_l_cit it = listVotes.begin(); it != listVotes.end(); ++it) {
-        vecResult.push_back(*it);
-    }
-    return vecResult;
-}
-
 void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
-        }
-    }
+    vote_v_it itEnd = std::remove_if(vecVotes.begin(), vecVotes.end(), [&](const CGovernanceVote& vote) {
+        return vote.GetMasternodeOutpoint() == outpointMasternode;
+    });
+    nMemoryVotes -= std::distance(itEnd, vecVotes.end());
+    vecVotes.erase(itEnd, vecVotes.end());
 }
 
 std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal)
 {
     std::set<uint256> removedVotes;
 
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
-            if (!it->IsValid(useVotingKey)) {
-                removedVotes.emplace(it->GetHash());
-                --nMemoryVotes;
-                mapVoteIndex.erase(it->GetHash());
-                listVotes.erase(it++);
-                continue;
-            }
+    vote_v_it itEnd = std::remove_if(vecVotes.begin(), vecVotes.end(), [&](const CGovernanceVote& vote) {
+        if (vote.GetMasternodeOutpoint() != outpointMasternode) {
+            return false;
         }
-        ++it;
-    }
+        bool useVotingKey = fProposal && (vote.GetSignal() == VOTE_SIGNAL_FUNDING);
+        if (vote.IsValid(useVotingKey)) {
+            return false;
+        }
+        removedVotes.emplace(vote.GetHash());
+        return true;
+    });
+    nMemoryVotes -= std::distance(itEnd, vecVotes.end());
+    vecVotes.erase(itEnd, vecVotes.end());
 
     return removedVotes;
 }
 
 void CGovernanceObjectVoteFile::RemoveOldVotes(const CGovernanceVote& vote)
 {
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == vote.GetMasternodeOutpoint() // same masternode
-            && it->GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
-            && it->GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
-            && it->GetTimestamp() < vote.GetTimestamp()) // older than new vote
-        {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
-        }
-    }
+    vote_v_it itEnd = std::remove_if(vecVotes.begin(), vecVotes.end(), [&](const CGovernanceVote& other) {
+        return other.GetMasternodeOutpoint() == vote.GetMasternodeOutpoint() // same masternode
+            && other.GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
+            && other.GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
+            && other.GetTimestamp() < vote.GetTimestamp(); // older than new vote
+    });
+    nMemoryVotes -= std::distance(itEnd, vecVotes.end());
+    vecVotes.erase(itEnd, vecVotes.end());
 }
 
 void CGovernanceObjectVoteFile::RebuildIndex()
 {
-    mapVoteIndex.clear();
-    nMemoryVotes = 0;
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        CGovernanceVote& vote = *it;
-        uint256 nHash = vote.GetHash();
-        if (mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
-            mapVoteIndex[nHash] = it;
-            ++nMemoryVotes;
-            ++it;
-        } else {
-            listVotes.erase(it++);
-        }
-    }
+    std::sort(vecVotes.begin(), vecVotes.end(), [](const CGovernanceVote& a, const CGovernanceVote& b) {
+        return a.GetHash() < b.GetHash();
+    });
+    vecVotes.erase(std::unique(vecVotes.begin(), vecVotes.end(), [](const CGovernanceVote& a, const CGovernanceVote& b) {
+        return a.GetHash() == b.GetHash();
+    }), vecVotes.end());
+    nMemoryVotes = vecVotes.size();
 }
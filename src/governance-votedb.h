@@ -5,8 +5,8 @@
 #ifndef GOVERNANCE_VOTEDB_H
 #define GOVERNANCE_VOTEDB_H
 
-#include <list>
-#include <map>
+#include <set>
+#include <vector>
 
 #include "governance-vote.h"
 #include "serialize.h"
@@ -18,38 +18,31 @@
  * Recently received votes are held in memory until a maximum size is reached after
  * which older votes a flushed to a disk file.
  *
+ * Votes are kept in a single vector sorted by vote hash, so that lookups are binary
+ * searches and the votes of an object are stored contiguously.
+ *
  * Note: This is a stub implementation that doesn't limit the number of votes held
  * in memory and doesn't flush to disk.
  */
 class CGovernanceObjectVoteFile
 {
 public: // Types
-    typedef std::list<CGovernanceVote> vote_l_t;
-
-    typedef vote_l_t::iterator vote_l_it;
-
-    typedef vote_l_t::const_iterator vote_l_cit;
+    typedef std::vector<CGovernanceVote> vote_v_t;
 
-    typedef std::map<uint256, vote_l_it> vote_m_t;
+    typedef vote_v_t::iterator vote_v_it;
 
-    typedef vote_m_t::iterator vote_m_it;
-
-    typedef vote_m_t::const_iterator vote_m_cit;
+    typedef vote_v_t::const_iterator vote_v_cit;
 
 private:
     static const int MAX_MEMORY_VOTES = -1;
 
     int nMemoryVotes;
 
-    vote_l_t listVotes;
-
-    vote_m_t mapVoteIndex;
+    vote_v_t vecVotes;
 
 public:
     CGovernanceObjectVoteFile();
 
-    CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other);
-
     /**
      * Add a vote to the file
      */
@@ -70,7 +63,13 @@ public:
         return nMemoryVotes;
     }
 
-    std::vector<CGovernanceVote> GetVotes() const;
+    /**
+     * All votes, sorted by hash
+     */
+    const std::vector<CGovernanceVote>& GetVotes() const
+    {
+        return vecVotes;
+    }
 
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
     std::set<uint256> RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal);
@@ -80,17 +79,21 @@ public:
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
+        // a vector is serialized the same way as the std::list used in older versions
         READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
+        READWRITE(vecVotes);
         if (ser_action.ForRead()) {
             RebuildIndex();
         }
     }
 
 private:
+    vote_v_cit FindVote(const uint256& nHash) const;
+
     // Drop older votes for the same gobject from the same masternode
     void RemoveOldVotes(const CGovernanceVote& vote);
 
+    // Sorts the votes by hash and removes duplicates
     void RebuildIndex();
 };
 
@@ -135,10 +135,7 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
 
         uint256 nHash = govobj.GetHash();
 
-        {
-            LOCK(cs_main);
-            connman.RemoveAskFor(nHash);
-        }
+        connman.RemoveAskFor(nHash);
 
         if (pfrom->nVersion < MIN_GOVERNANCE_PEER_PROTO_VERSION) {
             LogPrint("gobject", "MNGOVERNANCEOBJECT -- peer=%d using obsolete version %i\n", pfrom->id, pfrom->nVersion);
@@ -227,10 +224,7 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
 
         uint256 nHash = vote.GetHash();
 
-        {
-            LOCK(cs_main);
-            connman.RemoveAskFor(nHash);
-        }
+        connman.RemoveAskFor(nHash);
 
         if (pfrom->nVersion < MIN_GOVERNANCE_PEER_PROTO_VERSION) {
             LogPrint("gobject", "MNGOVERNANCEOBJECTVOTE -- peer=%d using obsolete version %i\n", pfrom->id, pfrom->nVersion);
@@ -677,7 +671,8 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
         return;
     }
 
-    auto fileVotes = govobj.GetVoteFile();
+    // don't copy the vote file, it can be large
+    const auto& fileVotes = govobj.GetVoteFile();
 
     for (const auto& vote : fileVotes.GetVotes()) {
         uint256 nVoteHash = vote.GetHash();
@@ -1035,7 +1030,7 @@ void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nH
 
         if (pObj) {
             filter = CBloomFilter(Params().GetConsensus().nGovernanceFilterElements, GOVERNANCE_FILTER_FP_RATE, GetRandInt(999999), BLOOM_UPDATE_ALL);
-            std::vector<CGovernanceVote> vecVotes = pObj->GetVoteFile().GetVotes();
+            const std::vector<CGovernanceVote>& vecVotes = pObj->GetVoteFile().GetVotes();
             nVoteCount = vecVotes.size();
             for (const auto& vote : vecVotes) {
                 filter.insert(vote.GetHash());
@@ -1137,7 +1132,7 @@ int CGovernanceManager::RequestGovernanceObjectVotes(const std::vector<CNode*>&
             // stop early to prevent setAskFor overflow
             {
                 LOCK(cs_main);
-                size_t nProjectedSize = pnode->setAskFor.size() + nProjectedVotes;
+                size_t nProjectedSize = pnode->GetAskForSize() + nProjectedVotes;
                 if (nProjectedSize > SETASKFOR_MAX_SZ / 2) continue;
                 // to early to ask the same node
                 if (mapAskedRecently[nHashGovobj].count(pnode->addr)) continue;
@@ -1195,7 +1190,7 @@ void CGovernanceManager::RebuildIndexes()
     cmapVoteToObject.Clear();
     for (auto& objPair : mapObjects) {
         CGovernanceObject& govobj = objPair.second;
-        std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
+        const std::vector<CGovernanceVote>& vecVotes = govobj.GetVoteFile().GetVotes();
         for (size_t i = 0; i < vecVotes.size(); ++i) {
             cmapVoteToObject.Insert(vecVotes[i].GetHash(), &govobj);
         }
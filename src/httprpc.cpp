@@ -24,6 +24,24 @@
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Only the start of a request body is scanned for method names when picking its work queue */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 64 * 1024;
+
+/** Cheap calls which are polled often and shouldn't wait behind long running ones */
+static const char* const rpcFastMethods[] = {
+    "getbestblockhash", "getblockcount", "getblockhash", "getblockheader", "getconnectioncount",
+    "getdifficulty", "getmempoolentry", "getmempoolinfo", "getnetworkinfo", "getrpcinfo", "ping",
+};
+
+/** Calls which may scan the chain, the indexes or all governance objects */
+static const char* const rpcSlowMethods[] = {
+    "exec", "getchaintips", "getgovernanceinfo", "gettxoutsetinfo", "gobject", "leaderboard",
+    "masternodelist", "protx", "verifychain",
+};
+
+//! Work queue per method, everything else goes to the default queue or, for wallet calls, the wallet queue
+static std::map<std::string, std::string> mapMethodQueues;
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -190,8 +208,23 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
+            // handlers may opt into sending large results as a chunked reply while they are generated
+            jreq.resultWriter = std::make_shared<CJSONStreamWriter>([req](const std::string& strChunk) {
+                if (!req->IsChunkedReplyStarted()) {
+                    req->WriteHeader("Content-Type", "application/json");
+                    req->StartChunkedReply(HTTP_OK);
+                }
+                return req->WriteReplyChunk(strChunk);
+            });
+
             UniValue result = tableRPC.execute(jreq);
 
+            if (jreq.IsResultStreamed()) {
+                jreq.FinishStreamedResult();
+                req->EndChunkedReply();
+                return true;
+            }
+
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
@@ -204,9 +237,20 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        if (req->IsChunkedReplyStarted()) {
+            // too late for an error reply, cut the response short so the client sees invalid JSON
+            LogPrintf("%s: %s failed after a part of its result was sent: %s\n", __func__, jreq.strMethod, objError.write());
+            req->EndChunkedReply();
+            return false;
+        }
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (req->IsChunkedReplyStarted()) {
+            LogPrintf("%s: %s failed after a part of its result was sent: %s\n", __func__, jreq.strMethod, e.what());
+            req->EndChunkedReply();
+            return false;
+        }
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
@@ -231,13 +275,90 @@ static bool InitRPCAuthentication()
     return true;
 }
 
+static void InitRPCMethodQueues()
+{
+    mapMethodQueues.clear();
+    for (const char* strMethod : rpcFastMethods) {
+        mapMethodQueues[strMethod] = HTTP_QUEUE_FAST;
+    }
+    for (const char* strMethod : rpcSlowMethods) {
+        mapMethodQueues[strMethod] = HTTP_QUEUE_SLOW;
+    }
+    for (const std::string& strMethod : tableRPC.listCommands()) {
+        const CRPCCommand* pcmd = tableRPC[strMethod];
+        if (pcmd->category == "wallet") {
+            mapMethodQueues[strMethod] = HTTP_QUEUE_WALLET;
+        } else if (pcmd->category == "addressindex") {
+            mapMethodQueues[strMethod] = HTTP_QUEUE_SLOW;
+        }
+    }
+    if (mapMultiArgs.count("-rpcmethodqueue")) {
+        for (const std::string& strArg : mapMultiArgs.at("-rpcmethodqueue")) {
+            size_t nColon = strArg.find(':');
+            if (nColon == std::string::npos) {
+                LogPrintf("%s: ignoring invalid -rpcmethodqueue=%s\n", __func__, strArg);
+                continue;
+            }
+            mapMethodQueues[strArg.substr(0, nColon)] = strArg.substr(nColon + 1);
+        }
+    }
+}
+
+/** Rank of a queue when a batch mixes methods of several queues, the batch goes to the slowest one */
+static int RPCQueueRank(const std::string& strQueue)
+{
+    if (strQueue == HTTP_QUEUE_FAST) return 0;
+    if (strQueue == HTTP_QUEUE_DEFAULT) return 1;
+    if (strQueue == HTTP_QUEUE_WALLET) return 2;
+    return 3;
+}
+
+/**
+ * Pick the work queue by the "method" members in the request, without parsing it as a whole as
+ * this runs on the event loop thread. Only registered methods are used as labels, so that clients
+ * can't make the statistics grow without bounds.
+ */
+static HTTPWorkClass ClassifyJSONRPC(HTTPRequest* req, const std::string&)
+{
+    HTTPWorkClass workClass;
+    std::string strBody = req->PeekBody(MAX_CLASSIFY_BODY_SIZE);
+    size_t nMethods = 0;
+    size_t nPos = 0;
+    while ((nPos = strBody.find("\"method\"", nPos)) != std::string::npos) {
+        nPos = strBody.find_first_not_of(" \t\r\n:", nPos + 8);
+        if (nPos == std::string::npos || strBody[nPos] != '"') {
+            continue;
+        }
+        size_t nEnd = strBody.find('"', nPos + 1);
+        if (nEnd == std::string::npos) {
+            break;
+        }
+        std::string strMethod = strBody.substr(nPos + 1, nEnd - nPos - 1);
+        nPos = nEnd + 1;
+        if (!tableRPC[strMethod]) {
+            continue;
+        }
+        auto it = mapMethodQueues.find(strMethod);
+        std::string strQueue = it != mapMethodQueues.end() ? it->second : HTTP_QUEUE_DEFAULT;
+        if (nMethods++ == 0 || RPCQueueRank(strQueue) > RPCQueueRank(workClass.queue)) {
+            workClass.queue = strQueue;
+        }
+        workClass.label = strMethod;
+    }
+    if (nMethods > 1) {
+        workClass.label = "batch";
+    }
+    return workClass;
+}
+
 bool StartHTTPRPC()
 {
     LogPrint("rpc", "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    InitRPCMethodQueues();
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, ClassifyJSONRPC);
 
     assert(EventBase());
     httpRPCTimerInterface = new HTTPRPCTimerInterface(EventBase());
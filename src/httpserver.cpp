@@ -11,6 +11,8 @@
 #include "rpc/protocol.h" // For HTTP status codes
 #include "sync.h"
 #include "ui_interface.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,12 +21,18 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <mutex>
+#include <set>
 
 #include <event2/event.h>
 #include <event2/http.h>
 #include <event2/thread.h>
 #include <event2/buffer.h>
+#include <event2/bufferevent.h>
 #include <event2/util.h>
 #include <event2/keyvalq_struct.h>
 
@@ -42,8 +50,8 @@ static const size_t MAX_HEADERS_SIZE = 8192;
 class HTTPWorkItem : public HTTPClosure
 {
 public:
-    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler& _func):
-        req(std::move(_req)), path(_path), func(_func)
+    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler& _func, const std::string& _label):
+        req(std::move(_req)), label(_label), nTimeQueued(GetTimeMicros()), path(_path), func(_func)
     {
     }
     void operator()() override
@@ -52,14 +60,38 @@ public:
     }
 
     std::unique_ptr<HTTPRequest> req;
+    //! requests with the same label share a concurrency limit and statistics
+    std::string label;
+    int64_t nTimeQueued;
 
 private:
     std::string path;
     HTTPRequestHandler func;
 };
 
+/** Per label counters, all times in microseconds */
+static std::mutex cs_workStats;
+static std::map<std::string, HTTPWorkLabelStats> mapWorkStats;
+
+static void RecordWorkStats(const std::string& label, bool fRejected, int64_t nWait = 0, int64_t nExec = 0)
+{
+    std::lock_guard<std::mutex> lock(cs_workStats);
+    HTTPWorkLabelStats& stats = mapWorkStats[label];
+    if (fRejected) {
+        stats.nRejected++;
+        return;
+    }
+    stats.nCount++;
+    stats.nWaitTotal += nWait;
+    stats.nWaitMax = std::max(stats.nWaitMax, nWait);
+    stats.nExecTotal += nExec;
+    stats.nExecMax = std::max(stats.nExecMax, nExec);
+}
+
 /** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+ * Work items are callable objects with a label and the time they were queued. At most
+ * mapLimits[label] items of the same label are run at once, further ones wait in the queue
+ * while items behind them can still be picked up by idle threads.
  */
 template <typename WorkItem>
 class WorkQueue
@@ -72,6 +104,22 @@ private:
     bool running;
     size_t maxDepth;
     int numThreads;
+    const std::map<std::string, int> mapLimits;
+    std::map<std::string, int> mapRunning;
+    uint64_t nRejected;
+
+    /** Find the first queued item which doesn't exceed the limit of its label */
+    typename std::deque<std::unique_ptr<WorkItem>>::iterator NextRunnable()
+    {
+        auto it = queue.begin();
+        for (; it != queue.end(); ++it) {
+            auto itLimit = mapLimits.find((*it)->label);
+            if (itLimit == mapLimits.end() || mapRunning[(*it)->label] < itLimit->second) {
+                break;
+            }
+        }
+        return it;
+    }
 
     /** RAII object to keep track of number of running worker threads */
     class ThreadCounter
@@ -92,9 +140,11 @@ private:
     };
 
 public:
-    WorkQueue(size_t _maxDepth) : running(true),
+    WorkQueue(size_t _maxDepth, const std::map<std::string, int>& _mapLimits) : running(true),
                                  maxDepth(_maxDepth),
-                                 numThreads(0)
+                                 numThreads(0),
+                                 mapLimits(_mapLimits),
+                                 nRejected(0)
     {
     }
     /** Precondition: worker threads have all stopped
@@ -108,6 +158,7 @@ public:
     {
         std::unique_lock<std::mutex> lock(cs);
         if (queue.size() >= maxDepth) {
+            nRejected++;
             return false;
         }
         queue.emplace_back(std::unique_ptr<WorkItem>(item));
@@ -122,14 +173,32 @@ public:
             std::unique_ptr<WorkItem> i;
             {
                 std::unique_lock<std::mutex> lock(cs);
-                while (running && queue.empty())
+                auto it = queue.end();
+                while (running && (it = NextRunnable()) == queue.end())
                     cond.wait(lock);
                 if (!running)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                i = std::move(*it);
+                queue.erase(it);
+                mapRunning[i->label]++;
             }
+            int64_t nTimeStart = GetTimeMicros();
+            std::string label = i->label;
+            int64_t nWait = nTimeStart - i->nTimeQueued;
             (*i)();
+            // the request is finished and not needed for the statistics anymore
+            i.reset();
+            RecordWorkStats(label, false, nWait, GetTimeMicros() - nTimeStart);
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                if (--mapRunning[label] == 0) {
+                    mapRunning.erase(label);
+                }
+                if (mapLimits.count(label)) {
+                    // items of this label which were held back may be runnable now
+                    cond.notify_all();
+                }
+            }
         }
     }
     /** Interrupt and exit loops */
@@ -154,18 +223,50 @@ public:
         std::unique_lock<std::mutex> lock(cs);
         return queue.size();
     }
+
+    void GetStats(HTTPWorkQueueStats& stats)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        stats.nMaxDepth = maxDepth;
+        stats.nDepth = queue.size();
+        stats.nRunning = 0;
+        for (const auto& p : mapRunning) {
+            stats.nRunning += p.second;
+        }
+        stats.nRejected = nRejected;
+    }
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
+};
+
+/** Work queue with its worker threads */
+struct HTTPWorkQueue
+{
+    std::string name;
+    int nThreads;
+    std::unique_ptr<WorkQueue<HTTPWorkItem>> queue;
+};
+
+/** Work queues besides the default one, with their default number of threads and depth */
+static const struct {
+    const char* name;
+    int nThreads;
+    int nDepth;
+} httpWorkQueueDefaults[] = {
+    {HTTP_QUEUE_FAST, 2, 64},
+    {HTTP_QUEUE_SLOW, 2, 16},
+    {HTTP_QUEUE_WALLET, 2, 16},
 };
 
 /** HTTP module state */
@@ -176,12 +277,16 @@ static struct event_base* eventBase = 0;
 struct evhttp* eventHTTP = 0;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure>* workQueue = 0;
+//! Work queues for handling longer requests off the event loop thread, the default queue comes first
+static std::vector<HTTPWorkQueue> workQueues;
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
 std::vector<evhttp_bound_socket *> boundSockets;
+//! Set on shutdown, chunked replies stop waiting for slow clients
+static std::atomic<bool> fHTTPInterrupted(false);
+
+static void FreePendingChunkedReplies();
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
@@ -285,12 +390,28 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
-        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
-        assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        HTTPWorkClass workClass;
+        if (i->classifier) {
+            workClass = i->classifier(hreq.get(), path);
+        }
+        if (workClass.label.empty()) {
+            workClass.label = i->prefix;
+        }
+        assert(!workQueues.empty());
+        // unknown or disabled queues fall back to the default one
+        HTTPWorkQueue* workQueue = &workQueues.front();
+        for (auto& wq : workQueues) {
+            if (wq.name == workClass.queue) {
+                workQueue = &wq;
+                break;
+            }
+        }
+        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler, workClass.label));
+        if (workQueue->queue->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: %s request rejected because the %s http work queue depth exceeded, it can be increased with the -rpcworkqueue= or -rpcqueue= settings\n", workClass.label, workQueue->name);
+            RecordWorkStats(workClass.label, true);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -356,12 +477,61 @@ static bool HTTPBindAddresses(struct evhttp* http)
 }
 
 /** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue)
+static void HTTPWorkQueueRun(WorkQueue<HTTPWorkItem>* queue, std::string name)
 {
-    RenameThread("biblepay-httpworker");
+    RenameThread(name == HTTP_QUEUE_DEFAULT ? "biblepay-httpworker" : strprintf("biblepay-http-%s", name).c_str());
     queue->Run();
 }
 
+/** Parse -rpcqueue=<queue>:<option>=<value> for one queue */
+static void ApplyWorkQueueArgs(const std::string& strName, int& nThreads, int& nDepth)
+{
+    if (!mapMultiArgs.count("-rpcqueue")) {
+        return;
+    }
+    for (const auto& strQueue : mapMultiArgs.at("-rpcqueue")) {
+        size_t nColon = strQueue.find(':');
+        size_t nEquals = strQueue.find('=', nColon);
+        if (nColon == std::string::npos || nEquals == std::string::npos) {
+            LogPrintf("%s: ignoring invalid -rpcqueue=%s\n", __func__, strQueue);
+            continue;
+        }
+        if (strQueue.substr(0, nColon) != strName) {
+            continue;
+        }
+        std::string strOption = strQueue.substr(nColon + 1, nEquals - nColon - 1);
+        int nValue = atoi(strQueue.substr(nEquals + 1));
+        if (nValue < 0) {
+            LogPrintf("%s: ignoring invalid -rpcqueue=%s\n", __func__, strQueue);
+        } else if (strOption == "threads") {
+            nThreads = nValue;
+        } else if (strOption == "depth") {
+            nDepth = std::max(nValue, 1);
+        } else {
+            LogPrintf("%s: ignoring unknown -rpcqueue option %s\n", __func__, strOption);
+        }
+    }
+}
+
+/** Parse -rpcmethodlimit=<method>:<n> */
+static std::map<std::string, int> GetWorkLimits()
+{
+    std::map<std::string, int> mapLimits;
+    if (!mapMultiArgs.count("-rpcmethodlimit")) {
+        return mapLimits;
+    }
+    for (const auto& strLimit : mapMultiArgs.at("-rpcmethodlimit")) {
+        size_t nColon = strLimit.find(':');
+        int nValue = nColon == std::string::npos ? 0 : atoi(strLimit.substr(nColon + 1));
+        if (nValue <= 0) {
+            LogPrintf("%s: ignoring invalid -rpcmethodlimit=%s\n", __func__, strLimit);
+            continue;
+        }
+        mapLimits[strLimit.substr(0, nColon)] = nValue;
+    }
+    return mapLimits;
+}
+
 /** libevent event log callback */
 static void libevent_log_cb(int severity, const char *msg)
 {
@@ -435,9 +605,23 @@ bool InitHTTPServer()
 
     LogPrint("http", "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
+    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    std::map<std::string, int> mapLimits = GetWorkLimits();
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    workQueues.clear();
+    workQueues.push_back(HTTPWorkQueue{HTTP_QUEUE_DEFAULT, rpcThreads, std::unique_ptr<WorkQueue<HTTPWorkItem>>(new WorkQueue<HTTPWorkItem>(workQueueDepth, mapLimits))});
+    for (const auto& defaults : httpWorkQueueDefaults) {
+        int nThreads = defaults.nThreads;
+        int nDepth = defaults.nDepth;
+        ApplyWorkQueueArgs(defaults.name, nThreads, nDepth);
+        if (nThreads == 0) {
+            LogPrintf("HTTP: %s work queue disabled, its requests go to the default queue\n", defaults.name);
+            continue;
+        }
+        LogPrintf("HTTP: creating %s work queue of depth %d\n", defaults.name, nDepth);
+        workQueues.push_back(HTTPWorkQueue{defaults.name, nThreads, std::unique_ptr<WorkQueue<HTTPWorkItem>>(new WorkQueue<HTTPWorkItem>(nDepth, mapLimits))});
+    }
     eventBase = base;
     eventHTTP = http;
     return true;
@@ -449,15 +633,17 @@ std::future<bool> threadResult;
 bool StartHTTPServer()
 {
     LogPrint("http", "Starting HTTP server\n");
-    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
+    fHTTPInterrupted = false;
     std::packaged_task<bool(event_base*, evhttp*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        std::thread rpc_worker(HTTPWorkQueueRun, workQueue);
-        rpc_worker.detach();
+    for (const auto& wq : workQueues) {
+        LogPrintf("HTTP: starting %d %s worker threads\n", wq.nThreads, wq.name);
+        for (int i = 0; i < wq.nThreads; i++) {
+            std::thread rpc_worker(HTTPWorkQueueRun, wq.queue.get(), wq.name);
+            rpc_worker.detach();
+        }
     }
     return true;
 }
@@ -465,30 +651,33 @@ bool StartHTTPServer()
 void InterruptHTTPServer()
 {
     LogPrint("http", "Interrupting HTTP server\n");
+    fHTTPInterrupted = true;
     if (eventHTTP) {
         // Unlisten sockets
         for (evhttp_bound_socket *socket : boundSockets) {
             evhttp_del_accept_socket(eventHTTP, socket);
         }
+        boundSockets.clear();
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, NULL);
     }
-    if (workQueue)
-        workQueue->Interrupt();
+    for (auto& wq : workQueues)
+        wq.queue->Interrupt();
 }
 
 void StopHTTPServer()
 {
     LogPrint("http", "Stopping HTTP server\n");
-    if (workQueue) {
+    if (!workQueues.empty()) {
         LogPrint("http", "Waiting for HTTP worker threads to exit\n");
 #ifndef WIN32
         // ToDo: Disabling WaitExit() for Windows platforms is an ugly workaround for the wallet not
         // closing during a repair-restart. It doesn't hurt, though, because threadHTTP.timed_join
         // below takes care of this and sends a loopbreak.
-        workQueue->WaitExit();
+        for (auto& wq : workQueues)
+            wq.queue->WaitExit();
 #endif        
-        delete workQueue;
+        workQueues.clear();
     }
     if (eventBase) {
         LogPrint("http", "Waiting for HTTP event thread to exit\n");
@@ -508,6 +697,8 @@ void StopHTTPServer()
         evhttp_free(eventHTTP);
         eventHTTP = 0;
     }
+    // replies still in progress when the event loop was stopped
+    FreePendingChunkedReplies();
     if (eventBase) {
         event_base_free(eventBase);
         eventBase = 0;
@@ -546,12 +737,97 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+/**
+ * State of a chunked reply, shared between the worker producing it and the event thread sending it.
+ * Everything is handed over through one event per reply: the worker queues chunks and triggers it, the event
+ * thread passes them to evhttp and reports back how much is still waiting to be sent to the client.
+ * It is created along with the request, so that a client going away is noticed before the reply starts.
+ */
+struct HTTPChunkedReply
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    //! chunks handed to the event thread, but not yet passed on to evhttp
+    std::deque<std::string> vChunks;
+    size_t nQueuedBytes{0};
+    //! bytes in the output buffer of the connection, as last seen by the event thread
+    size_t nOutputBytes{0};
+    //! the worker is blocked until the client has consumed some of the reply
+    bool fWaiting{false};
+    //! the worker is done, nothing is queued or triggered after this was set
+    bool fEndRequested{false};
+    //! set by the event thread when the connection was closed, req must not be used anymore
+    bool fClosed{false};
+    int nStatus{HTTP_OK};
+    //! only accessed from the event thread
+    bool fReplyStarted{false};
+    std::shared_ptr<HTTPChunkedReply>* pCloseCbArg{nullptr};
+    //! deletes itself once the end of the reply was processed, or is deleted by StopHTTPServer
+    HTTPEvent* ev{nullptr};
+};
+
+//! Chunked replies whose end was not processed yet, StopHTTPServer frees their events
+static std::mutex cs_activeChunkedReplies;
+static std::set<std::shared_ptr<HTTPChunkedReply>> setActiveChunkedReplies;
+
+static void http_chunked_reply_closecb(struct evhttp_connection*, void* arg)
+{
+    std::shared_ptr<HTTPChunkedReply>* pstate = (std::shared_ptr<HTTPChunkedReply>*)arg;
+    {
+        std::lock_guard<std::mutex> lock((*pstate)->cs);
+        (*pstate)->fClosed = true;
+    }
+    (*pstate)->cond.notify_all();
+    (*pstate)->pCloseCbArg = nullptr;
+    delete pstate;
+}
+
+// runs on the event thread when the reply was sent, the connection may be kept alive for other requests
+static void ClearChunkedReplyCloseCb(struct evhttp_request* req, HTTPChunkedReply& state)
+{
+    if (!state.pCloseCbArg)
+        return;
+    struct evhttp_connection* evcon = evhttp_request_get_connection(req);
+    if (evcon)
+        evhttp_connection_set_closecb(evcon, NULL, NULL);
+    delete state.pCloseCbArg;
+    state.pCloseCbArg = nullptr;
+}
+
+static void FreePendingChunkedReplies()
+{
+    std::lock_guard<std::mutex> lock(cs_activeChunkedReplies);
+    for (const std::shared_ptr<HTTPChunkedReply>& pstate : setActiveChunkedReplies) {
+        {
+            std::lock_guard<std::mutex> stateLock(pstate->cs);
+            delete pstate->ev;
+            pstate->ev = nullptr;
+            pstate->fClosed = true;
+        }
+        pstate->cond.notify_all();
+    }
+    setActiveChunkedReplies.clear();
+}
+
+
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       chunkedReplyStarted(false)
 {
+    // created on the event thread, where the close callback can be registered
+    chunkedReply = std::make_shared<HTTPChunkedReply>();
+    struct evhttp_connection* evcon = evhttp_request_get_connection(req);
+    if (evcon) {
+        chunkedReply->pCloseCbArg = new std::shared_ptr<HTTPChunkedReply>(chunkedReply);
+        evhttp_connection_set_closecb(evcon, http_chunked_reply_closecb, chunkedReply->pCloseCbArg);
+    }
 }
 HTTPRequest::~HTTPRequest()
 {
+    if (chunkedReplyStarted && req) {
+        // handler gave up in the middle of a chunked reply
+        EndChunkedReply();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -591,6 +867,19 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t nMaxSize)
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    std::string rv(std::min(evbuffer_get_length(buf), nMaxSize), '\0');
+    if (rv.empty())
+        return rv;
+    ev_ssize_t nCopied = evbuffer_copyout(buf, &rv[0], rv.size());
+    rv.resize(std::max<ev_ssize_t>(nCopied, 0));
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -610,13 +899,155 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
     evbuffer_add(evb, strReply.data(), strReply.size());
-    HTTPEvent* ev = new HTTPEvent(eventBase, true,
-        std::bind(evhttp_send_reply, req, nStatus, (const char*)NULL, (struct evbuffer *)NULL));
+    struct evhttp_request* _req = req;
+    std::shared_ptr<HTTPChunkedReply> state = chunkedReply;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [_req, nStatus, state]() {
+        ClearChunkedReplyCloseCb(_req, *state);
+        evhttp_send_reply(_req, nStatus, NULL, NULL);
+    });
     ev->trigger(0);
     replySent = true;
     req = 0; // transferred back to main thread
 }
 
+static size_t GetChunkedReplyOutputBytes(struct evhttp_request* req)
+{
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    struct evhttp_connection* evcon = evhttp_request_get_connection(req);
+    struct bufferevent* bev = evcon ? evhttp_connection_get_bufferevent(evcon) : nullptr;
+    if (bev) {
+        return evbuffer_get_length(bufferevent_get_output(bev));
+    }
+#endif
+    return 0;
+}
+
+// runs on the event thread whenever the worker queued something or waits for the client
+static void ProcessChunkedReply(struct evhttp_request* req, const std::shared_ptr<HTTPChunkedReply>& pstate)
+{
+    HTTPChunkedReply& state = *pstate;
+    std::deque<std::string> vChunks;
+    bool fEnd, fClosed;
+    {
+        std::lock_guard<std::mutex> lock(state.cs);
+        vChunks.swap(state.vChunks);
+        fEnd = state.fEndRequested;
+        fClosed = state.fClosed;
+    }
+
+    size_t nSent = 0;
+    size_t nOutputBytes = 0;
+    if (!fClosed) {
+        if (!state.fReplyStarted) {
+            evhttp_send_reply_start(req, state.nStatus, NULL);
+            state.fReplyStarted = true;
+        }
+        for (const std::string& chunk : vChunks) {
+            struct evbuffer* evb = evbuffer_new();
+            evbuffer_add(evb, chunk.data(), chunk.size());
+            evhttp_send_reply_chunk(req, evb);
+            evbuffer_free(evb);
+        }
+        if (fEnd) {
+            ClearChunkedReplyCloseCb(req, state);
+            evhttp_send_reply_end(req);
+        } else {
+            nOutputBytes = GetChunkedReplyOutputBytes(req);
+        }
+    } else if (fEnd) {
+        // evhttp detached the unfinished request from the closed connection, ending it frees it
+        evhttp_send_reply_end(req);
+    }
+    for (const std::string& chunk : vChunks) {
+        nSent += chunk.size();
+    }
+
+    bool fRetry;
+    {
+        std::lock_guard<std::mutex> lock(state.cs);
+        state.nQueuedBytes -= nSent;
+        state.nOutputBytes = nOutputBytes;
+        fRetry = !fEnd && !state.fClosed && state.fWaiting &&
+                 state.nQueuedBytes + state.nOutputBytes > HTTP_MAX_PENDING_REPLY_BYTES;
+    }
+    state.cond.notify_all();
+
+    if (fEnd) {
+        // the worker won't trigger the event anymore
+        std::lock_guard<std::mutex> lock(cs_activeChunkedReplies);
+        setActiveChunkedReplies.erase(pstate);
+        state.ev->deleteWhenTriggered = true;
+    } else if (fRetry) {
+        // libevent has no callback for a drained output buffer of an evhttp connection, look again shortly
+        struct timeval tv = {0, 10000};
+        state.ev->trigger(&tv);
+    }
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && req);
+    std::shared_ptr<HTTPChunkedReply> state = chunkedReply;
+    struct evhttp_request* _req = req;
+    {
+        std::lock_guard<std::mutex> lock(cs_activeChunkedReplies);
+        setActiveChunkedReplies.insert(state);
+    }
+    std::lock_guard<std::mutex> lock(state->cs);
+    state->nStatus = nStatus;
+    // the event keeps the state alive until the end of the reply was processed
+    state->ev = new HTTPEvent(eventBase, false, [_req, state]() {
+        ProcessChunkedReply(_req, state);
+    });
+    state->ev->trigger(0);
+    chunkedReplyStarted = true;
+    replySent = true;
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(chunkedReplyStarted && req);
+    HTTPChunkedReply& state = *chunkedReply;
+
+    std::unique_lock<std::mutex> lock(state.cs);
+    auto fCanWrite = [&state]() {
+        return state.fClosed || state.nQueuedBytes + state.nOutputBytes <= HTTP_MAX_PENDING_REPLY_BYTES;
+    };
+    if (!fCanWrite()) {
+        // ask the event thread to look at how much the client has consumed, it keeps looking until there is room
+        state.fWaiting = true;
+        if (state.ev)
+            state.ev->trigger(0);
+        while (!fCanWrite()) {
+            if (fHTTPInterrupted) {
+                state.fWaiting = false;
+                return false;
+            }
+            state.cond.wait_for(lock, std::chrono::seconds(1));
+        }
+        state.fWaiting = false;
+    }
+    if (state.fClosed) {
+        return false;
+    }
+    state.vChunks.push_back(strChunk);
+    state.nQueuedBytes += strChunk.size();
+    state.ev->trigger(0);
+    return true;
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(chunkedReplyStarted && req);
+    {
+        std::lock_guard<std::mutex> lock(chunkedReply->cs);
+        chunkedReply->fEndRequested = true;
+        if (chunkedReply->ev)
+            chunkedReply->ev->trigger(0);
+    }
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -657,10 +1088,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint("http", "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -677,3 +1108,21 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
     }
 }
 
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    std::vector<HTTPWorkQueueStats> vStats;
+    for (auto& wq : workQueues) {
+        HTTPWorkQueueStats stats;
+        stats.name = wq.name;
+        stats.nThreads = wq.nThreads;
+        wq.queue->GetStats(stats);
+        vStats.push_back(stats);
+    }
+    return vStats;
+}
+
+std::map<std::string, HTTPWorkLabelStats> GetHTTPWorkLabelStats()
+{
+    std::lock_guard<std::mutex> lock(cs_workStats);
+    return mapWorkStats;
+}
@@ -8,6 +8,9 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <map>
+#include <memory>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -32,13 +35,31 @@ void InterruptHTTPServer();
 /** Stop HTTP server */
 void StopHTTPServer();
 
+/** Work queues. Each has its own worker threads, so that slow requests can't starve the others */
+static const char* const HTTP_QUEUE_DEFAULT = "default";
+static const char* const HTTP_QUEUE_FAST = "fast";
+static const char* const HTTP_QUEUE_SLOW = "slow";
+static const char* const HTTP_QUEUE_WALLET = "wallet";
+
+/** Where a request is handled: the name of a work queue and a label (e.g. the RPC method),
+ * which is used for per-label concurrency limits (-rpcmethodlimit) and statistics.
+ * Unknown or disabled queues fall back to the default one, an empty label to the path prefix.
+ */
+struct HTTPWorkClass
+{
+    std::string queue{HTTP_QUEUE_DEFAULT};
+    std::string label;
+};
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Picks the work queue for a request. Called on the event loop thread, so it must be cheap. */
+typedef std::function<HTTPWorkClass(HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Without a classifier, requests go to the default work queue.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -47,6 +68,35 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+struct HTTPWorkQueueStats
+{
+    std::string name;
+    int nThreads;
+    size_t nMaxDepth;
+    size_t nDepth;
+    int nRunning;
+    uint64_t nRejected;
+};
+
+/** Counters per label since startup, times in microseconds */
+struct HTTPWorkLabelStats
+{
+    uint64_t nCount{0};
+    uint64_t nRejected{0};
+    int64_t nWaitTotal{0};
+    int64_t nWaitMax{0};
+    int64_t nExecTotal{0};
+    int64_t nExecMax{0};
+};
+
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+std::map<std::string, HTTPWorkLabelStats> GetHTTPWorkLabelStats();
+
+struct HTTPChunkedReply;
+
+/** Maximum number of reply bytes which may wait to be sent to the client before WriteReplyChunk blocks */
+static const size_t HTTP_MAX_PENDING_REPLY_BYTES = 1 << 20;
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -55,6 +105,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool chunkedReplyStarted;
+    std::shared_ptr<HTTPChunkedReply> chunkedReply;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -94,6 +146,11 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Copy up to nMaxSize bytes from the start of the request body without consuming it.
+     */
+    std::string PeekBody(size_t nMaxSize);
+
     /**
      * Write output header.
      *
@@ -110,6 +167,25 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply. The body is then sent piece by piece with WriteReplyChunk and the reply
+     * is finished with EndChunkedReply. This replaces WriteReply.
+     */
+    void StartChunkedReply(int nStatus);
+    bool IsChunkedReplyStarted() const { return chunkedReplyStarted; }
+
+    /**
+     * Send a part of the body of a chunked reply. Blocks while more than HTTP_MAX_PENDING_REPLY_BYTES wait
+     * to be sent to the client. Returns false if the client has gone away, in which case the rest of the
+     * reply should not be generated anymore.
+     */
+    bool WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * Finish a chunked reply. As with WriteReply, do not call any other HTTPRequest methods afterwards.
+     */
+    void EndChunkedReply();
 };
 
 /** Event handler closure.
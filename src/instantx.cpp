@@ -78,10 +78,7 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
 
         uint256 nVoteHash = vote.GetHash();
 
-        {
-            LOCK(cs_main);
-            connman.RemoveAskFor(nVoteHash);
-        }
+        connman.RemoveAskFor(nVoteHash);
 
         // Ignore any InstantSend messages until blockchain is synced
         if (!masternodeSync.IsBlockchainSynced()) return;
@@ -43,8 +43,16 @@ void CChainLocksHandler::Start()
     scheduler->scheduleEvery([&]() {
         CheckActiveState();
         EnforceBestChainLock();
-        // regularly retry signing the current chaintip as it might have failed before due to missing ixlocks
-        TrySignChainTip();
+        // New tips are signed as soon as UpdatedBlockTip is called. Here we only retry signing the current chaintip if
+        // the last attempt was deferred, e.g. due to missing ixlocks
+        bool retry;
+        {
+            LOCK(cs);
+            retry = trySignChainTipRetry;
+        }
+        if (retry) {
+            TrySignChainTip();
+        }
     }, 5000);
 }
 
@@ -90,10 +98,7 @@ void CChainLocksHandler::ProcessMessage(CNode* pfrom, const std::string& strComm
 
 void CChainLocksHandler::ProcessNewChainLock(NodeId from, const llmq::CChainLockSig& clsig, const uint256& hash)
 {
-    {
-        LOCK(cs_main);
-        g_connman->RemoveAskFor(hash);
-    }
+    g_connman->RemoveAskFor(hash);
 
     {
         LOCK(cs);
@@ -132,6 +137,11 @@ void CChainLocksHandler::ProcessNewChainLock(NodeId from, const llmq::CChainLock
         bestChainLockHash = hash;
         bestChainLock = clsig;
 
+        if (tipIndex && tipIndex->GetBlockHash() == clsig.blockHash) {
+            LogPrint("chainlocks", "CChainLocksHandler::%s -- CLSIG for tip %s arrived %.2fms after the block\n",
+                     __func__, clsig.blockHash.ToString(), (GetTimeMicros() - tipArrivalTime) * 0.001);
+        }
+
         CInv inv(MSG_CLSIG, hash);
         g_connman->RelayInv(inv, LLMQS_PROTO_VERSION);
 
@@ -191,6 +201,10 @@ void CChainLocksHandler::UpdatedBlockTip(const CBlockIndex* pindexNew)
     // never locked and TrySignChainTip is not called twice in parallel. Also avoids recursive calls due to
     // EnforceBestChainLock switching chains.
     LOCK(cs);
+    if (tipIndex != pindexNew) {
+        tipIndex = pindexNew;
+        tipArrivalTime = GetTimeMicros();
+    }
     if (tryLockChainTipScheduled) {
         return;
     }
@@ -234,20 +248,33 @@ void CChainLocksHandler::TrySignChainTip()
     Cleanup();
 
     if (!fMasternodeMode) {
+        LOCK(cs);
+        trySignChainTipRetry = false;
         return;
     }
 
     if (!masternodeSync.IsBlockchainSynced()) {
+        // retry once we're synced, the tip might not change again soon after that
+        LOCK(cs);
+        trySignChainTipRetry = true;
         return;
     }
 
     const CBlockIndex* pindex;
     {
+        LOCK(cs);
+        pindex = tipIndex;
+        // until proven otherwise, we assume that this attempt is final
+        trySignChainTipRetry = false;
+    }
+
+    if (!pindex) {
+        // UpdatedBlockTip was not called yet since we finished syncing
         LOCK(cs_main);
         pindex = chainActive.Tip();
     }
 
-    if (!pindex->pprev) {
+    if (!pindex || !pindex->pprev) {
         return;
     }
 
@@ -260,6 +287,8 @@ void CChainLocksHandler::TrySignChainTip()
         LOCK(cs);
 
         if (!isSporkActive) {
+            // retry later, the spork might get activated before the next block arrives
+            trySignChainTipRetry = true;
             return;
         }
 
@@ -320,6 +349,8 @@ void CChainLocksHandler::TrySignChainTip()
                 if (txAge < WAIT_FOR_ISLOCK_TIMEOUT && !quorumInstantSendManager->IsLocked(txid)) {
                     LogPrint("chainlocks", "CChainLocksHandler::%s -- not signing block %s due to TX %s not being ixlocked and not old enough. age=%d\n", __func__,
                               pindexWalk->GetBlockHash().ToString(), txid.ToString(), txAge);
+                    LOCK(cs);
+                    trySignChainTipRetry = true;
                     return;
                 }
             }
@@ -340,6 +371,11 @@ void CChainLocksHandler::TrySignChainTip()
         lastSignedHeight = pindex->nHeight;
         lastSignedRequestId = requestId;
         lastSignedMsgHash = msgHash;
+
+        if (pindex == tipIndex) {
+            LogPrint("chainlocks", "CChainLocksHandler::%s -- signing tip %s %.2fms after it arrived\n", __func__,
+                     msgHash.ToString(), (GetTimeMicros() - tipArrivalTime) * 0.001);
+        }
     }
 
     quorumSigningManager->AsyncSignIfMember(Params().GetConsensus().llmqChainLocks, requestId, msgHash);
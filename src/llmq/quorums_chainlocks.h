@@ -53,9 +53,16 @@ private:
     CScheduler* scheduler;
     CCriticalSection cs;
     bool tryLockChainTipScheduled{false};
+    // set when signing of the tip was deferred (e.g. due to missing ixlocks) and must be retried by the scheduler
+    bool trySignChainTipRetry{true};
     bool isSporkActive{false};
     bool isEnforced{false};
 
+    // tip as reported by UpdatedBlockTip. Used to avoid locking cs_main when deciding what to sign
+    const CBlockIndex* tipIndex{nullptr};
+    // time (in microseconds) when tipIndex arrived. Used to measure the latency from tip arrival to CLSIG
+    int64_t tipArrivalTime{0};
+
     uint256 bestChainLockHash;
     CChainLockSig bestChainLock;
 
@@ -101,6 +101,12 @@ UniValue CDKGDebugSessionStatus::ToJson(int detailLevel) const
     push(receivedJustifications, "receivedJustifications");
     push(receivedPrematureCommitments, "receivedPrematureCommitments");
 
+    UniValue phaseTimesJson(UniValue::VOBJ);
+    for (const auto& p : phaseTimes) {
+        phaseTimesJson.push_back(Pair(p.first, p.second));
+    }
+    ret.push_back(Pair("phaseTimes", phaseTimesJson));
+
     if (detailLevel == 2) {
         UniValue arr(UniValue::VARR);
         for (const auto& dmn : dmnMembers) {
@@ -174,6 +180,7 @@ void CDKGDebugManager::InitLocalSessionStatus(Consensus::LLMQType llmqType, cons
     session.statusBitset = 0;
     session.members.clear();
     session.members.resize((size_t)params.size);
+    session.phaseTimes.clear();
 }
 
 void CDKGDebugManager::UpdateLocalStatus(std::function<bool(CDKGDebugStatus& status)>&& func)
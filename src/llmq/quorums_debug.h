@@ -9,6 +9,7 @@
 #include "sync.h"
 #include "univalue.h"
 
+#include <map>
 #include <set>
 
 class CDataStream;
@@ -68,6 +69,9 @@ public:
 
     std::vector<CDKGDebugMemberStatus> members;
 
+    // time in milliseconds spent in local processing per phase (excludes idle time while waiting for the next phase)
+    std::map<std::string, int64_t> phaseTimes;
+
 public:
     CDKGDebugSessionStatus() : statusBitset(0) {}
 
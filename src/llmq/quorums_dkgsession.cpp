@@ -390,6 +390,7 @@ void CDKGSession::VerifyPendingContributions()
         if (!result[i]) {
             auto& m = members[memberIndexes[i]];
             logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
+            invalidSkContributions.emplace(m->idx, skContributions[i].GetHash());
             m->weComplain = true;
             quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, m->idx, [&](CDKGDebugMemberStatus& status) {
                 status.weComplain = true;
@@ -805,6 +806,14 @@ void CDKGSession::ReceiveMessage(const uint256& hash, const CDKGJustification& q
         auto& member2 = members[p.first];
         auto& skContribution = p.second;
 
+        if (AreWeMember() && member2->id == myId && invalidSkContributions.count(std::make_pair(member->idx, skContribution.GetHash()))) {
+            // he justified with the same contribution that we already decrypted and verified in the contribution phase
+            std::promise<bool> promise;
+            promise.set_value(false);
+            futures.emplace_back(promise.get_future());
+            continue;
+        }
+
         // watch out to not bail out before these async calls finish (they rely on valid references)
         futures.emplace_back(blsWorker.AsyncVerifyContributionShare(member2->id, receivedVvecs[member->idx], skContribution));
     }
@@ -279,6 +279,10 @@ private:
 
     std::vector<size_t> pendingContributionVerifications;
 
+    // (member index, hash) of decrypted SK contributions which we already found to be invalid. When the same
+    // contribution is later sent as justification, we can skip verifying it again
+    std::set<std::pair<size_t, uint256>> invalidSkContributions;
+
     // filled by ReceivePrematureCommitment and used by FinalizeCommitments
     std::set<uint256> validCommitments;
 
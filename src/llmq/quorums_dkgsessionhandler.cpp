@@ -17,6 +17,20 @@
 namespace llmq
 {
 
+static const char* GetPhaseName(QuorumPhase phase)
+{
+    switch (phase) {
+        case QuorumPhase_Initialized: return "initialized";
+        case QuorumPhase_Contribute: return "contribute";
+        case QuorumPhase_Complain: return "complain";
+        case QuorumPhase_Justify: return "justify";
+        case QuorumPhase_Commit: return "commit";
+        case QuorumPhase_Finalize: return "finalize";
+        case QuorumPhase_Idle: return "idle";
+        default: return "none";
+    }
+}
+
 CDKGPendingMessages::CDKGPendingMessages(size_t _maxMessagesPerNode) :
     maxMessagesPerNode(_maxMessagesPerNode)
 {
@@ -261,9 +275,29 @@ void CDKGSessionHandler::HandlePhase(QuorumPhase curPhase,
                                      const StartPhaseFunc& startPhaseFunc,
                                      const WhileWaitFunc& runWhileWaiting)
 {
-    SleepBeforePhase(curPhase, expectedQuorumHash, randomSleepFactor, runWhileWaiting);
+    // only measure the time spent in actual processing, not the time spent sleeping/waiting for blocks
+    int64_t nProcessingTime = 0;
+    auto runWhileWaitingTimed = [&]() {
+        int64_t nStart = GetTimeMillis();
+        bool ret = runWhileWaiting();
+        nProcessingTime += GetTimeMillis() - nStart;
+        return ret;
+    };
+
+    SleepBeforePhase(curPhase, expectedQuorumHash, randomSleepFactor, runWhileWaitingTimed);
+
+    int64_t nStart = GetTimeMillis();
     startPhaseFunc();
-    WaitForNextPhase(curPhase, nextPhase, expectedQuorumHash, runWhileWaiting);
+    nProcessingTime += GetTimeMillis() - nStart;
+
+    WaitForNextPhase(curPhase, nextPhase, expectedQuorumHash, runWhileWaitingTimed);
+
+    LogPrint("llmq-dkg", "CDKGSessionHandler::%s -- llmq=%s, phase=%s, processing time=%dms\n", __func__,
+             params.name, GetPhaseName(curPhase), nProcessingTime);
+    quorumDKGDebugManager->UpdateLocalSessionStatus(params.type, [&](CDKGDebugSessionStatus& status) {
+        status.phaseTimes[GetPhaseName(curPhase)] = nProcessingTime;
+        return true;
+    });
 }
 
 // returns a set of NodeIds which sent invalid messages
@@ -539,10 +573,16 @@ void CDKGSessionHandler::HandleDKGRound()
     };
     HandlePhase(QuorumPhase_Commit, QuorumPhase_Finalize, curQuorumHash, 0.1, fCommitStart, fCommitWait);
 
+    int64_t nFinalizeStart = GetTimeMillis();
     auto finalCommitments = curSession->FinalizeCommitments();
     for (const auto& fqc : finalCommitments) {
         quorumBlockProcessor->AddMinableCommitment(fqc);
     }
+    int64_t nFinalizeTime = GetTimeMillis() - nFinalizeStart;
+    quorumDKGDebugManager->UpdateLocalSessionStatus(params.type, [&](CDKGDebugSessionStatus& status) {
+        status.phaseTimes[GetPhaseName(QuorumPhase_Finalize)] = nFinalizeTime;
+        return true;
+    });
 }
 
 void CDKGSessionHandler::PhaseHandlerThread()
@@ -43,6 +43,61 @@ uint256 CInstantSendLock::GetRequestId() const
 
 ////////////////
 
+static std::tuple<std::string, uint32_t, uint256> BuildInversedISLockKey(const std::string& k, int nHeight, const uint256& islockHash)
+{
+    return std::make_tuple(k, htobe32(std::numeric_limits<uint32_t>::max() - nHeight), islockHash);
+}
+
+CInstantSendDb::CInstantSendDb(CDBWrapper& _db) :
+    db(_db)
+{
+    LoadIndex();
+}
+
+void CInstantSendDb::LoadIndex()
+{
+    auto it = std::unique_ptr<CDBIterator>(db.NewIterator());
+
+    auto txidKey = std::make_tuple(std::string("is_tx"), uint256());
+    it->Seek(txidKey);
+    while (it->Valid()) {
+        decltype(txidKey) curKey;
+        uint256 islockHash;
+        if (!it->GetKey(curKey) || std::get<0>(curKey) != "is_tx" || !it->GetValue(islockHash)) {
+            break;
+        }
+        txidIndex.emplace(std::get<1>(curKey), islockHash);
+        it->Next();
+    }
+
+    auto inputKey = std::make_tuple(std::string("is_in"), COutPoint());
+    it->Seek(inputKey);
+    while (it->Valid()) {
+        decltype(inputKey) curKey;
+        uint256 islockHash;
+        if (!it->GetKey(curKey) || std::get<0>(curKey) != "is_in" || !it->GetValue(islockHash)) {
+            break;
+        }
+        outpointIndex.emplace(std::get<1>(curKey), islockHash);
+        it->Next();
+    }
+
+    auto minedKey = BuildInversedISLockKey("is_m", std::numeric_limits<int>::max(), uint256());
+    it->Seek(minedKey);
+    while (it->Valid()) {
+        decltype(minedKey) curKey;
+        if (!it->GetKey(curKey) || std::get<0>(curKey) != "is_m") {
+            break;
+        }
+        int nHeight = (int)(std::numeric_limits<uint32_t>::max() - be32toh(std::get<1>(curKey)));
+        minedByHeight[nHeight].emplace(std::get<2>(curKey));
+        it->Next();
+    }
+
+    LogPrint("instantsend", "CInstantSendDb::%s -- loaded index. txids=%d, inputs=%d, mined heights=%d\n", __func__,
+             txidIndex.size(), outpointIndex.size(), minedByHeight.size());
+}
+
 void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock)
 {
     CDBBatch batch(db);
@@ -55,9 +110,9 @@ void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstant
 
     auto p = std::make_shared<CInstantSendLock>(islock);
     islockCache.insert(hash, p);
-    txidCache.insert(islock.txid, hash);
+    txidIndex[islock.txid] = hash;
     for (auto& in : islock.inputs) {
-        outpointCache.insert(in, hash);
+        outpointIndex[in] = hash;
     }
 }
 
@@ -77,25 +132,29 @@ void CInstantSendDb::RemoveInstantSendLock(CDBBatch& batch, const uint256& hash,
     }
 
     islockCache.erase(hash);
-    txidCache.erase(islock->txid);
+    txidIndex.erase(islock->txid);
     for (auto& in : islock->inputs) {
-        outpointCache.erase(in);
+        outpointIndex.erase(in);
     }
 }
 
-static std::tuple<std::string, uint32_t, uint256> BuildInversedISLockKey(const std::string& k, int nHeight, const uint256& islockHash)
-{
-    return std::make_tuple(k, htobe32(std::numeric_limits<uint32_t>::max() - nHeight), islockHash);
-}
-
 void CInstantSendDb::WriteInstantSendLockMined(const uint256& hash, int nHeight)
 {
     db.Write(BuildInversedISLockKey("is_m", nHeight, hash), true);
+    minedByHeight[nHeight].emplace(hash);
 }
 
 void CInstantSendDb::RemoveInstantSendLockMined(const uint256& hash, int nHeight)
 {
     db.Erase(BuildInversedISLockKey("is_m", nHeight, hash));
+
+    auto it = minedByHeight.find(nHeight);
+    if (it != minedByHeight.end()) {
+        it->second.erase(hash);
+        if (it->second.empty()) {
+            minedByHeight.erase(it);
+        }
+    }
 }
 
 void CInstantSendDb::WriteInstantSendLockArchived(CDBBatch& batch, const uint256& hash, int nHeight)
@@ -106,37 +165,26 @@ void CInstantSendDb::WriteInstantSendLockArchived(CDBBatch& batch, const uint256
 
 std::unordered_map<uint256, CInstantSendLockPtr> CInstantSendDb::RemoveConfirmedInstantSendLocks(int nUntilHeight)
 {
-    auto it = std::unique_ptr<CDBIterator>(db.NewIterator());
-
-    auto firstKey = BuildInversedISLockKey("is_m", nUntilHeight, uint256());
-
-    it->Seek(firstKey);
-
     CDBBatch batch(db);
     std::unordered_map<uint256, CInstantSendLockPtr> ret;
-    while (it->Valid()) {
-        decltype(firstKey) curKey;
-        if (!it->GetKey(curKey) || std::get<0>(curKey) != "is_m") {
-            break;
-        }
-        uint32_t nHeight = std::numeric_limits<uint32_t>::max() - be32toh(std::get<1>(curKey));
-        if (nHeight > nUntilHeight) {
-            break;
-        }
-
-        auto& islockHash = std::get<2>(curKey);
-        auto islock = GetInstantSendLockByHash(islockHash);
-        if (islock) {
-            RemoveInstantSendLock(batch, islockHash, islock);
-            ret.emplace(islockHash, islock);
-        }
 
-        // archive the islock hash, so that we're still able to check if we've seen the islock in the past
-        WriteInstantSendLockArchived(batch, islockHash, nHeight);
+    // buckets are sorted by height, so we only touch the buckets that are actually confirmed
+    auto it = minedByHeight.begin();
+    while (it != minedByHeight.end() && it->first <= nUntilHeight) {
+        int nHeight = it->first;
+        for (auto& islockHash : it->second) {
+            auto islock = GetInstantSendLockByHash(islockHash);
+            if (islock) {
+                RemoveInstantSendLock(batch, islockHash, islock);
+                ret.emplace(islockHash, islock);
+            }
 
-        batch.Erase(curKey);
+            // archive the islock hash, so that we're still able to check if we've seen the islock in the past
+            WriteInstantSendLockArchived(batch, islockHash, nHeight);
 
-        it->Next();
+            batch.Erase(BuildInversedISLockKey("is_m", nHeight, islockHash));
+        }
+        it = minedByHeight.erase(it);
     }
 
     db.WriteBatch(batch);
@@ -218,22 +266,11 @@ CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByHash(const uint256& hash
 
 uint256 CInstantSendDb::GetInstantSendLockHashByTxid(const uint256& txid)
 {
-    uint256 islockHash;
-
-    bool found = txidCache.get(txid, islockHash);
-    if (found && islockHash.IsNull()) {
+    auto it = txidIndex.find(txid);
+    if (it == txidIndex.end()) {
         return uint256();
     }
-
-    if (!found) {
-        found = db.Read(std::make_tuple(std::string("is_tx"), txid), islockHash);
-        txidCache.insert(txid, islockHash);
-    }
-
-    if (!found) {
-        return uint256();
-    }
-    return islockHash;
+    return it->second;
 }
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid)
@@ -247,21 +284,11 @@ CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256& txid
 
 CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint& outpoint)
 {
-    uint256 islockHash;
-    bool found = outpointCache.get(outpoint, islockHash);
-    if (found && islockHash.IsNull()) {
+    auto it = outpointIndex.find(outpoint);
+    if (it == outpointIndex.end()) {
         return nullptr;
     }
-
-    if (!found) {
-        found = db.Read(std::make_tuple(std::string("is_in"), outpoint), islockHash);
-        outpointCache.insert(outpoint, islockHash);
-    }
-
-    if (!found) {
-        return nullptr;
-    }
-    return GetInstantSendLockByHash(islockHash);
+    return GetInstantSendLockByHash(it->second);
 }
 
 std::vector<uint256> CInstantSendDb::GetInstantSendLocksByParent(const uint256& parent)
@@ -350,6 +377,10 @@ void CInstantSendManager::Start()
         assert(false);
     }
 
+    int workerCount = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() / 2));
+    verifyPool.resize(workerCount);
+    RenameThreadPool(verifyPool, "dash-is-verify");
+
     workThread = std::thread(&TraceThread<std::function<void()> >, "instantsend", std::function<void()>(std::bind(&CInstantSendManager::WorkThreadMain, this)));
 
     quorumSigningManager->RegisterRecoveredSigsListener(this);
@@ -367,6 +398,8 @@ void CInstantSendManager::Stop()
     if (workThread.joinable()) {
         workThread.join();
     }
+
+    verifyPool.stop(true);
 }
 
 void CInstantSendManager::InterruptWorkerThread()
@@ -782,20 +815,31 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
 {
     auto llmqType = Params().GetConsensus().llmqForInstantSend;
 
-    CBLSBatchVerifier<NodeId, uint256> batchVerifier(false, true, 8);
+    struct PendingVerification {
+        NodeId nodeId;
+        uint256 hash;
+        uint256 signHash;
+        const CInstantSendLock* islock;
+    };
+
+    // islocks signed by the same quorum share the same public key, so we group them by quorum and verify each group
+    // in (sub-)batches on the verify pool
+    std::unordered_map<uint256, std::pair<CQuorumCPtr, std::vector<PendingVerification>>, StaticSaltedHasher> byQuorum;
     std::unordered_map<uint256, std::pair<CQuorumCPtr, CRecoveredSig>> recSigs;
+    std::set<NodeId> badSources;
+    std::set<uint256> badMessages;
 
     for (const auto& p : pend) {
         auto& hash = p.first;
         auto nodeId = p.second.first;
         auto& islock = p.second.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             continue;
         }
 
         if (!islock.sig.Get().IsValid()) {
-            batchVerifier.badSources.emplace(nodeId);
+            badSources.emplace(nodeId);
             continue;
         }
 
@@ -812,7 +856,9 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
             return {};
         }
         uint256 signHash = CLLMQUtils::BuildSignHash(llmqType, quorum->qc.quorumHash, id, islock.txid);
-        batchVerifier.PushMessage(nodeId, hash, signHash, islock.sig.Get(), quorum->qc.quorumPublicKey);
+        auto& group = byQuorum[quorum->qc.quorumHash];
+        group.first = quorum;
+        group.second.emplace_back(PendingVerification{nodeId, hash, signHash, &islock});
 
         // We can reconstruct the CRecoveredSig objects from the islock and pass it to the signing manager, which
         // avoids unnecessary double-verification of the signature. We however only do this when verification here
@@ -830,13 +876,41 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
         }
     }
 
-    batchVerifier.Verify();
+    // Sub-batches are small enough to keep the per-message fallback cheap when a single bad islock is in the batch,
+    // but large enough to benefit from signature aggregation
+    const size_t subBatchSize = 8;
+
+    typedef CBLSBatchVerifier<NodeId, uint256> BatchVerifier;
+    std::vector<std::future<std::shared_ptr<BatchVerifier>>> futures;
+    for (const auto& p : byQuorum) {
+        const auto& quorum = p.second.first;
+        const auto& entries = p.second.second;
+        for (size_t i = 0; i < entries.size(); i += subBatchSize) {
+            size_t start = i;
+            size_t count = std::min(subBatchSize, entries.size() - start);
+            auto f = [&quorum, &entries, start, count](int threadId) {
+                auto batchVerifier = std::make_shared<BatchVerifier>(false, true);
+                for (size_t j = start; j < start + count; j++) {
+                    const auto& e = entries[j];
+                    batchVerifier->PushMessage(e.nodeId, e.hash, e.signHash, e.islock->sig.Get(), quorum->qc.quorumPublicKey);
+                }
+                batchVerifier->Verify();
+                return batchVerifier;
+            };
+            futures.emplace_back(verifyPool.push(f));
+        }
+    }
+    for (auto& f : futures) {
+        auto batchVerifier = f.get();
+        badSources.insert(batchVerifier->badSources.begin(), batchVerifier->badSources.end());
+        badMessages.insert(batchVerifier->badMessages.begin(), batchVerifier->badMessages.end());
+    }
 
     std::unordered_set<uint256> badISLocks;
 
-    if (ban && !batchVerifier.badSources.empty()) {
+    if (ban && !badSources.empty()) {
         LOCK(cs_main);
-        for (auto& nodeId : batchVerifier.badSources) {
+        for (auto& nodeId : badSources) {
             // Let's not be too harsh, as the peer might simply be unlucky and might have sent us an old lock which
             // does not validate anymore due to changed quorums
             Misbehaving(nodeId, 20);
@@ -847,7 +921,7 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
         auto nodeId = p.second.first;
         auto& islock = p.second.second;
 
-        if (batchVerifier.badMessages.count(hash)) {
+        if (badMessages.count(hash)) {
             LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: invalid sig in islock, peer=%d\n", __func__,
                      islock.txid.ToString(), hash.ToString(), nodeId);
             badISLocks.emplace(hash);
@@ -876,10 +950,7 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
 
 void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLock& islock)
 {
-    {
-        LOCK(cs_main);
-        g_connman->RemoveAskFor(hash);
-    }
+    g_connman->RemoveAskFor(hash);
 
     CTransactionRef tx;
     uint256 hashBlock;
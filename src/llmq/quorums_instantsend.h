@@ -8,9 +8,11 @@
 #include "quorums_signing.h"
 
 #include "coins.h"
+#include "ctpl.h"
 #include "unordered_lru_cache.h"
 #include "primitives/transaction.h"
 
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -46,11 +48,24 @@ private:
     CDBWrapper& db;
 
     unordered_lru_cache<uint256, CInstantSendLockPtr, StaticSaltedHasher, 10000> islockCache;
-    unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache;
-    unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache;
+
+    /**
+     * In-memory index of all islocks which are currently stored in the DB (i.e. not fully confirmed yet). The DB is
+     * only written through and read once at startup, so that lookups by txid and input (which happen for every TX and
+     * input we see) never have to hit LevelDB, not even for the (very common) negative case.
+     */
+    std::unordered_map<uint256, uint256, StaticSaltedHasher> txidIndex;
+    std::unordered_map<COutPoint, uint256, SaltedOutpointHasher> outpointIndex;
+
+    // islock hashes of mined islocks, bucketed by the height they were mined at. Used to evict fully confirmed islocks
+    // without scanning the DB
+    std::map<int, std::unordered_set<uint256, StaticSaltedHasher>> minedByHeight;
+
+private:
+    void LoadIndex();
 
 public:
-    CInstantSendDb(CDBWrapper& _db) : db(_db) {}
+    CInstantSendDb(CDBWrapper& _db);
 
     void WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock);
     void RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock);
@@ -81,6 +96,9 @@ private:
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
+    // Used to verify batches of pending islocks in parallel, grouped by the quorum that signed them
+    ctpl::thread_pool verifyPool;
+
     /**
      * Request ids of inputs that we signed. Used to determine if a recovered signature belongs to an
      * in-progress input lock.
@@ -651,10 +651,7 @@ void CSigningManager::ProcessRecoveredSig(NodeId nodeId, const CRecoveredSig& re
 {
     auto llmqType = (Consensus::LLMQType)recoveredSig.llmqType;
 
-    {
-        LOCK(cs_main);
-        connman.RemoveAskFor(recoveredSig.GetHash());
-    }
+    connman.RemoveAskFor(recoveredSig.GetHash());
 
     std::vector<CRecoveredSigsListener*> listeners;
     {
@@ -8,6 +8,7 @@
 
 #include "chainparams.h"
 #include "random.h"
+#include "unordered_lru_cache.h"
 #include "validation.h"
 
 namespace llmq
@@ -15,10 +16,37 @@ namespace llmq
 
 std::vector<CDeterministicMNCPtr> CLLMQUtils::GetAllQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum)
 {
+    // Members of a quorum only depend on the quorum block hash (and not on the chain that follows it), so we can
+    // safely memoize them. They are needed for DKG, quorum connections, commitments and signing and thus requested
+    // many times per block.
+    static CCriticalSection cs_members;
+    static std::map<Consensus::LLMQType, unordered_lru_cache<uint256, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher>> mapQuorumMembers;
+
     auto& params = Params().GetConsensus().llmqs.at(llmqType);
+    std::vector<CDeterministicMNCPtr> quorumMembers;
+    {
+        LOCK(cs_members);
+        if (mapQuorumMembers.empty()) {
+            for (auto& p : Params().GetConsensus().llmqs) {
+                // also keep members of recently rotated out quorums, as they are still used for connections
+                size_t cacheSize = (size_t)std::max(p.second.signingActiveQuorumCount, p.second.keepOldConnections) + 1;
+                mapQuorumMembers.emplace(std::piecewise_construct,
+                        std::forward_as_tuple(p.first),
+                        std::forward_as_tuple(cacheSize));
+            }
+        }
+        if (mapQuorumMembers.at(llmqType).get(pindexQuorum->GetBlockHash(), quorumMembers)) {
+            return quorumMembers;
+        }
+    }
+
     auto allMns = deterministicMNManager->GetListForBlock(pindexQuorum);
     auto modifier = ::SerializeHash(std::make_pair((uint8_t) llmqType, pindexQuorum->GetBlockHash()));
-    return allMns.CalculateQuorum(params.size, modifier);
+    quorumMembers = allMns.CalculateQuorum(params.size, modifier);
+
+    LOCK(cs_members);
+    mapQuorumMembers.at(llmqType).insert(pindexQuorum->GetBlockHash(), quorumMembers);
+    return quorumMembers;
 }
 
 uint256 CLLMQUtils::BuildCommitmentHash(uint8_t llmqType, const uint256& blockHash, const std::vector<bool>& validMembers, const CBLSPublicKey& pubKey, const uint256& vvecHash)
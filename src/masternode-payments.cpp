@@ -301,14 +301,14 @@ std::map<int, std::string> GetRequiredPaymentsStrings(int nStartHeight, int nEnd
     LOCK(cs_main);
     int nChainTipHeight = chainActive.Height();
 
-    bool doProjection = false;
-    for(int h = nStartHeight; h < nEndHeight; h++) {
-        if (h <= nChainTipHeight) {
-            auto payee = deterministicMNManager->GetListForBlock(chainActive[h - 1]).GetMNPayee();
+    bool doProjection = nStartHeight < nEndHeight && nEndHeight > nChainTipHeight + 1;
+    int nLastKnownHeight = std::min(nEndHeight - 1, nChainTipHeight);
+    if (nStartHeight <= nLastKnownHeight) {
+        // fetch all lists in one go instead of replaying diffs for every single height
+        auto lists = deterministicMNManager->GetListsForBlockRange(chainActive[nStartHeight - 1], chainActive[nLastKnownHeight - 1]);
+        for (int h = nStartHeight; h <= nLastKnownHeight; h++) {
+            auto payee = lists[h - nStartHeight].GetMNPayee();
             mapPayments.emplace(h, GetRequiredPaymentsString(h, payee));
-        } else {
-            doProjection = true;
-            break;
         }
     }
     if (doProjection) {
@@ -135,10 +135,28 @@ void BlockAssembler::resetBlock()
     // These counters do not include coinbase tx
     nBlockTx = 0;
     nFees = 0;
+    fAllPackagesSelected = true;
 }
 
 BlockAssembler::BlockAssembler(const CChainParams& params) : BlockAssembler(params, DefaultOptions(params)) {}
 
+/** Set who the coinbase pays to and tag it with the miner guid */
+static void SetCoinbaseRecipient(CMutableTransaction& coinbaseTx, const CScript& scriptPubKeyIn, const std::string& sPoolMiningPublicKey, const std::string& sMinerGuid)
+{
+    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
+
+	// BiblePay - Add Pool Support
+	if (!sPoolMiningPublicKey.empty())
+	{
+		CBitcoinAddress cbaPoolAddress(sPoolMiningPublicKey);
+		CScript spkPoolScript = GetScriptForDestination(cbaPoolAddress.Get());
+		coinbaseTx.vout[0].scriptPubKey = spkPoolScript;
+	}
+
+	if (!sMinerGuid.empty())
+		coinbaseTx.vout[0].sTxOutMessage += "<MINERGUID>" + sMinerGuid + "</MINERGUID>";
+}
+
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, std::string sPoolMiningPublicKey, std::string sMinerGuid, int iThreadId)
 {
     int64_t nTimeStart = GetTimeMicros();
@@ -193,6 +211,10 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int nDescendantsUpdated = 0;
     addPackageTxs(nPackagesSelected, nDescendantsUpdated);
 
+    pblocktemplate->nMempoolRemovals = mempool.GetTransactionsRemoved();
+    pblocktemplate->nMempoolEntries = mempool.vTxHashes.size();
+    pblocktemplate->fAllPackagesSelected = fAllPackagesSelected;
+
     int64_t nTime1 = GetTimeMicros();
 
     nLastBlockTx = nBlockTx;
@@ -205,15 +227,6 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     coinbaseTx.vin.resize(1);
     coinbaseTx.vin[0].prevout.SetNull();
     coinbaseTx.vout.resize(1);
-    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
-
-	// BiblePay - Add Pool Support
-	if (!sPoolMiningPublicKey.empty())
-	{
-		CBitcoinAddress cbaPoolAddress(sPoolMiningPublicKey);
-		CScript spkPoolScript = GetScriptForDestination(cbaPoolAddress.Get());
-		coinbaseTx.vout[0].scriptPubKey = spkPoolScript;
-	}
 
     // NOTE: unlike in bitcoin, we need to pass PREVIOUS block height here
     CAmount blockReward = nFees + GetBlockSubsidy(pindexPrev->nBits, pindexPrev->nHeight, Params().GetConsensus(), false);
@@ -253,9 +266,20 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 	// Add BiblePay version to the subsidy tx message
 	std::string sVersion = FormatFullVersion();
 	coinbaseTx.vout[0].sTxOutMessage += "<VER>" + sVersion + "</VER>" + sABNLocator;
-	if (!sMinerGuid.empty())
-		coinbaseTx.vout[0].sTxOutMessage += "<MINERGUID>" + sMinerGuid + "</MINERGUID>";
+	SetCoinbaseRecipient(coinbaseTx, scriptPubKeyIn, sPoolMiningPublicKey, sMinerGuid);
 
+    if (!FinishBlock(coinbaseTx, blockReward, pindexPrev))
+        return NULL;
+    int64_t nTime2 = GetTimeMicros();
+
+	if (fDebugSpam)
+		LogPrint("bench", "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+
+    return std::move(pblocktemplate);
+}
+
+bool BlockAssembler::FinishBlock(CMutableTransaction& coinbaseTx, CAmount blockReward, CBlockIndex* pindexPrev)
+{
     // Update coinbase transaction with additional info about masternode and governance payments,
     // get some info back to pass to getblocktemplate
     FillBlockPayments(coinbaseTx, nHeight, blockReward, pblocktemplate->voutMasternodePayments, pblocktemplate->voutSuperblockPayments);
@@ -263,6 +287,8 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
     pblocktemplate->vTxFees[0] = -nFees;
+    pblocktemplate->nBlockSize = nBlockSize;
+    pblocktemplate->nBlockSigOps = nBlockSigOps;
 
     // Fill in header
     pblock->hashPrevBlock  = pindexPrev->GetBlockHash();
@@ -277,12 +303,84 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 	{
 		if (fDebugSpam)
 			LogPrint("miner", "BibleMiner failed to create new block\n");
-        return NULL;
+        return false;
     }
-    int64_t nTime2 = GetTimeMicros();
+    return true;
+}
 
-	if (fDebugSpam)
-		LogPrint("bench", "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+std::unique_ptr<CBlockTemplate> BlockAssembler::ExtendBlock(const CBlockTemplate& prev)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    LOCK2(cs_main, mempool.cs);
+
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    if (!prev.fAllPackagesSelected || prev.block.hashPrevBlock != pindexPrev->GetBlockHash() ||
+        prev.nMempoolRemovals != mempool.GetTransactionsRemoved() || prev.nMempoolEntries > mempool.vTxHashes.size()) {
+        return nullptr;
+    }
+
+    resetBlock();
+    pblocktemplate.reset(new CBlockTemplate(prev));
+    pblock = &pblocktemplate->block;
+    pblocktemplate->voutMasternodePayments.clear();
+    pblocktemplate->voutSuperblockPayments.clear();
+    nHeight = pindexPrev->nHeight + 1;
+    nBlockSize = prev.nBlockSize;
+    nBlockSigOps = prev.nBlockSigOps;
+    nBlockTx = pblock->vtx.size() - 1;
+    nFees = -prev.vTxFees[0];
+    for (size_t i = 1; i < pblock->vtx.size(); i++) {
+        CTxMemPool::txiter it = mempool.mapTx.find(pblock->vtx[i]->GetHash());
+        if (it != mempool.mapTx.end()) {
+            inBlock.insert(it);
+        }
+    }
+
+    pblock->nTime = GetAdjustedTime();
+    nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+                       ? pindexPrev->GetMedianTimePast()
+                       : pblock->GetBlockTime();
+
+    // Nothing was removed, so everything from nMempoolEntries on entered the mempool after prev was built.
+    // As prev took every package above the minimum fee rate, a full selection would take each new
+    // transaction on its own, as long as its parents are in the block already.
+    size_t nAdded = 0;
+    for (size_t i = prev.nMempoolEntries; i < mempool.vTxHashes.size(); i++) {
+        CTxMemPool::txiter it = mempool.vTxHashes[i].second;
+        if (it->GetTx().nType != TRANSACTION_NORMAL) {
+            // special transactions change the CbTx merkle roots
+            return nullptr;
+        }
+        for (CTxMemPool::txiter parent : mempool.GetMemPoolParents(it)) {
+            if (!inBlock.count(parent)) {
+                // its package includes a parent which was left out before
+                return nullptr;
+            }
+        }
+        if (it->GetModifiedFee() < blockMinFeeRate.GetFee(it->GetTxSize())) {
+            continue;
+        }
+        CTxMemPool::setEntries package;
+        package.insert(it);
+        if (!TestPackage(it->GetTxSize(), it->GetSigOpCount()) || !TestPackageTransactions(package)) {
+            return nullptr;
+        }
+        AddToBlock(it);
+        nAdded++;
+    }
+    pblocktemplate->nMempoolEntries = mempool.vTxHashes.size();
+
+    // Same coinbase as before (recipient, CbTx), only the amounts change
+    CMutableTransaction coinbaseTx(*pblock->vtx[0]);
+    coinbaseTx.vout.resize(1);
+    CAmount blockReward = nFees + GetBlockSubsidy(pindexPrev->nBits, pindexPrev->nHeight, Params().GetConsensus(), false);
+    coinbaseTx.vout[0].nValue = blockReward;
+
+    if (!FinishBlock(coinbaseTx, blockReward, pindexPrev))
+        return nullptr;
+
+    LogPrint("bench", "ExtendBlock() added %u txs: %.2fms\n", nAdded, 0.001 * (GetTimeMicros() - nTimeStart));
 
     return std::move(pblocktemplate);
 }
@@ -482,6 +580,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         }
 
         if (!TestPackage(packageSize, packageSigOps)) {
+            fAllPackagesSelected = false;
             if (fUsingModified) {
                 // Since we always look at the best entry in mapModifiedTx,
                 // we must erase failed entries so that we can consider the
@@ -509,6 +608,7 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
 
         // Test if all tx's are Final and safe
         if (!TestPackageTransactions(ancestors)) {
+            fAllPackagesSelected = false;
             if (fUsingModified) {
                 mapModifiedTx.get<ancestor_score>().erase(modit);
                 failedTx.insert(iter);
@@ -536,6 +636,92 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
+CBlockTemplateCache blockTemplateCache;
+
+bool CBlockTemplateCache::IsCurrent(const uint256& hashTip, unsigned int nTransactionsUpdatedIn) const
+{
+    return pTemplate && pTemplate->block.hashPrevBlock == hashTip &&
+           (nTransactionsUpdatedIn == nTransactionsUpdated || GetTime() - nTimeBuilt < BLOCK_TEMPLATE_REFRESH_TIME);
+}
+
+std::shared_ptr<const CBlockTemplate> CBlockTemplateCache::Rebuild(const CChainParams& chainparams)
+{
+    LOCK2(cs_main, mempool.cs);
+    uint256 hashTip = chainActive.Tip()->GetBlockHash();
+    unsigned int nTransactionsUpdatedNew = mempool.GetTransactionsUpdated();
+    std::shared_ptr<const CBlockTemplate> pTemplatePrev;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        // somebody else might have rebuilt it while we were waiting for cs_main
+        if (IsCurrent(hashTip, nTransactionsUpdatedNew)) {
+            return pTemplate;
+        }
+        pTemplatePrev = pTemplate;
+        fBuilding = true;
+    }
+
+    std::shared_ptr<const CBlockTemplate> pTemplateNew;
+    try {
+        // the coinbase recipient is filled in per caller
+        if (pTemplatePrev && pTemplatePrev->block.hashPrevBlock == hashTip) {
+            // cheap if only transactions were added since
+            pTemplateNew = BlockAssembler(chainparams).ExtendBlock(*pTemplatePrev);
+        }
+        if (!pTemplateNew) {
+            pTemplateNew = BlockAssembler(chainparams).CreateNewBlock(CScript(), "", "", 0);
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(cs);
+        fBuilding = false;
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(cs);
+    fBuilding = false;
+    if (pTemplateNew) {
+        pTemplate = pTemplateNew;
+        nTransactionsUpdated = nTransactionsUpdatedNew;
+        nTimeBuilt = GetTime();
+    }
+    return pTemplateNew;
+}
+
+std::unique_ptr<CBlockTemplate> CBlockTemplateCache::Get(const CChainParams& chainparams, const CScript& scriptPubKeyIn, const std::string& sPoolMiningPublicKey, const std::string& sMinerGuid)
+{
+    uint256 hashTip;
+    {
+        LOCK(cs_main);
+        hashTip = chainActive.Tip()->GetBlockHash();
+    }
+    unsigned int nTransactionsUpdatedNow = mempool.GetTransactionsUpdated();
+
+    std::shared_ptr<const CBlockTemplate> pTemplateShared;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (IsCurrent(hashTip, nTransactionsUpdatedNow) || (fBuilding && pTemplate && pTemplate->block.hashPrevBlock == hashTip)) {
+            pTemplateShared = pTemplate;
+        }
+    }
+    if (!pTemplateShared) {
+        pTemplateShared = Rebuild(chainparams);
+        if (!pTemplateShared) {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate(new CBlockTemplate(*pTemplateShared));
+    CBlock& block = pblocktemplate->block;
+    CMutableTransaction coinbaseTx(*block.vtx[0]);
+    SetCoinbaseRecipient(coinbaseTx, scriptPubKeyIn, sPoolMiningPublicKey, sMinerGuid);
+    block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    pblocktemplate->vTxSigOps[0] = GetLegacySigOpCount(*block.vtx[0]);
+    if (!chainparams.GetConsensus().fPowAllowMinDifficultyBlocks) {
+        // the template may be a few seconds old, nBits doesn't depend on the time here
+        block.nTime = std::max(block.nTime, (uint32_t)GetAdjustedTime());
+    }
+    return pblocktemplate;
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
     // Update nExtraNonce
@@ -553,6 +739,7 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
 
     pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
+    pblock->InvalidateHashCache();
 }
 
 
@@ -593,8 +780,7 @@ bool CreateBlockForStratum(std::string sAddress, std::string& sError, CBlock& bl
 	int iThreadID = 0;
 	boost::shared_ptr<CReserveScript> coinbaseScript;
     GetMainSignals().ScriptForMining(coinbaseScript);
-	std::unique_ptr<CBlockTemplate> pblocktemplate(BlockAssembler(Params()).CreateNewBlock(coinbaseScript->reserveScript, 
-		sAddress, sMinerGuid, iThreadID));
+	std::unique_ptr<CBlockTemplate> pblocktemplate(blockTemplateCache.Get(Params(), coinbaseScript->reserveScript, sAddress, sMinerGuid));
 	if (!pblocktemplate.get())
     {
 		LogPrint("miner", "CreateBlockForStratum::No block to mine %f", iThreadID);
@@ -672,7 +858,7 @@ recover:
            
 			// Create Evo block
 
-			std::unique_ptr<CBlockTemplate> pblocktemplate(BlockAssembler(Params()).CreateNewBlock(coinbaseScript->reserveScript, "", "", iThreadID));
+			std::unique_ptr<CBlockTemplate> pblocktemplate(blockTemplateCache.Get(chainparams, coinbaseScript->reserveScript, "", ""));
 			if (!pblocktemplate.get())
             {
 				MilliSleep(15000);
@@ -681,6 +867,9 @@ recover:
             }
 
 			CBlock *pblock = &pblocktemplate->block;
+			// The shared template follows the tip, which may have moved on since we looked at it
+			if (pblock->hashPrevBlock != pindexPrev->GetBlockHash())
+				continue;
 			
 			int iStart = rand() % 65536;
 			unsigned int nExtraNonce = GetAdjustedTime() + iStart + iThreadID;
@@ -709,7 +898,7 @@ recover:
 					// BiblePay: Proof of BibleHash requires the blockHash to not only be less than the Hash Target, but also,
 					// the BibleHash of the blockhash must be less than the target.
 					// The BibleHash is generated from chained bible verses, AES encryption, MD5, X11, and the custom biblepay.c hash
-					uint256 x11_hash = pblock->GetHash();
+					uint256 x11_hash = pblock->GetHashUncached();
 					uint256 hash = BibleHashV2(x11_hash, pblock->GetBlockTime(), pindexPrev->nTime, true, pindexPrev->nHeight);
 
 					nHashesDone += 1;
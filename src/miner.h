@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <memory>
+#include <mutex>
 #include "boost/multi_index_container.hpp"
 #include "boost/multi_index/ordered_index.hpp"
 
@@ -24,6 +25,8 @@ class CWallet;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Seconds a shared block template is kept after the mempool changed (a new tip always replaces it) */
+static const int64_t BLOCK_TEMPLATE_REFRESH_TIME = 5;
 
 void GenerateBBP(bool fGenerate, int nThreads, const CChainParams& chainparams);
 bool CreateBlockForStratum(std::string sAddress, std::string& sError, CBlock& blockX);
@@ -36,6 +39,13 @@ struct CBlockTemplate
     uint32_t nPrevBits; // nBits of previous block (for subsidy calculation)
     std::vector<CTxOut> voutMasternodePayments; // masternode payment
     std::vector<CTxOut> voutSuperblockPayments; // superblock payment
+
+    // State the transactions were selected in, see BlockAssembler::ExtendBlock
+    unsigned int nMempoolRemovals{0};
+    size_t nMempoolEntries{0};
+    bool fAllPackagesSelected{false};
+    uint64_t nBlockSize{0};
+    unsigned int nBlockSigOps{0};
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -155,6 +165,8 @@ private:
     unsigned int nBlockSigOps;
     CAmount nFees;
     CTxMemPool::setEntries inBlock;
+    //! false if any package above the minimum fee rate was left out
+    bool fAllPackagesSelected;
 
     // Chain context for the block
     int nHeight;
@@ -173,6 +185,14 @@ public:
 
     /** Construct a new block template with coinbase to scriptPubKeyIn */
 	std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, std::string sPoolMiningPublicKey, std::string sMinerGuid, int iThreadId);
+    /**
+     * Construct a template by appending the transactions which entered the mempool since prev was
+     * built, keeping its coinbase recipient. This gives the same selection as CreateNewBlock without
+     * walking the whole mempool, but only works while the tip is the same, nothing left the mempool,
+     * prev included every package above the minimum fee rate and the new transactions are normal ones
+     * whose in-mempool parents are in prev. Returns nullptr otherwise, CreateNewBlock is needed then.
+     */
+    std::unique_ptr<CBlockTemplate> ExtendBlock(const CBlockTemplate& prev);
   
 private:
     // utility functions
@@ -180,6 +200,8 @@ private:
     void resetBlock();
     /** Add a tx to the block */
     void AddToBlock(CTxMemPool::txiter iter);
+    /** Add masternode and superblock payments to the coinbase, fill in the header and check the block */
+    bool FinishBlock(CMutableTransaction& coinbaseTx, CAmount blockReward, CBlockIndex* pindexPrev);
 
     // Methods for how to add transactions to a block.
     /** Add transactions based on feerate including unconfirmed ancestors
@@ -208,6 +230,33 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx);
 };
 
+/**
+ * Shares block templates between the internal miner threads, stratum and getblocktemplate.
+ * The expensive part (package selection, CbTx merkle roots, validity check) is done once per
+ * tip and mempool update. Callers get a copy which only differs in the coinbase recipient,
+ * miner guid and time. Copies are cheap, as the transactions are shared.
+ *
+ * While one caller rebuilds the template after a mempool change, others keep getting the
+ * previous one instead of queueing on cs_main. After a tip change they have to wait for it.
+ */
+class CBlockTemplateCache
+{
+public:
+    std::unique_ptr<CBlockTemplate> Get(const CChainParams& chainparams, const CScript& scriptPubKeyIn, const std::string& sPoolMiningPublicKey, const std::string& sMinerGuid);
+
+private:
+    std::shared_ptr<const CBlockTemplate> Rebuild(const CChainParams& chainparams);
+    bool IsCurrent(const uint256& hashTip, unsigned int nTransactionsUpdatedIn) const;
+
+    std::mutex cs;
+    std::shared_ptr<const CBlockTemplate> pTemplate;
+    unsigned int nTransactionsUpdated{0};
+    int64_t nTimeBuilt{0};
+    bool fBuilding{false};
+};
+
+extern CBlockTemplateCache blockTemplateCache;
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -37,6 +37,10 @@
 #include <fcntl.h>
 #endif
 
+#if HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -53,6 +57,12 @@
 // We add a random period time (0 to 1 seconds) to feeler connections to prevent synchronization.
 #define FEELER_SLEEP_WINDOW 1
 
+// Frequency to poll pnode->vSend when waiting for socket events
+#define SELECT_TIMEOUT_MILLISECONDS 50
+
+// Maximum number of events returned by a single epoll_wait() call. Remaining events are returned by the next call
+#define EPOLL_MAX_EVENTS 64
+
 #if !defined(HAVE_MSG_NOSIGNAL) && !defined(MSG_NOSIGNAL)
 #define MSG_NOSIGNAL 0
 #endif
@@ -86,12 +96,46 @@ std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 static bool vfLimited[NET_MAX] = {};
 std::string strSubVersion;
 
+CCriticalSection cs_askFor;
 unordered_limitedmap<uint256, int64_t, StaticSaltedHasher> mapAlreadyAskedFor(MAX_INV_SZ, MAX_INV_SZ * 2);
 
 // Signals for message handling
 static CNodeSignals g_signals;
 CNodeSignals& GetNodeSignals() { return g_signals; }
 
+bool ParseSocketEventsMode(const std::string& str, SocketEventsMode& modeOut)
+{
+    if (str == "select") {
+        modeOut = SOCKETEVENTS_SELECT;
+        return true;
+    }
+#if HAVE_EPOLL
+    if (str == "epoll") {
+        modeOut = SOCKETEVENTS_EPOLL;
+        return true;
+    }
+#endif
+    return false;
+}
+
+std::string GetSocketEventsModeStr(SocketEventsMode mode)
+{
+    switch (mode) {
+        case SOCKETEVENTS_SELECT: return "select";
+        case SOCKETEVENTS_EPOLL: return "epoll";
+        default: return "unknown";
+    }
+}
+
+std::string GetSupportedSocketEventsModesStr()
+{
+#if HAVE_EPOLL
+    return "select, epoll";
+#else
+    return "select";
+#endif
+}
+
 void CConnman::AddOneShot(const std::string& strDest)
 {
     LOCK(cs_vOneShots);
@@ -377,7 +421,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
     if (pszDest ? ConnectSocketByName(addrConnect, hSocket, pszDest, Params().GetDefaultPort(), nConnectTimeout, &proxyConnectionFailed) :
                   ConnectSocket(addrConnect, hSocket, nConnectTimeout, &proxyConnectionFailed))
     {
-        if (!IsSelectableSocket(hSocket)) {
+        if (!IsSocketUsable(hSocket)) {
             LogPrintf("Cannot create connection: non-selectable socket created (fd >= FD_SETSIZE ?)\n");
             CloseSocket(hSocket);
             return NULL;
@@ -753,16 +797,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
         nBytes -= handled;
 
         if (msg.complete()) {
-
-            //store received bytes per message command
-            //to prevent a memory DOS, only allow valid commands
-            mapMsgCmdSize::iterator i = mapRecvBytesPerMsgCmd.find(msg.hdr.pchCommand);
-            if (i == mapRecvBytesPerMsgCmd.end())
-                i = mapRecvBytesPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
-            assert(i != mapRecvBytesPerMsgCmd.end());
-            i->second += msg.hdr.nMessageSize + CMessageHeader::HEADER_SIZE;
-
-            msg.nTime = nTimeMicros;
+            OnMessageComplete(msg, nTimeMicros);
             complete = true;
         }
     }
@@ -770,6 +805,51 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
     return true;
 }
 
+void CNode::OnMessageComplete(CNetMessage& msg, int64_t nTimeMicros)
+{
+    AssertLockHeld(cs_vRecv);
+
+    //store received bytes per message command
+    //to prevent a memory DOS, only allow valid commands
+    mapMsgCmdSize::iterator i = mapRecvBytesPerMsgCmd.find(msg.hdr.pchCommand);
+    if (i == mapRecvBytesPerMsgCmd.end())
+        i = mapRecvBytesPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
+    assert(i != mapRecvBytesPerMsgCmd.end());
+    i->second += msg.hdr.nMessageSize + CMessageHeader::HEADER_SIZE;
+
+    msg.nTime = nTimeMicros;
+}
+
+bool CNode::GetDirectRecvBuffer(char*& pch, unsigned int& nBytes)
+{
+    LOCK(cs_vRecv);
+    if (vRecvMsg.empty()) {
+        return false;
+    }
+    CNetMessage& msg = vRecvMsg.back();
+    if (!msg.in_data || msg.hdr.nMessageSize - msg.nDataPos < DIRECT_RECV_MIN_SIZE) {
+        return false;
+    }
+    nBytes = msg.prepareDirectRead(pch, std::numeric_limits<unsigned int>::max());
+    return nBytes != 0;
+}
+
+void CNode::CommitDirectRecv(unsigned int nBytes, bool& complete)
+{
+    complete = false;
+    int64_t nTimeMicros = GetTimeMicros();
+    LOCK(cs_vRecv);
+    nLastRecv = nTimeMicros / 1000000;
+    nRecvBytes += nBytes;
+
+    CNetMessage& msg = vRecvMsg.back();
+    msg.commitDirectRead(nBytes);
+    if (msg.complete()) {
+        OnMessageComplete(msg, nTimeMicros);
+        complete = true;
+    }
+}
+
 void CNode::SetSendVersion(int nVersionIn)
 {
     // Send version may only be changed in the version message, and
@@ -829,22 +909,40 @@ int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
 }
 
 int CNetMessage::readData(const char *pch, unsigned int nBytes)
+{
+    char* pchDest;
+    unsigned int nCopy = prepareDirectRead(pchDest, nBytes);
+    memcpy(pchDest, pch, nCopy);
+    commitDirectRead(nCopy);
+
+    return nCopy;
+}
+
+unsigned int CNetMessage::prepareDirectRead(char*& pchOut, unsigned int nMaxBytes)
 {
     unsigned int nRemaining = hdr.nMessageSize - nDataPos;
-    unsigned int nCopy = std::min(nRemaining, nBytes);
+    unsigned int nCopy = std::min(nRemaining, nMaxBytes);
 
     if (vRecv.size() < nDataPos + nCopy) {
-        // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        // Allocate up to 256 KiB ahead, but never more than the total message size. Grow geometrically beyond that, so
+        // that large messages don't get reallocated (and copied) for every 256 KiB received
+        size_t nNewSize = std::max((size_t)nDataPos + std::min(nCopy, 256u * 1024) + 256 * 1024, vRecv.size() * 2);
+        vRecv.resize(std::min((size_t)hdr.nMessageSize, nNewSize));
+        nCopy = std::min(nCopy, (unsigned int)vRecv.size() - nDataPos);
     }
 
-    hasher.Write((const unsigned char*)pch, nCopy);
-    memcpy(&vRecv[nDataPos], pch, nCopy);
-    nDataPos += nCopy;
-
+    pchOut = &vRecv[nDataPos];
     return nCopy;
 }
 
+void CNetMessage::commitDirectRead(unsigned int nBytes)
+{
+    assert(nDataPos + nBytes <= vRecv.size());
+    // the checksum is calculated while the data arrives
+    hasher.Write((const unsigned char*)&vRecv[nDataPos], nBytes);
+    nDataPos += nBytes;
+}
+
 const uint256& CNetMessage::GetMessageHash() const
 {
     assert(complete());
@@ -888,7 +986,9 @@ size_t CConnman::SocketSendData(CNode *pnode) const
                 pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
                 it++;
             } else {
-                // could not send full message; stop sending more
+                // could not send full message; stop sending more. The socket buffer is full, so wait until the socket
+                // is reported as writable again
+                pnode->fCanSendData = false;
                 break;
             }
         } else {
@@ -899,6 +999,8 @@ size_t CConnman::SocketSendData(CNode *pnode) const
                 {
                     LogPrintf("socket send error %s\n", NetworkErrorString(nErr));
                     pnode->fDisconnect = true;
+                } else if (nErr == WSAEWOULDBLOCK) {
+                    pnode->fCanSendData = false;
                 }
             }
             // couldn't send anything at all
@@ -1122,7 +1224,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
         return;
     }
 
-    if (!IsSelectableSocket(hSocket))
+    if (!IsSocketUsable(hSocket))
     {
         if (fDebugSpam)
 			LogPrintf("connection from %s dropped: non-selectable socket\n", addr.ToString());
@@ -1178,6 +1280,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     GetNodeSignals().InitializeNode(pnode, *this);
 	if (fDebugSpam)
 		LogPrint("net", "connection from %s accepted\n", addr.ToString());
+    RegisterEvents(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
@@ -1187,8 +1290,12 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
 void CConnman::ThreadSocketHandler()
 {
     unsigned int nPrevNodeCount = 0;
+    // true if there is still work left from the last loop, in which case we must not block while waiting for events
+    bool fOnlyPoll = false;
     while (!interruptNet)
     {
+        int64_t nLoopStart = GetTimeMicros();
+
         //
         // Disconnect nodes
         //
@@ -1258,121 +1365,20 @@ void CConnman::ThreadSocketHandler()
         //
         // Find which sockets have data to receive
         //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-#ifndef WIN32
-        // We add a pipe to the read set so that the select() call can be woken up from the outside
-        // This is done when data is available for sending and at the same time optimistic sending was disabled
-        // when pushing the data.
-        // This is currently only implemented for POSIX compliant systems. This means that Windows will fall back to
-        // timing out after 50ms and then trying to send. This is ok as we assume that heavy-load daemons are usually
-        // run on Linux and friends.
-        FD_SET(wakeupPipe[0], &fdsetRecv);
-        hSocketMax = std::max(hSocketMax, (SOCKET)wakeupPipe[0]);
-        have_fds = true;
-#endif
-
-        BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
-
-        {
-            LOCK(cs_vNodes);
-            BOOST_FOREACH(CNode* pnode, vNodes)
-            {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
-
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
-
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-            }
-        }
-
-        wakeupSelectNeeded = true;
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        wakeupSelectNeeded = false;
+        std::set<SOCKET> recv_set, send_set, error_set;
+        int64_t nWaitStart = GetTimeMicros();
+        SocketEvents(recv_set, send_set, error_set, fOnlyPoll);
+        int64_t nWaitTime = GetTimeMicros() - nWaitStart;
         if (interruptNet)
             return;
-
-        if (nSelect == SOCKET_ERROR)
-        {
-            if (have_fds)
-            {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
-                return;
-        }
-
-#ifndef WIN32
-        // drain the wakeup pipe
-        if (FD_ISSET(wakeupPipe[0], &fdsetRecv)) 
-		{
-			if (fDebugSpam)
-				LogPrint("net", "woke up select()\n");
-            char buf[128];
-            while (true) {
-                int r = read(wakeupPipe[0], buf, sizeof(buf));
-                if (r <= 0) {
-                    break;
-                }
-            }
-        }
-#endif
+        fOnlyPoll = false;
 
         //
         // Accept new connections
         //
         BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket)
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+            if (hListenSocket.socket != INVALID_SOCKET && recv_set.count(hListenSocket.socket) > 0)
             {
                 AcceptConnection(hListenSocket);
             }
@@ -1393,13 +1399,49 @@ void CConnman::ThreadSocketHandler()
             bool recvSet = false;
             bool sendSet = false;
             bool errorSet = false;
+            bool fRecvReady, fSendReady;
             {
                 LOCK(pnode->cs_hSocket);
                 if (pnode->hSocket == INVALID_SOCKET)
                     continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
+                fRecvReady = recv_set.count(pnode->hSocket) > 0;
+                fSendReady = send_set.count(pnode->hSocket) > 0;
+                errorSet = error_set.count(pnode->hSocket) > 0;
+            }
+            if (socketEventsMode == SOCKETEVENTS_SELECT) {
+                // select() reports the current readiness on every call and already took care of only selecting
+                // for sending when there is data to send
+                pnode->fHasRecvData = fRecvReady;
+                {
+                    LOCK(pnode->cs_vSend);
+                    pnode->fCanSendData = fSendReady;
+                }
+                recvSet = fRecvReady;
+                sendSet = fSendReady;
+            } else {
+                // edge-triggered epoll only reports changes in readiness, so we remember them until a recv()/send()
+                // call would block
+                if (fRecvReady) {
+                    pnode->fHasRecvData = true;
+                }
+                if (errorSet) {
+                    // read what is left before disconnecting, recv() reports the error if there is nothing
+                    pnode->fSocketHangup = true;
+                    pnode->fHasRecvData = true;
+                }
+                // Same logic as with select(): first drain the write buffer before receiving more
+                bool fSendPending;
+                {
+                    // SocketSendData clears fCanSendData under cs_vSend after send() would block. Setting it under
+                    // the same lock makes sure an edge reported in the meantime is not overwritten and lost
+                    LOCK(pnode->cs_vSend);
+                    if (fSendReady) {
+                        pnode->fCanSendData = true;
+                    }
+                    fSendPending = !pnode->vSendMsg.empty();
+                    sendSet = fSendPending && pnode->fCanSendData;
+                }
+                recvSet = !fSendPending && pnode->fHasRecvData && !pnode->fPauseRecv;
             }
             if (recvSet || errorSet)
             {
@@ -1407,18 +1449,31 @@ void CConnman::ThreadSocketHandler()
                     {
                         // typical socket buffer is 8K-64K
                         char pchBuf[0x10000];
+                        // large messages are received directly into their receive buffer, avoiding a copy
+                        char* pchDirect = nullptr;
+                        unsigned int nDirectSize = 0;
+                        bool fDirect = pnode->GetDirectRecvBuffer(pchDirect, nDirectSize);
+                        char* pchRecv = fDirect ? pchDirect : pchBuf;
+                        size_t nRecvSize = fDirect ? nDirectSize : sizeof(pchBuf);
                         int nBytes = 0;
                         {
                             LOCK(pnode->cs_hSocket);
                             if (pnode->hSocket == INVALID_SOCKET)
                                 continue;
-                            nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+                            nBytes = recv(pnode->hSocket, pchRecv, nRecvSize, MSG_DONTWAIT);
                         }
                         if (nBytes > 0)
                         {
+                            if ((size_t)nBytes < nRecvSize) {
+                                // we've drained the socket buffer, edge-triggered epoll will tell us when there is more
+                                pnode->fHasRecvData = false;
+                            }
                             bool notify = false;
-                            if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+                            if (fDirect) {
+                                pnode->CommitDirectRecv(nBytes, notify);
+                            } else if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify)) {
                                 pnode->CloseSocketDisconnect();
+                            }
                             RecordBytesRecv(nBytes);
                             if (notify) {
                                 size_t nSizeAdded = 0;
@@ -1451,6 +1506,9 @@ void CConnman::ThreadSocketHandler()
                         {
                             // error
                             int nErr = WSAGetLastError();
+                            if (nErr == WSAEWOULDBLOCK) {
+                                pnode->fHasRecvData = false;
+                            }
                             if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
                             {
                                 if (!pnode->fDisconnect)
@@ -1463,6 +1521,10 @@ void CConnman::ThreadSocketHandler()
                         }
                     }
                 }
+                if (pnode->fSocketHangup && !pnode->fHasRecvData) {
+                    // everything the peer sent before the error or hangup was received
+                    pnode->fDisconnect = true;
+                }
             }
 
             //
@@ -1477,6 +1539,16 @@ void CConnman::ThreadSocketHandler()
                 }
             }
 
+            if (socketEventsMode != SOCKETEVENTS_SELECT && !pnode->fDisconnect) {
+                // If there is still data available or sendable, we won't get another edge for it, so don't block in the
+                // next epoll_wait() call
+                LOCK(pnode->cs_vSend);
+                bool fSendPending = !pnode->vSendMsg.empty();
+                if ((fSendPending && pnode->fCanSendData) || (!fSendPending && pnode->fHasRecvData && !pnode->fPauseRecv)) {
+                    fOnlyPoll = true;
+                }
+            }
+
             //
             // Inactivity checking
             //
@@ -1511,9 +1583,244 @@ void CConnman::ThreadSocketHandler()
             }
         }
         ReleaseNodeVector(vNodesCopy);
+
+        int64_t nBusyTime = GetTimeMicros() - nLoopStart - nWaitTime;
+        nSocketHandlerLoops++;
+        nSocketHandlerBusyTime += nBusyTime;
+        nSocketHandlerLastBusyTime = nBusyTime;
     }
 }
 
+bool CConnman::IsSocketUsable(SOCKET hSocket) const
+{
+    // epoll has no limit on the value of file descriptors, select() only supports those below FD_SETSIZE
+    if (socketEventsMode == SOCKETEVENTS_SELECT) {
+        return IsSelectableSocket(hSocket);
+    }
+    return hSocket != INVALID_SOCKET;
+}
+
+void CConnman::RegisterEvents(CNode* pnode)
+{
+#if HAVE_EPOLL
+    if (socketEventsMode != SOCKETEVENTS_EPOLL) {
+        return;
+    }
+
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET) {
+        return;
+    }
+
+    // The socket is removed from the epoll set automatically when it gets closed
+    epoll_event e;
+    e.events = EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLET;
+    e.data.fd = pnode->hSocket;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, pnode->hSocket, &e) != 0) {
+        LogPrintf("%s -- epoll_ctl failed for peer=%d: %s\n", __func__, pnode->id, NetworkErrorString(WSAGetLastError()));
+        pnode->fDisconnect = true;
+    }
+#endif
+}
+
+void CConnman::SocketEvents(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set, bool fOnlyPoll)
+{
+    switch (socketEventsMode) {
+#if HAVE_EPOLL
+        case SOCKETEVENTS_EPOLL:
+            SocketEventsEpoll(recv_set, send_set, error_set, fOnlyPoll);
+            break;
+#endif
+        default:
+            SocketEventsSelect(recv_set, send_set, error_set, fOnlyPoll);
+            break;
+    }
+
+#ifndef WIN32
+    // drain the wakeup pipe
+    if (wakeupPipe[0] != -1 && recv_set.count(wakeupPipe[0]))
+    {
+        if (fDebugSpam)
+            LogPrint("net", "woke up select()\n");
+        char buf[128];
+        while (true) {
+            int r = read(wakeupPipe[0], buf, sizeof(buf));
+            if (r <= 0) {
+                break;
+            }
+        }
+        recv_set.erase(wakeupPipe[0]);
+    }
+#endif
+}
+
+#if HAVE_EPOLL
+void CConnman::SocketEventsEpoll(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set, bool fOnlyPoll)
+{
+    epoll_event events[EPOLL_MAX_EVENTS];
+
+    wakeupSelectNeeded = true;
+    int nEvents = epoll_wait(epollFd, events, EPOLL_MAX_EVENTS, fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS);
+    wakeupSelectNeeded = false;
+
+    if (nEvents < 0) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINTR) {
+            LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(nErr));
+        }
+        interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
+        return;
+    }
+
+    for (int i = 0; i < nEvents; i++) {
+        const epoll_event& e = events[i];
+        if (e.events & (EPOLLERR | EPOLLHUP)) {
+            error_set.insert(e.data.fd);
+        }
+        if (e.events & EPOLLIN) {
+            recv_set.insert(e.data.fd);
+        }
+        if (e.events & EPOLLOUT) {
+            send_set.insert(e.data.fd);
+        }
+    }
+}
+#endif
+
+void CConnman::SocketEventsSelect(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set, bool fOnlyPoll)
+{
+    struct timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = fOnlyPoll ? 0 : SELECT_TIMEOUT_MILLISECONDS * 1000; // frequency to poll pnode->vSend
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    std::set<SOCKET> recv_select_set, send_select_set, error_select_set;
+
+#ifndef WIN32
+    // We add a pipe to the read set so that the select() call can be woken up from the outside
+    // This is done when data is available for sending and at the same time optimistic sending was disabled
+    // when pushing the data.
+    // This is currently only implemented for POSIX compliant systems. This means that Windows will fall back to
+    // timing out after 50ms and then trying to send. This is ok as we assume that heavy-load daemons are usually
+    // run on Linux and friends.
+    if (wakeupPipe[0] != -1) {
+        recv_select_set.insert(wakeupPipe[0]);
+    }
+#endif
+
+    BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
+        recv_select_set.insert(hListenSocket.socket);
+    }
+
+    {
+        LOCK(cs_vNodes);
+        BOOST_FOREACH(CNode* pnode, vNodes)
+        {
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is space left in the receive buffer, select() for
+            //   receiving data.
+            // * Hand off all complete messages to the processor, to be handled without
+            //   blocking here.
+
+            bool select_recv = !pnode->fPauseRecv;
+            bool select_send;
+            {
+                LOCK(pnode->cs_vSend);
+                select_send = !pnode->vSendMsg.empty();
+            }
+
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+
+            error_select_set.insert(pnode->hSocket);
+            if (select_send) {
+                send_select_set.insert(pnode->hSocket);
+                continue;
+            }
+            if (select_recv) {
+                recv_select_set.insert(pnode->hSocket);
+            }
+        }
+    }
+
+    for (SOCKET hSocket : recv_select_set) {
+        FD_SET(hSocket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hSocket);
+        have_fds = true;
+    }
+    for (SOCKET hSocket : send_select_set) {
+        FD_SET(hSocket, &fdsetSend);
+        hSocketMax = std::max(hSocketMax, hSocket);
+        have_fds = true;
+    }
+    for (SOCKET hSocket : error_select_set) {
+        FD_SET(hSocket, &fdsetError);
+        hSocketMax = std::max(hSocketMax, hSocket);
+        have_fds = true;
+    }
+
+    wakeupSelectNeeded = true;
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    wakeupSelectNeeded = false;
+    if (interruptNet)
+        return;
+
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+        {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
+        }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
+            return;
+    }
+
+    for (SOCKET hSocket : recv_select_set) {
+        if (FD_ISSET(hSocket, &fdsetRecv)) {
+            recv_set.insert(hSocket);
+        }
+    }
+    for (SOCKET hSocket : send_select_set) {
+        if (FD_ISSET(hSocket, &fdsetSend)) {
+            send_set.insert(hSocket);
+        }
+    }
+    for (SOCKET hSocket : error_select_set) {
+        if (FD_ISSET(hSocket, &fdsetError)) {
+            error_set.insert(hSocket);
+        }
+    }
+}
+
+CConnman::SocketHandlerStats CConnman::GetSocketHandlerStats() const
+{
+    SocketHandlerStats stats;
+    stats.nLoops = nSocketHandlerLoops;
+    stats.nBusyTime = nSocketHandlerBusyTime;
+    stats.nLastBusyTime = nSocketHandlerLastBusyTime;
+    return stats;
+}
+
 void CConnman::WakeMessageHandler()
 {
     {
@@ -1523,6 +1830,17 @@ void CConnman::WakeMessageHandler()
     condMsgProc.notify_one();
 }
 
+bool CConnman::PushMessageWork(std::function<void()>&& func)
+{
+    if (!messageWorkerPool || flagInterruptMsgProc) {
+        return false;
+    }
+    messageWorkerPool->push([func](int threadId) {
+        func();
+    });
+    return true;
+}
+
 void CConnman::WakeSelect()
 {
 #ifndef WIN32
@@ -2201,6 +2519,7 @@ bool CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         pnode->fMasternode = true;
 
     GetNodeSignals().InitializeNode(pnode, *this);
+    RegisterEvents(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
@@ -2469,6 +2788,9 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
     nReceiveFloodSize = connOptions.nReceiveFloodSize;
 
+    socketEventsMode = connOptions.socketEventsMode;
+    nMessageWorkers = std::max(0, std::min(connOptions.nMessageWorkers, MAX_MESSAGE_WORKERS));
+
     nMaxOutboundLimit = connOptions.nMaxOutboundLimit;
     nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
 
@@ -2555,6 +2877,34 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     }
 #endif
 
+#if HAVE_EPOLL
+    if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == -1) {
+            LogPrintf("epoll_create1 failed (%s), falling back to select()\n", NetworkErrorString(WSAGetLastError()));
+            socketEventsMode = SOCKETEVENTS_SELECT;
+        } else {
+            // listen sockets and the wakeup pipe are level-triggered, we only accept one connection per loop
+            std::vector<SOCKET> vLevelTriggered;
+            for (const ListenSocket& hListenSocket : vhListenSocket) {
+                vLevelTriggered.emplace_back(hListenSocket.socket);
+            }
+            if (wakeupPipe[0] != -1) {
+                vLevelTriggered.emplace_back(wakeupPipe[0]);
+            }
+            for (SOCKET hSocket : vLevelTriggered) {
+                epoll_event e;
+                e.events = EPOLLIN;
+                e.data.fd = hSocket;
+                if (epoll_ctl(epollFd, EPOLL_CTL_ADD, hSocket, &e) != 0) {
+                    LogPrintf("epoll_ctl failed (%s)\n", NetworkErrorString(WSAGetLastError()));
+                }
+            }
+        }
+    }
+#endif
+    LogPrintf("Using %s for socket events\n", GetSocketEventsModeStr(socketEventsMode));
+
     // Send and receive from sockets, accept connections
     threadSocketHandler = std::thread(&TraceThread<std::function<void()> >, "net", std::function<void()>(std::bind(&CConnman::ThreadSocketHandler, this)));
 
@@ -2574,6 +2924,10 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     threadOpenMasternodeConnections = std::thread(&TraceThread<std::function<void()> >, "mncon", std::function<void()>(std::bind(&CConnman::ThreadOpenMasternodeConnections, this)));
 
     // Process messages
+    if (nMessageWorkers > 0) {
+        messageWorkerPool.reset(new ctpl::thread_pool(nMessageWorkers));
+        RenameThreadPool(*messageWorkerPool, "dash-msg-worker");
+    }
     threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
 
     // Dump network addresses
@@ -2640,6 +2994,11 @@ void CConnman::Stop()
 {
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
+    // workers hold references to nodes, so make sure they are done before we delete the nodes
+    if (messageWorkerPool) {
+        messageWorkerPool->stop(true);
+        messageWorkerPool.reset();
+    }
     if (threadOpenMasternodeConnections.joinable())
         threadOpenMasternodeConnections.join();
     if (threadOpenConnections.joinable())
@@ -2687,6 +3046,11 @@ void CConnman::Stop()
     if (wakeupPipe[1] != -1) close(wakeupPipe[1]);
     wakeupPipe[0] = wakeupPipe[1] = -1;
 #endif
+
+#if HAVE_EPOLL
+    if (epollFd != -1) close(epollFd);
+    epollFd = -1;
+#endif
 }
 
 void CConnman::DeleteNode(CNode* pnode)
@@ -2968,7 +3332,10 @@ void CConnman::RelayInvFiltered(CInv &inv, const uint256& relatedTxHash, const i
 
 void CConnman::RemoveAskFor(const uint256& hash)
 {
-    mapAlreadyAskedFor.erase(hash);
+    {
+        LOCK(cs_askFor);
+        mapAlreadyAskedFor.erase(hash);
+    }
 
     LOCK(cs_vNodes);
     for (const auto& pnode : vNodes) {
@@ -3191,6 +3558,7 @@ CNode::~CNode()
 
 void CNode::AskFor(const CInv& inv, int64_t doubleRequestDelay)
 {
+    LOCK(cs_askFor);
     if (vecAskFor.size() > MAPASKFOR_MAX_SZ || setAskFor.size() > SETASKFOR_MAX_SZ) {
         int64_t nNow = GetTime();
         if(nNow - nLastWarningTime > WARNING_INTERVAL) {
@@ -3238,6 +3606,7 @@ void CNode::AskFor(const CInv& inv, int64_t doubleRequestDelay)
 
 void CNode::RemoveAskFor(const uint256& hash)
 {
+    LOCK(cs_askFor);
     if (setAskFor.erase(hash)) {
         vecAskFor.erase(std::remove_if(vecAskFor.begin(), vecAskFor.end(), [&](const std::pair<int64_t, CInv>& item) {
             return item.second.hash == hash;
@@ -3245,6 +3614,32 @@ void CNode::RemoveAskFor(const uint256& hash)
     }
 }
 
+size_t CNode::GetAskForSize() const
+{
+    LOCK(cs_askFor);
+    return setAskFor.size();
+}
+
+std::vector<CInv> CNode::PopDueAskFor(int64_t nNow)
+{
+    LOCK(cs_askFor);
+    std::sort(vecAskFor.begin(), vecAskFor.end());
+    auto it = vecAskFor.begin();
+    std::vector<CInv> vInv;
+    while (it != vecAskFor.end() && it->first <= nNow) {
+        vInv.emplace_back(it->second);
+        ++it;
+    }
+    vecAskFor.erase(vecAskFor.begin(), it);
+    return vInv;
+}
+
+void CNode::ForgetAskFor(const uint256& hash)
+{
+    LOCK(cs_askFor);
+    setAskFor.erase(hash);
+}
+
 bool CConnman::NodeFullyConnected(const CNode* pnode)
 {
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
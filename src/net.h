@@ -22,6 +22,7 @@
 #include "util.h"
 #include "threadinterrupt.h"
 #include "consensus/params.h"
+#include "ctpl.h"
 
 #include <atomic>
 #include <deque>
@@ -110,6 +111,25 @@ static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 
+/** Number of threads which process messages that don't need cs_main in parallel to the message handler thread */
+static const int DEFAULT_MESSAGE_WORKERS = 2;
+static const int MAX_MESSAGE_WORKERS = 16;
+
+/** How the socket handler waits for socket events (-socketevents) */
+enum SocketEventsMode {
+    SOCKETEVENTS_SELECT = 0,
+    SOCKETEVENTS_EPOLL = 1,
+};
+#if HAVE_EPOLL
+static const SocketEventsMode DEFAULT_SOCKETEVENTS = SOCKETEVENTS_EPOLL;
+#else
+static const SocketEventsMode DEFAULT_SOCKETEVENTS = SOCKETEVENTS_SELECT;
+#endif
+/** Parses the -socketevents value. Returns false if the mode is unknown or not supported on this platform */
+bool ParseSocketEventsMode(const std::string& str, SocketEventsMode& modeOut);
+std::string GetSocketEventsModeStr(SocketEventsMode mode);
+std::string GetSupportedSocketEventsModesStr();
+
 static const ServiceFlags REQUIRED_SERVICES = NODE_NETWORK;
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
@@ -168,6 +188,8 @@ public:
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
+        SocketEventsMode socketEventsMode = DEFAULT_SOCKETEVENTS;
+        int nMessageWorkers = DEFAULT_MESSAGE_WORKERS;
     };
     CConnman(uint64_t seed0, uint64_t seed1);
     ~CConnman();
@@ -422,9 +444,26 @@ public:
 
     unsigned int GetReceiveFloodSize() const;
 
+    SocketEventsMode GetSocketEventsMode() const { return socketEventsMode; }
+
+    struct SocketHandlerStats {
+        uint64_t nLoops;
+        // accumulated time spent outside of select()/epoll_wait(), in microseconds
+        int64_t nBusyTime;
+        // busy time of the last loop, in microseconds
+        int64_t nLastBusyTime;
+    };
+    SocketHandlerStats GetSocketHandlerStats() const;
+
     void WakeMessageHandler();
     void WakeSelect();
 
+    /**
+     * Runs func on the message worker pool. Returns false if there are no message workers, in which case the caller
+     * has to do the work on the message handler thread itself.
+     */
+    bool PushMessageWork(std::function<void()>&& func);
+
 private:
     struct ListenSocket {
         SOCKET socket;
@@ -439,6 +478,16 @@ private:
     void ThreadMessageHandler();
     void AcceptConnection(const ListenSocket& hListenSocket);
     void ThreadSocketHandler();
+
+    bool IsSocketUsable(SOCKET hSocket) const;
+    void RegisterEvents(CNode* pnode);
+    // Waits for socket events and fills the sets with sockets that became readable, writable or errored.
+    // fOnlyPoll means that there is still work left from the last loop, so we must not block
+    void SocketEvents(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set, bool fOnlyPoll);
+    void SocketEventsSelect(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set, bool fOnlyPoll);
+#if HAVE_EPOLL
+    void SocketEventsEpoll(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set, bool fOnlyPoll);
+#endif
     void ThreadDNSAddressSeed();
     void ThreadOpenMasternodeConnections();
 
@@ -540,6 +589,9 @@ private:
     std::mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc;
 
+    int nMessageWorkers{0};
+    std::unique_ptr<ctpl::thread_pool> messageWorkerPool;
+
     CThreadInterrupt interruptNet;
 
 #ifndef WIN32
@@ -548,6 +600,15 @@ private:
 #endif
     std::atomic<bool> wakeupSelectNeeded{false};
 
+    SocketEventsMode socketEventsMode{DEFAULT_SOCKETEVENTS};
+#if HAVE_EPOLL
+    int epollFd{-1};
+#endif
+
+    std::atomic<uint64_t> nSocketHandlerLoops{0};
+    std::atomic<int64_t> nSocketHandlerBusyTime{0};
+    std::atomic<int64_t> nSocketHandlerLastBusyTime{0};
+
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
@@ -620,6 +681,8 @@ extern bool fDiscover;
 extern bool fListen;
 extern bool fRelayTxes;
 
+/** Guards mapAlreadyAskedFor and the setAskFor/vecAskFor of all nodes. Never take other locks while holding it */
+extern CCriticalSection cs_askFor;
 extern unordered_limitedmap<uint256, int64_t, StaticSaltedHasher> mapAlreadyAskedFor;
 
 /** Subversion as sent to the P2P network in `version` messages */
@@ -706,8 +769,20 @@ public:
 
     int readHeader(const char *pch, unsigned int nBytes);
     int readData(const char *pch, unsigned int nBytes);
+
+    /**
+     * Makes room for up to nMaxBytes of message data in vRecv and returns a pointer to where it must be written. This
+     * allows to recv() directly into the message instead of going through a temporary buffer. Returns the number of
+     * bytes which may be written, which is never more than what is missing for the message to be complete.
+     */
+    unsigned int prepareDirectRead(char*& pchOut, unsigned int nMaxBytes);
+    /** Marks nBytes written to the pointer returned by prepareDirectRead as received */
+    void commitDirectRead(unsigned int nBytes);
 };
 
+/** Messages with at least this many bytes missing are received directly into CNetMessage::vRecv */
+static const unsigned int DIRECT_RECV_MIN_SIZE = 64 * 1024;
+
 
 /** Information about a peer */
 class CNode
@@ -779,6 +854,19 @@ public:
 
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+
+    // Readiness of the socket as last reported by select()/epoll. With edge-triggered epoll, readiness is only
+    // reported once, so these stay set until a recv()/send() call tells us that the socket would block.
+    // fCanSendData is only written with cs_vSend held, so that a new edge can't be lost to a concurrent send()
+    std::atomic_bool fHasRecvData{false};
+    std::atomic_bool fCanSendData{false};
+    // Set when epoll reported an error or a hangup. What the peer sent before is still received, it is disconnected
+    // once the socket is drained
+    std::atomic_bool fSocketHangup{false};
+
+    // Set while messages of this peer are being processed by the message worker pool. No other messages of this peer
+    // are processed in the meantime, so that per-peer message ordering is preserved
+    std::atomic_bool fMessageWorkInFlight{false};
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
@@ -808,6 +896,7 @@ public:
     // List of non-tx/non-block inventory items
     std::vector<CInv> vInventoryOtherToSend;
     CCriticalSection cs_inventory;
+    // protected by cs_askFor
     std::unordered_set<uint256, StaticSaltedHasher> setAskFor;
     std::vector<std::pair<int64_t, CInv>> vecAskFor;
     int64_t nNextInvSend;
@@ -892,6 +981,20 @@ public:
 
     bool ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete);
 
+    /**
+     * If the message currently being received still misses at least DIRECT_RECV_MIN_SIZE bytes of data, returns a
+     * pointer into its receive buffer, so that the socket can be read into it without copying. nBytes is set to the
+     * number of bytes which may be received. Must only be called from the socket handler thread.
+     */
+    bool GetDirectRecvBuffer(char*& pch, unsigned int& nBytes);
+    /** Accounts for nBytes which were received into the buffer returned by GetDirectRecvBuffer */
+    void CommitDirectRecv(unsigned int nBytes, bool& complete);
+
+private:
+    void OnMessageComplete(CNetMessage& msg, int64_t nTimeMicros);
+
+public:
+
     void SetRecvVersion(int nVersionIn)
     {
         nRecvVersion = nVersionIn;
@@ -990,6 +1093,10 @@ public:
 
     void AskFor(const CInv& inv, int64_t doubleRequestDelay = 2 * 60 * 1000000);
     void RemoveAskFor(const uint256& hash);
+    size_t GetAskForSize() const;
+    // Removes and returns the requests which are due at nNow
+    std::vector<CInv> PopDueAskFor(int64_t nNow);
+    void ForgetAskFor(const uint256& hash);
 
     void CloseSocketDisconnect();
 
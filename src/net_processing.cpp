@@ -11,6 +11,7 @@
 #include "blockencodings.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
+#include "core_memusage.h"
 #include "hash.h"
 #include "init.h"
 #include "validation.h"
@@ -56,6 +57,8 @@
 #include "llmq/quorums_signing.h"
 #include "llmq/quorums_signing_shares.h"
 
+#include <deque>
+
 #include <boost/thread.hpp>
 
 #if defined(NDEBUG)
@@ -88,6 +91,19 @@ void EraseOrphansFor(NodeId peer);
 
 static size_t vExtraTxnForCompactIt GUARDED_BY(g_cs_orphans) = 0;
 static std::vector<std::pair<uint256, CTransactionRef>> vExtraTxnForCompact GUARDED_BY(g_cs_orphans);
+static size_t nMaxExtraTxnForCompact = DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN; // -blockreconstructionextratxn, set in PeerLogicValidation
+
+/**
+ * Transactions likely to be mined soon which are not (or no longer) in our mempool, see AddToCompactRetainedTransactions.
+ * Entries are kept in arrival order; evicted and mined ones leave a null hole, which InitData skips, until there
+ * are more holes than entries and the vector is compacted.
+ */
+static CCriticalSection cs_retainedTxnForCompact;
+static std::vector<std::pair<uint256, CTransactionRef>> vRetainedTxnForCompact GUARDED_BY(cs_retainedTxnForCompact);
+static std::map<uint256, size_t> mapRetainedTxnForCompact GUARDED_BY(cs_retainedTxnForCompact); // position in vRetainedTxnForCompact
+static size_t nRetainedTxnForCompactBegin GUARDED_BY(cs_retainedTxnForCompact) = 0; // first entry which is not a hole
+static size_t nRetainedTxnForCompactUsage GUARDED_BY(cs_retainedTxnForCompact) = 0;
+static size_t nMaxRetainedTxnForCompactUsage = DEFAULT_BLOCK_RECONSTRUCTION_RETAINED_SIZE * 1000000; // -blockreconstructionretainedsize
 
 static const uint64_t RANDOMIZER_ID_ADDRESS_RELAY = 0x3cac0035b5866b90ULL; // SHA256("main address relay")[0:8]
 
@@ -142,6 +158,7 @@ namespace {
         const CBlockIndex* pindex;                               //!< Optional.
         bool fValidatedHeaders;                                  //!< Whether this block has validated headers at the time of request.
         std::unique_ptr<PartiallyDownloadedBlock> partialBlock;  //!< Optional, used for CMPCTBLOCK downloads
+        int64_t nTimeGetBlockTxn;                                //!< When we sent GETBLOCKTXN for partialBlock (in microseconds), or 0.
     };
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight;
 
@@ -234,6 +251,16 @@ struct CNodeState {
      * otherwise: whether this peer sends non-last version in cmpctblocks/blocktxns.
      */
     bool fSupportsDesiredCmpctVersion;
+    //! Compact blocks from this peer we tried to reconstruct, and how many of them needed no GETBLOCKTXN.
+    int nCmpctBlocks;
+    int nCmpctBlocksReconstructed;
+    //! Transactions of those blocks we had (prefilled ones excluded), of which from the retained pool, and requested.
+    int64_t nCmpctTxnLocal;
+    int64_t nCmpctTxnRetained;
+    int64_t nCmpctTxnRequested;
+    //! Number and total time (in microseconds) of GETBLOCKTXN round trips to this peer.
+    int nGetBlockTxnReplies;
+    int64_t nGetBlockTxnTime;
 
     CNodeState(CAddress addrIn, std::string addrNameIn) : address(addrIn), name(addrNameIn) {
         fCurrentlyConnected = false;
@@ -255,6 +282,13 @@ struct CNodeState {
         fPreferHeaderAndIDs = false;
         fProvidesHeaderAndIDs = false;
         fSupportsDesiredCmpctVersion = false;
+        nCmpctBlocks = 0;
+        nCmpctBlocksReconstructed = 0;
+        nCmpctTxnLocal = 0;
+        nCmpctTxnRetained = 0;
+        nCmpctTxnRequested = 0;
+        nGetBlockTxnReplies = 0;
+        nGetBlockTxnTime = 0;
     }
 };
 
@@ -396,7 +430,7 @@ bool MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const Consensus::Pa
     MarkBlockAsReceived(hash);
 
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(),
-            {hash, pindex, pindex != NULL, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&mempool) : NULL)});
+            {hash, pindex, pindex != NULL, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&mempool) : NULL), 0});
     state->nBlocksInFlight++;
     state->nBlocksInFlightValidHeaders += it->fValidatedHeaders;
     if (state->nBlocksInFlight == 1) {
@@ -613,6 +647,13 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
         if (queue.pindex)
             stats.vHeightInFlight.push_back(queue.pindex->nHeight);
     }
+    stats.nCmpctBlocks = state->nCmpctBlocks;
+    stats.nCmpctBlocksReconstructed = state->nCmpctBlocksReconstructed;
+    stats.nCmpctTxnLocal = state->nCmpctTxnLocal;
+    stats.nCmpctTxnRetained = state->nCmpctTxnRetained;
+    stats.nCmpctTxnRequested = state->nCmpctTxnRequested;
+    stats.nGetBlockTxnReplies = state->nGetBlockTxnReplies;
+    stats.nGetBlockTxnTime = state->nGetBlockTxnTime;
     return true;
 }
 
@@ -637,15 +678,90 @@ void UnregisterNodeSignals(CNodeSignals& nodeSignals)
 // mapOrphanTransactions
 //
 
+/**
+ * Transactions we expect to be mined even when they are not in our mempool:
+ * BiblePay special transactions, GSC transmissions and ABN transactions, which
+ * are large and predictable, so missing them costs a GETBLOCKTXN round trip.
+ */
+static bool IsRetainedForCompact(const CTransaction& tx)
+{
+    return (tx.nVersion == 3 && tx.nType != TRANSACTION_NORMAL) || tx.IsGSCTransmission() || tx.IsABN();
+}
+
+static void EraseCompactRetainedTransaction(size_t nPos) EXCLUSIVE_LOCKS_REQUIRED(cs_retainedTxnForCompact)
+{
+    std::pair<uint256, CTransactionRef>& entry = vRetainedTxnForCompact[nPos];
+    nRetainedTxnForCompactUsage -= RecursiveDynamicUsage(*entry.second);
+    mapRetainedTxnForCompact.erase(entry.first);
+    entry.second.reset();
+    while (nRetainedTxnForCompactBegin < vRetainedTxnForCompact.size() && !vRetainedTxnForCompact[nRetainedTxnForCompactBegin].second)
+        nRetainedTxnForCompactBegin++;
+
+    if (vRetainedTxnForCompact.size() - mapRetainedTxnForCompact.size() <= mapRetainedTxnForCompact.size())
+        return;
+    size_t nLive = 0;
+    for (size_t i = nRetainedTxnForCompactBegin; i < vRetainedTxnForCompact.size(); i++) {
+        if (!vRetainedTxnForCompact[i].second)
+            continue;
+        mapRetainedTxnForCompact[vRetainedTxnForCompact[i].first] = nLive;
+        if (i != nLive)
+            vRetainedTxnForCompact[nLive] = std::move(vRetainedTxnForCompact[i]);
+        nLive++;
+    }
+    vRetainedTxnForCompact.resize(nLive);
+    nRetainedTxnForCompactBegin = 0;
+}
+
+/**
+ * Keep an islocked transaction, or one of the retained classes which left the
+ * mempool, for compact block reconstruction in the retained pool. It has its
+ * own memory budget (-blockreconstructionretainedsize) and only takes
+ * transactions which were accepted, so that orphans and rejected transactions,
+ * which go to vExtraTxnForCompact, can't push these out. Oldest entries are
+ * dropped first.
+ */
+static void AddToCompactRetainedTransactions(const CTransactionRef& tx)
+{
+    size_t nUsage = RecursiveDynamicUsage(*tx);
+    if (nUsage > nMaxRetainedTxnForCompactUsage / 16)
+        return;
+
+    LOCK(cs_retainedTxnForCompact);
+    if (!mapRetainedTxnForCompact.emplace(tx->GetHash(), vRetainedTxnForCompact.size()).second)
+        return;
+    vRetainedTxnForCompact.emplace_back(tx->GetHash(), tx);
+    nRetainedTxnForCompactUsage += nUsage;
+    while (nRetainedTxnForCompactUsage > nMaxRetainedTxnForCompactUsage)
+        EraseCompactRetainedTransaction(nRetainedTxnForCompactBegin);
+}
+
+/** Drop a mined transaction from the retained pool, as it won't show up in another block */
+static void RemoveMinedCompactRetainedTransaction(const uint256& hash)
+{
+    LOCK(cs_retainedTxnForCompact);
+    std::map<uint256, size_t>::iterator it = mapRetainedTxnForCompact.find(hash);
+    if (it != mapRetainedTxnForCompact.end())
+        EraseCompactRetainedTransaction(it->second);
+}
+
+/** Mempool removal hook, keeping transactions of the retained classes which were not mined */
+static void RetainRemovedTransaction(CTransactionRef tx, MemPoolRemovalReason reason)
+{
+    // A transaction which was mined or conflicts with a block won't show up in another block
+    if (reason == MemPoolRemovalReason::BLOCK || reason == MemPoolRemovalReason::CONFLICT)
+        return;
+    if (IsRetainedForCompact(*tx))
+        AddToCompactRetainedTransactions(tx);
+}
+
 void AddToCompactExtraTransactions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
 {
-    size_t max_extra_txn = GetArg("-blockreconstructionextratxn", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN);
-    if (max_extra_txn <= 0)
+    if (nMaxExtraTxnForCompact <= 0)
         return;
     if (!vExtraTxnForCompact.size())
-        vExtraTxnForCompact.resize(max_extra_txn);
+        vExtraTxnForCompact.resize(nMaxExtraTxnForCompact);
     vExtraTxnForCompact[vExtraTxnForCompactIt] = std::make_pair(tx->GetHash(), tx);
-    vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % max_extra_txn;
+    vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % nMaxExtraTxnForCompact;
 }
 
 bool AddOrphanTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
@@ -816,12 +932,28 @@ static bool BlockRequestAllowed(const CBlockIndex* pindex, const Consensus::Para
 PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn) : connman(connmanIn) {
     // Initialize global variables that cannot be constructed at startup.
     recentRejects.reset(new CRollingBloomFilter(120000, 0.000001));
+    nMaxExtraTxnForCompact = std::max((int64_t)0, GetArg("-blockreconstructionextratxn", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
+    nMaxRetainedTxnForCompactUsage = std::max((int64_t)0, GetArg("-blockreconstructionretainedsize", DEFAULT_BLOCK_RECONSTRUCTION_RETAINED_SIZE)) * 1000000;
+    mempool.NotifyEntryRemoved.connect(&RetainRemovedTransaction);
+}
+
+PeerLogicValidation::~PeerLogicValidation() {
+    mempool.NotifyEntryRemoved.disconnect(&RetainRemovedTransaction);
+}
+
+void PeerLogicValidation::NotifyTransactionLock(const CTransaction& tx) {
+    // Islocked transactions are as good as mined, keep them even if they
+    // leave our mempool. Share the mempool's copy where there is one.
+    CTransactionRef ptx = mempool.get(tx.GetHash());
+    AddToCompactRetainedTransactions(ptx ? ptx : MakeTransactionRef(tx));
 }
 
 void PeerLogicValidation::SyncTransaction(const CTransaction& tx, const CBlockIndex* pindex, int nPosInBlock) {
     if (nPosInBlock == CMainSignals::SYNC_TRANSACTION_NOT_IN_BLOCK)
         return;
 
+    RemoveMinedCompactRetainedTransaction(tx.GetHash());
+
     LOCK(g_cs_orphans);
 
     std::vector<uint256> vOrphanErase;
@@ -2538,7 +2670,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 }
 
                 PartiallyDownloadedBlock& partialBlock = *(*queuedBlockIt)->partialBlock;
-                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact, vRetainedTxnForCompact, &cs_retainedTxnForCompact);
                 if (status == READ_STATUS_INVALID) {
                     MarkBlockAsReceived(pindex->GetBlockHash()); // Reset in-flight state in case of whitelist
                     Misbehaving(pfrom->GetId(), 100);
@@ -2557,7 +2689,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                     if (!partialBlock.IsTxAvailable(i))
                         req.indexes.push_back(i);
                 }
+                nodestate->nCmpctBlocks++;
+                nodestate->nCmpctTxnLocal += partialBlock.GetLocalCount();
+                nodestate->nCmpctTxnRetained += partialBlock.GetRetainedCount();
+                nodestate->nCmpctTxnRequested += req.indexes.size();
+                LogPrint("cmpctblock", "Compact block %s from peer=%d: %u txn found (%u from retained pool), %u txn missing\n",
+                    pindex->GetBlockHash().ToString(), pfrom->id, partialBlock.GetLocalCount(), partialBlock.GetRetainedCount(), req.indexes.size());
                 if (req.indexes.empty()) {
+                    nodestate->nCmpctBlocksReconstructed++;
                     // Dirty hack to jump to BLOCKTXN code (TODO: move message handling into their own functions)
                     BlockTransactions txn;
                     txn.blockhash = cmpctblock.header.GetHash();
@@ -2565,6 +2704,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                     fProcessBLOCKTXN = true;
                 } else {
                     req.blockhash = pindex->GetBlockHash();
+                    (*queuedBlockIt)->nTimeGetBlockTxn = GetTimeMicros();
                     connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::GETBLOCKTXN, req));
                 }
             } else {
@@ -2574,14 +2714,18 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 // Optimistically try to reconstruct anyway since we might be
                 // able to without any round trips.
                 PartiallyDownloadedBlock tempBlock(&mempool);
-                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact, vRetainedTxnForCompact, &cs_retainedTxnForCompact);
                 if (status != READ_STATUS_OK) {
                     // TODO: don't ignore failures
                     return true;
                 }
+                nodestate->nCmpctBlocks++;
+                nodestate->nCmpctTxnLocal += tempBlock.GetLocalCount();
+                nodestate->nCmpctTxnRetained += tempBlock.GetRetainedCount();
                 std::vector<CTransactionRef> dummy;
                 status = tempBlock.FillBlock(*pblock, dummy);
                 if (status == READ_STATUS_OK) {
+                    nodestate->nCmpctBlocksReconstructed++;
                     fBlockReconstructed = true;
                 }
             }
@@ -2651,6 +2795,12 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 return true;
             }
 
+            if (it->second.second->nTimeGetBlockTxn) {
+                CNodeState *nodestate = State(pfrom->GetId());
+                nodestate->nGetBlockTxnReplies++;
+                nodestate->nGetBlockTxnTime += GetTimeMicros() - it->second.second->nTimeGetBlockTxn;
+            }
+
             PartiallyDownloadedBlock& partialBlock = *it->second.second->partialBlock;
             ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn);
             if (status == READ_STATUS_INVALID) {
@@ -2724,7 +2874,13 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // Hash the headers before taking cs_main, the checks below and ProcessNewBlockHeaders use the memoized hashes
+        for (const CBlockHeader& header : headers) {
+            header.GetHash();
+        }
+
         const CBlockIndex *pindexLast = NULL;
+        std::vector<CHeaderPoWPrecheck> vPrecheck;
         {
         LOCK(cs_main);
         CNodeState *nodestate = State(pfrom->GetId());
@@ -2764,10 +2920,13 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             }
             hashLastBlock = header.GetHash();
         }
+
+        // Under the same lock, so that ProcessNewBlockHeaders only takes cs_main again to accept the headers
+        PrepareHeadersPoW(headers, vPrecheck);
         }
 
         CValidationState state;
-        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast)) {
+        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &vPrecheck)) {
             int nDoS;
             if (state.IsInvalid(nDoS)) {
                 if (nDoS > 0) {
@@ -3195,6 +3354,166 @@ static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman& connman)
     return false;
 }
 
+/**
+ * Messages which don't need cs_main to be processed. These are handed to the message worker pool (see
+ * CConnman::PushMessageWork) so that floods of them (e.g. governance votes or LLMQ sig shares) can't delay block and
+ * transaction relay, which is still handled by the message handler thread.
+ */
+static const std::set<std::string> setAsyncMessageTypes = {
+    NetMsgType::QSIGSHARESINV,
+    NetMsgType::QBSIGSHARES,
+    NetMsgType::ISLOCK,
+    NetMsgType::MNGOVERNANCEOBJECTVOTE,
+    NetMsgType::SPORK,
+    NetMsgType::MNAUTH,
+};
+
+/** Maximum number of consecutive messages of one peer which are handed to the message worker pool at once */
+static const size_t MAX_ASYNC_MESSAGES_BATCH = 100;
+
+static CCriticalSection cs_asyncMessageStats;
+static std::map<std::string, CAsyncMessageStats> mapAsyncMessageStats GUARDED_BY(cs_asyncMessageStats);
+
+std::map<std::string, CAsyncMessageStats> GetAsyncMessageStats()
+{
+    LOCK(cs_asyncMessageStats);
+    return mapAsyncMessageStats;
+}
+
+/**
+ * Verifies header and checksum of a message and processes it. Returns false if the message was invalid and thus not
+ * processed.
+ */
+static bool ProcessNetMessage(CNode* pfrom, CNetMessage& msg, const CChainParams& chainparams, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
+{
+    msg.SetVersion(pfrom->GetRecvVersion());
+    // Scan for message start
+    if (memcmp(msg.hdr.pchMessageStart, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE) != 0) {
+        LogPrintf("PROCESSMESSAGE: INVALID MESSAGESTART %s peer=%d\n", SanitizeString(msg.hdr.GetCommand()), pfrom->id);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    // Read header
+    CMessageHeader& hdr = msg.hdr;
+    if (!hdr.IsValid(chainparams.MessageStart()))
+    {
+        LogPrintf("PROCESSMESSAGE: ERRORS IN HEADER %s peer=%d\n", SanitizeString(hdr.GetCommand()), pfrom->id);
+        return false;
+    }
+    std::string strCommand = hdr.GetCommand();
+
+    // Message size
+    unsigned int nMessageSize = hdr.nMessageSize;
+
+    // Checksum
+    CDataStream& vRecv = msg.vRecv;
+    const uint256& hash = msg.GetMessageHash();
+    if (memcmp(hash.begin(), hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) != 0)
+    {
+        LogPrintf("%s(%s, %u bytes): CHECKSUM ERROR expected %s was %s\n", __func__,
+           SanitizeString(strCommand), nMessageSize,
+           HexStr(hash.begin(), hash.begin()+CMessageHeader::CHECKSUM_SIZE),
+           HexStr(hdr.pchChecksum, hdr.pchChecksum+CMessageHeader::CHECKSUM_SIZE));
+        return false;
+    }
+
+    // Process message
+    bool fRet = false;
+    try
+    {
+        fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+        if (interruptMsgProc)
+            return false;
+    }
+    catch (const std::ios_base::failure& e)
+    {
+        connman.PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
+        if (strstr(e.what(), "end of data"))
+        {
+            // Allow exceptions from under-length message on vRecv
+				if (fDebugSpam)
+					LogPrintf("%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+				// R Andrews - We have two messages in classic (mnp, 147 bytes) && (govobjvote, 155 bytes) throwing this error; we can remove the debug master after the supermajority upgrades
+        }
+        else if (strstr(e.what(), "size too large"))
+        {
+            // Allow exceptions from over-long size
+				if (strCommand == "mnw")
+				{
+					// This placeholder is reserved for a Log Message.  We must wait until all biblepay-classic sanctuaries are retired (as they are still sending this oversized message).
+					// We have confirmed the deterministic nodes can cope with this temporary spam.
+				}
+				else
+				{
+					LogPrintf("%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+				}
+        }
+        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
+        {
+            // Allow exceptions from non-canonical encoding
+            LogPrintf("%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else
+        {
+            PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+        }
+    } catch (...) {
+        PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+    }
+
+    if (!fRet) 
+		{
+			if (strCommand != "mnw" && strCommand != "govobjvote")
+			{				
+				LogPrintf("%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->id);
+			}
+    }
+
+    return true;
+}
+
+/**
+ * Processes a batch of messages of one peer on the message worker pool. Only one batch per peer is in flight at any
+ * time, so that the messages of a peer are processed in the order they were received.
+ */
+static void ProcessAsyncMessages(CNode* pfrom, std::shared_ptr<std::list<CNetMessage>> msgs, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
+{
+    const CChainParams& chainparams = Params();
+    size_t nProcessed = 0;
+    for (auto& msg : *msgs) {
+        if (interruptMsgProc || pfrom->fDisconnect) {
+            break;
+        }
+        nProcessed++;
+
+        std::string strCommand = msg.hdr.GetCommand();
+        int64_t nStartTime = GetTimeMicros();
+        ProcessNetMessage(pfrom, msg, chainparams, connman, interruptMsgProc);
+        int64_t nEndTime = GetTimeMicros();
+
+        LOCK(cs_asyncMessageStats);
+        CAsyncMessageStats& stats = mapAsyncMessageStats[strCommand];
+        stats.nQueued--;
+        stats.nProcessed++;
+        stats.nWaitTime += nStartTime - msg.nTime;
+        stats.nProcessTime += nEndTime - nStartTime;
+    }
+
+    // messages which were skipped due to shutdown/disconnect
+    if (nProcessed < msgs->size()) {
+        LOCK(cs_asyncMessageStats);
+        for (auto it = std::next(msgs->begin(), nProcessed); it != msgs->end(); ++it) {
+            mapAsyncMessageStats[it->hdr.GetCommand()].nQueued--;
+        }
+    }
+
+    pfrom->fMessageWorkInFlight = false;
+    pfrom->Release();
+    // the message handler thread might have skipped this peer while we were busy
+    connman.WakeMessageHandler();
+}
+
 bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3208,6 +3527,10 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
     //
     bool fMoreWork = false;
 
+    // the message worker pool is still busy with earlier messages of this peer. It will wake us up when it's done
+    if (pfrom->fMessageWorkInFlight)
+        return false;
+
     if (!pfrom->vRecvGetData.empty())
         ProcessGetData(pfrom, chainparams.GetConsensus(), connman, interruptMsgProc);
 
@@ -3221,104 +3544,46 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
         if (pfrom->fPauseSend)
             return false;
 
-        std::list<CNetMessage> msgs;
+        auto msgs = std::make_shared<std::list<CNetMessage>>();
+        bool fAsync;
         {
             LOCK(pfrom->cs_vProcessMsg);
             if (pfrom->vProcessMsg.empty())
                 return false;
-            // Just take one message
-            msgs.splice(msgs.begin(), pfrom->vProcessMsg, pfrom->vProcessMsg.begin());
-            pfrom->nProcessQueueSize -= msgs.front().vRecv.size() + CMessageHeader::HEADER_SIZE;
+            // Just take one message, unless we can hand it and the following ones to the message workers
+            fAsync = pfrom->fSuccessfullyConnected && setAsyncMessageTypes.count(pfrom->vProcessMsg.front().hdr.GetCommand());
+            do {
+                msgs->splice(msgs->end(), pfrom->vProcessMsg, pfrom->vProcessMsg.begin());
+                pfrom->nProcessQueueSize -= msgs->back().vRecv.size() + CMessageHeader::HEADER_SIZE;
+            } while (fAsync && msgs->size() < MAX_ASYNC_MESSAGES_BATCH && !pfrom->vProcessMsg.empty() &&
+                     setAsyncMessageTypes.count(pfrom->vProcessMsg.front().hdr.GetCommand()));
             pfrom->fPauseRecv = pfrom->nProcessQueueSize > connman.GetReceiveFloodSize();
             fMoreWork = !pfrom->vProcessMsg.empty();
         }
-        CNetMessage& msg(msgs.front());
-
-        msg.SetVersion(pfrom->GetRecvVersion());
-        // Scan for message start
-        if (memcmp(msg.hdr.pchMessageStart, chainparams.MessageStart(), CMessageHeader::MESSAGE_START_SIZE) != 0) {
-            LogPrintf("PROCESSMESSAGE: INVALID MESSAGESTART %s peer=%d\n", SanitizeString(msg.hdr.GetCommand()), pfrom->id);
-            pfrom->fDisconnect = true;
-            return false;
-        }
 
-        // Read header
-        CMessageHeader& hdr = msg.hdr;
-        if (!hdr.IsValid(chainparams.MessageStart()))
-        {
-            LogPrintf("PROCESSMESSAGE: ERRORS IN HEADER %s peer=%d\n", SanitizeString(hdr.GetCommand()), pfrom->id);
-            return fMoreWork;
-        }
-        std::string strCommand = hdr.GetCommand();
-
-        // Message size
-        unsigned int nMessageSize = hdr.nMessageSize;
-
-        // Checksum
-        CDataStream& vRecv = msg.vRecv;
-        const uint256& hash = msg.GetMessageHash();
-        if (memcmp(hash.begin(), hdr.pchChecksum, CMessageHeader::CHECKSUM_SIZE) != 0)
-        {
-            LogPrintf("%s(%s, %u bytes): CHECKSUM ERROR expected %s was %s\n", __func__,
-               SanitizeString(strCommand), nMessageSize,
-               HexStr(hash.begin(), hash.begin()+CMessageHeader::CHECKSUM_SIZE),
-               HexStr(hdr.pchChecksum, hdr.pchChecksum+CMessageHeader::CHECKSUM_SIZE));
-            return fMoreWork;
-        }
-
-        // Process message
-        bool fRet = false;
-        try
-        {
-            fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
-            if (interruptMsgProc)
-                return false;
-            if (!pfrom->vRecvGetData.empty())
-                fMoreWork = true;
-        }
-        catch (const std::ios_base::failure& e)
-        {
-            connman.PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
-            if (strstr(e.what(), "end of data"))
-            {
-                // Allow exceptions from under-length message on vRecv
-				if (fDebugSpam)
-					LogPrintf("%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-				// R Andrews - We have two messages in classic (mnp, 147 bytes) && (govobjvote, 155 bytes) throwing this error; we can remove the debug master after the supermajority upgrades
-            }
-            else if (strstr(e.what(), "size too large"))
-            {
-                // Allow exceptions from over-long size
-				if (strCommand == "mnw")
-				{
-					// This placeholder is reserved for a Log Message.  We must wait until all biblepay-classic sanctuaries are retired (as they are still sending this oversized message).
-					// We have confirmed the deterministic nodes can cope with this temporary spam.
-				}
-				else
-				{
-					LogPrintf("%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-				}
-            }
-            else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
+        if (fAsync) {
             {
-                // Allow exceptions from non-canonical encoding
-                LogPrintf("%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+                LOCK(cs_asyncMessageStats);
+                for (auto& msg : *msgs) {
+                    mapAsyncMessageStats[msg.hdr.GetCommand()].nQueued++;
+                }
             }
-            else
-            {
-                PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+            pfrom->fMessageWorkInFlight = true;
+            pfrom->AddRef();
+            if (connman.PushMessageWork(std::bind(&ProcessAsyncMessages, pfrom, msgs, std::ref(connman), std::ref(interruptMsgProc)))) {
+                // we'll be woken up by the worker when it's done
+                return false;
             }
-        } catch (...) {
-            PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+            // no workers, process them right here
+            ProcessAsyncMessages(pfrom, msgs, connman, interruptMsgProc);
+            return !interruptMsgProc && fMoreWork;
         }
 
-        if (!fRet) 
-		{
-			if (strCommand != "mnw" && strCommand != "govobjvote")
-			{				
-				LogPrintf("%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->id);
-			}
-        }
+        ProcessNetMessage(pfrom, msgs->front(), chainparams, connman, interruptMsgProc);
+        if (interruptMsgProc)
+            return false;
+        if (!pfrom->vRecvGetData.empty())
+            fMoreWork = true;
 
         LOCK(cs_main);
         SendRejectsAndCheckIfBanned(pfrom, connman);
@@ -3834,11 +4099,9 @@ bool SendMessages(CNode* pto, CConnman& connman, const std::atomic<bool>& interr
         //
         // Message: getdata (non-blocks)
         //
-        std::sort(pto->vecAskFor.begin(), pto->vecAskFor.end());
-        auto it = pto->vecAskFor.begin();
-        while (it != pto->vecAskFor.end() && it->first <= nNow)
+        // AlreadyHave takes other locks, so the due requests are taken out of vecAskFor first
+        for (const CInv& inv : pto->PopDueAskFor(nNow))
         {
-            const CInv& inv = it->second;
             if (!AlreadyHave(inv))
             {
                 if (fDebugSpam)
@@ -3855,11 +4118,9 @@ bool SendMessages(CNode* pto, CConnman& connman, const std::atomic<bool>& interr
                 //If we're not going to ask, don't expect a response.
                 if (fDebugSpam)
 					LogPrint("net", "SendMessages -- GETDATA -- already have inv = %s peer=%d\n", inv.ToString(), pto->id);
-                pto->setAskFor.erase(inv.hash);
+                pto->ForgetAskFor(inv.hash);
             }
-            ++it;
         }
-        pto->vecAskFor.erase(pto->vecAskFor.begin(), it);
         if (!vGetData.empty()) {
             connman.PushMessage(pto, msgMaker.Make(NetMsgType::GETDATA, vGetData));
             if (fDebugSpam)
@@ -23,6 +23,8 @@ static constexpr int64_t HEADERS_DOWNLOAD_TIMEOUT_PER_HEADER = 1000; // 1ms/head
 
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+/** Default memory budget in megabytes for islocked and special txn kept around for block reconstruction */
+static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_RETAINED_SIZE = 16;
 
 /** Register with a network node to receive its signals */
 void RegisterNodeSignals(CNodeSignals& nodeSignals);
@@ -35,11 +37,13 @@ private:
 
 public:
     PeerLogicValidation(CConnman* connmanIn);
+    ~PeerLogicValidation();
 
     virtual void SyncTransaction(const CTransaction& tx, const CBlockIndex* pindex, int nPosInBlock) override;
     virtual void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
     virtual void BlockChecked(const CBlock& block, const CValidationState& state) override;
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
+    virtual void NotifyTransactionLock(const CTransaction& tx) override;
 };
 
 struct CNodeStateStats {
@@ -47,6 +51,13 @@ struct CNodeStateStats {
     int nSyncHeight;
     int nCommonHeight;
     std::vector<int> vHeightInFlight;
+    int nCmpctBlocks;
+    int nCmpctBlocksReconstructed;
+    int64_t nCmpctTxnLocal;
+    int64_t nCmpctTxnRetained;
+    int64_t nCmpctTxnRequested;
+    int nGetBlockTxnReplies;
+    int64_t nGetBlockTxnTime;
 };
 
 /** Get statistics from node state */
@@ -55,6 +66,19 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 void Misbehaving(NodeId nodeid, int howmuch);
 bool IsBanned(NodeId nodeid);
 
+struct CAsyncMessageStats {
+    // messages currently waiting for or being processed by the message worker pool
+    int64_t nQueued{0};
+    int64_t nProcessed{0};
+    // accumulated time (in microseconds) between message receipt and start of processing
+    int64_t nWaitTime{0};
+    // accumulated time (in microseconds) spent processing messages
+    int64_t nProcessTime{0};
+};
+
+/** Get per message type statistics of the message worker pool */
+std::map<std::string, CAsyncMessageStats> GetAsyncMessageStats();
+
 /** Process protocol messages received from a given node */
 bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& interrupt);
 /**
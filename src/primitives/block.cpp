@@ -11,11 +11,32 @@
 #include "utilstrencodings.h"
 #include "crypto/common.h"
 
+std::atomic<uint64_t> CBlockHeader::nGetHashCount{0};
+std::atomic<uint64_t> CBlockHeader::nX11HashCount{0};
+
 uint256 CBlockHeader::GetHash() const
 {
-    std::vector<unsigned char> vch(80);
+    std::vector<unsigned char> vch(HEADER_SIZE);
+    CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, 0);
+    ss << *this;
+
+    nGetHashCount.fetch_add(1, std::memory_order_relaxed);
+    uint256 hash;
+    if (hashCache.Get(vch.data(), hash)) {
+        return hash;
+    }
+    nX11HashCount.fetch_add(1, std::memory_order_relaxed);
+    hash = HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+    hashCache.Set(vch.data(), hash);
+    return hash;
+}
+
+uint256 CBlockHeader::GetHashUncached() const
+{
+    std::vector<unsigned char> vch(HEADER_SIZE);
     CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, 0);
     ss << *this;
+    nX11HashCount.fetch_add(1, std::memory_order_relaxed);
     return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
 }
 
@@ -10,6 +10,76 @@
 #include "serialize.h"
 #include "uint256.h"
 
+#include <atomic>
+#include <string.h>
+
+/**
+ * Memory only X11 hash of a block header, keyed by the serialized header it was computed from, so that changing any
+ * header field can never return a stale hash. Lock free: the first thread to hash a header fills the cache, after
+ * which it is read only until Clear() is called by the owner of the header. A header changed without Clear() is
+ * hashed on every call, but still correctly.
+ */
+class CBlockHeaderHashCache
+{
+public:
+    static const size_t HEADER_SIZE = 80;
+
+private:
+    enum : uint8_t { EMPTY, WRITING, VALID };
+
+    mutable std::atomic<uint8_t> nState;
+    mutable unsigned char vchHeader[HEADER_SIZE];
+    mutable uint256 hash;
+
+    void CopyFrom(const CBlockHeaderHashCache& other)
+    {
+        // the object written to is owned by the calling thread, the one read from might be hashed concurrently
+        if (other.nState.load(std::memory_order_acquire) == VALID) {
+            memcpy(vchHeader, other.vchHeader, HEADER_SIZE);
+            hash = other.hash;
+            nState.store(VALID, std::memory_order_release);
+        } else {
+            nState.store(EMPTY, std::memory_order_release);
+        }
+    }
+
+public:
+    CBlockHeaderHashCache() : nState(EMPTY) {}
+    CBlockHeaderHashCache(const CBlockHeaderHashCache& other) : nState(EMPTY) { CopyFrom(other); }
+
+    CBlockHeaderHashCache& operator=(const CBlockHeaderHashCache& other)
+    {
+        if (this != &other) {
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    bool Get(const unsigned char* vchHeaderIn, uint256& hashRet) const
+    {
+        if (nState.load(std::memory_order_acquire) != VALID || memcmp(vchHeader, vchHeaderIn, HEADER_SIZE) != 0) {
+            return false;
+        }
+        hashRet = hash;
+        return true;
+    }
+
+    void Set(const unsigned char* vchHeaderIn, const uint256& hashIn) const
+    {
+        uint8_t nExpected = EMPTY;
+        if (nState.compare_exchange_strong(nExpected, WRITING, std::memory_order_acquire)) {
+            memcpy(vchHeader, vchHeaderIn, HEADER_SIZE);
+            hash = hashIn;
+            nState.store(VALID, std::memory_order_release);
+        }
+    }
+
+    void Clear()
+    {
+        nState.store(EMPTY, std::memory_order_release);
+    }
+};
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -29,6 +99,17 @@ public:
     uint32_t nNonce;
 	std::string sBlockMessage;
 
+    static const size_t HEADER_SIZE = CBlockHeaderHashCache::HEADER_SIZE;
+
+    // GetHash() calls (each of them ran X11 before hashes were memoized) and X11 hashes actually computed, for benchmarks
+    static std::atomic<uint64_t> nGetHashCount;
+    static std::atomic<uint64_t> nX11HashCount;
+
+private:
+    // memory only: memoized X11 hash, copied along with the header
+    CBlockHeaderHashCache hashCache;
+
+public:
     CBlockHeader()
     {
         SetNull();
@@ -38,6 +119,8 @@ public:
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
+        if (ser_action.ForRead())
+            hashCache.Clear();
         READWRITE(this->nVersion);
         READWRITE(hashPrevBlock);
         READWRITE(hashMerkleRoot);
@@ -55,6 +138,13 @@ public:
         nBits = 0;
         nNonce = 0;
 		sBlockMessage = "";
+        InvalidateHashCache();
+    }
+
+    // Must be called after changing a header which might have been hashed before, unless it is hashed uncached
+    void InvalidateHashCache()
+    {
+        hashCache.Clear();
     }
 
     bool IsNull() const
@@ -62,7 +152,11 @@ public:
         return (nBits == 0);
     }
 
+    // Returns the memoized X11 hash, recomputing it if the header changed since it was memoized
     uint256 GetHash() const;
+    // Always recomputes the X11 hash and leaves the cache untouched. Use this in loops which mutate the header on
+    // every iteration (e.g. nonce scanning), where the cache would only be filled with a hash never asked for again
+    uint256 GetHashUncached() const;
 	uint256 GetHashBible() const;
 
     int64_t GetBlockTime() const
@@ -109,15 +203,9 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion       = nVersion;
-        block.hashPrevBlock  = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime          = nTime;
-        block.nBits          = nBits;
-        block.nNonce         = nNonce;
-		block.sBlockMessage  = sBlockMessage;
-		return block;
+        // copies the header fields together with the memoized hash
+        CBlockHeader block(*this);
+        return block;
     }
 
     std::string ToString() const;
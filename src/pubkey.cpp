@@ -7,10 +7,48 @@
 #include <secp256k1.h>
 #include <secp256k1_recovery.h>
 
+#include <string.h>
+
 namespace
 {
 /* Global secp256k1_context object used for verification. */
 secp256k1_context* secp256k1_context_verify = NULL;
+
+/* Small direct mapped cache of parsed public keys, kept per thread so the
+ * script check workers never share it. Transactions spending many outputs of
+ * one address, like ABN and GSC transmissions, check every input against the
+ * same key, and parsing a compressed key costs a square root, close to a tenth
+ * of the signature verification itself. */
+struct ParsedPubKeyCache
+{
+    static const unsigned int SLOTS = 64;
+    struct Slot {
+        unsigned int nSize; // 0 for an empty slot
+        unsigned char vch[65];
+        secp256k1_pubkey parsed;
+    };
+    Slot slots[SLOTS];
+};
+thread_local ParsedPubKeyCache parsedPubKeyCache;
+}
+
+/* Parse a serialized public key of nSize (33 or 65) bytes, reusing the result of
+ * an earlier parse of the same key on this thread. */
+static bool ParsePubKeyCached(const unsigned char* pch, unsigned int nSize, secp256k1_pubkey& pubkey)
+{
+    /* pch[1] and pch[2] are part of the x coordinate, which is as good as random */
+    ParsedPubKeyCache::Slot& slot = parsedPubKeyCache.slots[(pch[1] | (pch[2] << 8)) % ParsedPubKeyCache::SLOTS];
+    if (slot.nSize == nSize && memcmp(slot.vch, pch, nSize) == 0) {
+        pubkey = slot.parsed;
+        return true;
+    }
+    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey, pch, nSize)) {
+        return false;
+    }
+    slot.nSize = nSize;
+    memcpy(slot.vch, pch, nSize);
+    slot.parsed = pubkey;
+    return true;
 }
 
 /** This function is taken from the libsecp256k1 distribution and implements
@@ -169,7 +207,7 @@ bool CPubKey::Verify(const uint256 &hash, const std::vector<unsigned char>& vchS
         return false;
     secp256k1_pubkey pubkey;
     secp256k1_ecdsa_signature sig;
-    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey, &(*this)[0], size())) {
+    if (!ParsePubKeyCached(&(*this)[0], size(), pubkey)) {
         return false;
     }
     if (vchSig.size() == 0) {
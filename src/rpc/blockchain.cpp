@@ -519,7 +519,37 @@ UniValue getrawmempool(const JSONRPCRequest& request)
     if (request.params.size() > 0)
         fVerbose = request.params[0].get_bool();
 
-    return mempoolToJSON(fVerbose);
+    if (!fVerbose || !request.CanStreamResult())
+        return mempoolToJSON(fVerbose);
+
+    // Stream verbose entries in batches. mempool.cs is only held while a batch is converted, never while
+    // waiting for the client. Transactions removed in the meantime are skipped.
+    static const size_t BATCH_SIZE = 1000;
+    std::vector<uint256> vtxid;
+    mempool.queryHashes(vtxid);
+
+    CJSONStreamWriter& writer = request.StreamResult();
+    writer.BeginObject();
+    std::vector<std::pair<std::string, UniValue> > vBatch;
+    for (size_t i = 0; i < vtxid.size(); i += BATCH_SIZE) {
+        vBatch.clear();
+        {
+            LOCK(mempool.cs);
+            for (size_t j = i; j < std::min(i + BATCH_SIZE, vtxid.size()); j++) {
+                auto it = mempool.mapTx.find(vtxid[j]);
+                if (it == mempool.mapTx.end())
+                    continue;
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(info, *it);
+                vBatch.emplace_back(vtxid[j].ToString(), std::move(info));
+            }
+        }
+        for (const auto& p : vBatch) {
+            writer.Pair(p.first, p.second);
+        }
+    }
+    writer.EndObject();
+    return NullUniValue;
 }
 
 UniValue getmempoolancestors(const JSONRPCRequest& request)
@@ -938,48 +968,79 @@ UniValue getblock(const JSONRPCRequest& request)
             + HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
-    LOCK(cs_main);
+    CBlock block;
+    CBlockIndex* pblockindex;
+    UniValue blockHeader;
+    {
+        LOCK(cs_main);
 
-    std::string strHash = request.params[0].get_str();
-    uint256 hash(uint256S(strHash));
+        std::string strHash = request.params[0].get_str();
+        uint256 hash(uint256S(strHash));
 
-    int verbosity = 1;
-    if (request.params.size() > 1) {
-        if(request.params[1].isNum())
-            verbosity = request.params[1].get_int();
-        else
-            verbosity = request.params[1].get_bool() ? 1 : 0;
-    }
-	int NUMBER_LENGTH_NON_HASH = 10;
-	if (strHash.length() < NUMBER_LENGTH_NON_HASH && !strHash.empty())
-	{
-		CBlockIndex* bindex = FindBlockByHeight(cdbl(strHash, 0));
-		if (bindex==NULL)
-		    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found by height");
-		hash = bindex->GetBlockHash();
-	}
-   
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        int verbosity = 1;
+        if (request.params.size() > 1) {
+            if(request.params[1].isNum())
+                verbosity = request.params[1].get_int();
+            else
+                verbosity = request.params[1].get_bool() ? 1 : 0;
+        }
+        int NUMBER_LENGTH_NON_HASH = 10;
+        if (strHash.length() < NUMBER_LENGTH_NON_HASH && !strHash.empty())
+        {
+            CBlockIndex* bindex = FindBlockByHeight(cdbl(strHash, 0));
+            if (bindex==NULL)
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found by height");
+            hash = bindex->GetBlockHash();
+        }
 
-    CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
+        if (mapBlockIndex.count(hash) == 0)
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Block not available (pruned data)");
+        pblockindex = mapBlockIndex[hash];
 
-    if(!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+        if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Block not available (pruned data)");
 
-    if (verbosity <= 0)
-    {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+        if(!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+
+        if (verbosity <= 0)
+        {
+            CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+            ssBlock << block;
+            std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
+            return strHex;
+        }
+
+        if (verbosity < 2 || !request.CanStreamResult()) {
+            return blockToJSON(block, pblockindex, verbosity >= 2);
+        }
+        // everything but the transaction details is small, build it as usual
+        blockHeader = blockToJSON(block, pblockindex, false);
     }
 
-    return blockToJSON(block, pblockindex, verbosity >= 2);
+    // stream the transactions one by one without holding cs_main while the client reads them
+    CJSONStreamWriter& writer = request.StreamResult();
+    writer.BeginObject();
+    for (size_t i = 0; i < blockHeader.size(); i++) {
+        if (blockHeader.getKeys()[i] != "tx") {
+            writer.Pair(blockHeader.getKeys()[i], blockHeader.getValues()[i]);
+            continue;
+        }
+        writer.Key("tx");
+        writer.BeginArray();
+        for (const auto& tx : block.vtx) {
+            UniValue objTx(UniValue::VOBJ);
+            {
+                LOCK(cs_main);
+                TxToJSON(*tx, uint256(), objTx);
+            }
+            writer.Value(objTx);
+        }
+        writer.EndArray();
+    }
+    writer.EndObject();
+    return NullUniValue;
 }
 
 struct CCoinsStats
@@ -1572,6 +1633,13 @@ UniValue mempoolInfoToJSON()
     size_t maxmempool = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     ret.push_back(Pair("maxmempool", (int64_t) maxmempool));
     ret.push_back(Pair("mempoolminfee", ValueFromAmount(mempool.GetMinFee(maxmempool).GetFeePerK())));
+    CMempoolLoadStats loadStats = GetMempoolLoadStats();
+    int64_t nProcessed = loadStats.nAccepted + loadStats.nFailed + loadStats.nExpired;
+    ret.push_back(Pair("loading", loadStats.fLoading));
+    ret.push_back(Pair("loaded", loadStats.fLoaded));
+    ret.push_back(Pair("loadprogress", loadStats.nTotal ? std::min(1.0, (double)nProcessed / loadStats.nTotal) : (loadStats.fLoading ? 0.0 : 1.0)));
+    ret.push_back(Pair("loadaccepted", loadStats.nAccepted));
+    ret.push_back(Pair("loadtime", loadStats.nLoadTime));
     // ret.push_back(Pair("instantsendlocks", (int64_t)llmq::quorumInstantSendManager->GetInstantSendLockCount()));
     return ret;
 }
@@ -1590,6 +1658,11 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee for tx to be accepted\n"
             "  \"instantsendlocks\": xxxxx,   (numeric) Number of unconfirmed instant send locks\n"
+            "  \"loading\": true|false,       (boolean) Whether mempool.dat is still being loaded\n"
+            "  \"loaded\": true|false,        (boolean) Whether mempool.dat was loaded successfully\n"
+            "  \"loadprogress\": x.xxx,       (numeric) Fraction of the transactions in mempool.dat processed so far\n"
+            "  \"loadaccepted\": xxxxx,       (numeric) Transactions from mempool.dat accepted so far\n"
+            "  \"loadtime\": xxxxx,           (numeric) Time in milliseconds it took to load mempool.dat\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -1599,6 +1672,136 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
     return mempoolInfoToJSON();
 }
 
+UniValue getdbstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getdbstats\n"
+            "\nReturns settings, usage counters and compaction stats of all open LevelDB databases.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"xxxx\",              (string) Database name as used by -dbtune\n"
+            "    \"path\": \"xxxx\",              (string) Location of the database\n"
+            "    \"blockcache\": xxxxx,           (numeric) Block cache size in bytes\n"
+            "    \"writebuffer\": xxxxx,          (numeric) Write buffer size in bytes\n"
+            "    \"bloombits\": xxxxx,            (numeric) Bloom filter bits per key\n"
+            "    \"blocksize\": xxxxx,            (numeric) Block size in bytes\n"
+            "    \"reads\": xxxxx,                (numeric) Number of point lookups\n"
+            "    \"readsfound\": xxxxx,           (numeric) Number of point lookups which found an entry (not block cache hits)\n"
+            "    \"bytesread\": xxxxx,            (numeric) Bytes returned by point lookups\n"
+            "    \"iterators\": xxxxx,            (numeric) Number of iterators created\n"
+            "    \"iteratorbytesread\": xxxxx,    (numeric) Bytes of values read through iterators\n"
+            "    \"batches\": xxxxx,              (numeric) Number of written batches\n"
+            "    \"byteswritten\": xxxxx,         (numeric) Estimated bytes written\n"
+            "    \"memoryusage\": xxxxx,          (numeric) Approximate memory used by caches and memtables\n"
+            "    \"levels\": [                    (array) Non-empty LevelDB levels\n"
+            "      {\n"
+            "        \"level\": n,                  (numeric) Level\n"
+            "        \"files\": n,                  (numeric) Number of table files\n"
+            "        \"sizemb\": n,                 (numeric) Size of the level in MiB\n"
+            "        \"compactiontime\": n,         (numeric) Seconds spent in compactions of this level\n"
+            "        \"compactionreadmb\": n,       (numeric) MiB read by compactions\n"
+            "        \"compactionwritemb\": n       (numeric) MiB written by compactions\n"
+            "      }, ...\n"
+            "    ]\n"
+            "  }, ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbstats", "")
+            + HelpExampleRpc("getdbstats", "")
+        );
+
+    UniValue ret(UniValue::VARR);
+    for (const auto& stats : GetDBWrapperStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", stats.strName));
+        obj.push_back(Pair("path", stats.strPath));
+        obj.push_back(Pair("blockcache", (uint64_t)stats.options.nBlockCacheSize));
+        obj.push_back(Pair("writebuffer", (uint64_t)stats.options.nWriteBufferSize));
+        obj.push_back(Pair("bloombits", stats.options.nBloomBits));
+        obj.push_back(Pair("blocksize", (uint64_t)stats.options.nBlockSize));
+        obj.push_back(Pair("reads", stats.nReads));
+        obj.push_back(Pair("readsfound", stats.nReadsFound));
+        obj.push_back(Pair("bytesread", stats.nBytesRead));
+        obj.push_back(Pair("iterators", stats.nIterators));
+        obj.push_back(Pair("iteratorbytesread", stats.nIteratorBytesRead));
+        obj.push_back(Pair("batches", stats.nBatches));
+        obj.push_back(Pair("byteswritten", stats.nBytesWritten));
+        obj.push_back(Pair("memoryusage", stats.nMemoryUsage));
+        UniValue levels(UniValue::VARR);
+        for (const auto& level : stats.vecLevels) {
+            UniValue levelObj(UniValue::VOBJ);
+            levelObj.push_back(Pair("level", level.nLevel));
+            levelObj.push_back(Pair("files", level.nFiles));
+            levelObj.push_back(Pair("sizemb", level.nSizeMB));
+            levelObj.push_back(Pair("compactiontime", level.nCompactionTime));
+            levelObj.push_back(Pair("compactionreadmb", level.nCompactionReadMB));
+            levelObj.push_back(Pair("compactionwritemb", level.nCompactionWriteMB));
+            levels.push_back(levelObj);
+        }
+        obj.push_back(Pair("levels", levels));
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
+UniValue getcoincacheinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getcoincacheinfo\n"
+            "\nReturns usage and hit rate of the in-memory UTXO cache and the durations of its flushes to disk.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"entries\": xxxxx,          (numeric) Number of cached coins\n"
+            "  \"usage\": xxxxx,            (numeric) Memory used by the cache in bytes\n"
+            "  \"limit\": xxxxx,            (numeric) Memory budget of the cache in bytes (see -dbcache)\n"
+            "  \"keeppercent\": n,          (numeric) Percentage of the budget kept in use after a flush (see -dbcachekeep)\n"
+            "  \"hits\": xxxxx,             (numeric) Coin lookups answered from the cache\n"
+            "  \"misses\": xxxxx,           (numeric) Coin lookups which went to the coins database\n"
+            "  \"hitrate\": x.xxx,          (numeric) Share of lookups answered from the cache\n"
+            "  \"evicted\": xxxxx,          (numeric) Unmodified coins dropped to stay within the budget\n"
+            "  \"flushes\": {\n"
+            "    \"full\": n,               (numeric) Flushes which emptied the cache\n"
+            "    \"trim\": n,               (numeric) Flushes which kept the recently used coins\n"
+            "    \"lastentries\": n,        (numeric) Number of cached coins when the last flush started\n"
+            "    \"lastms\": n,             (numeric) Duration of the last flush in milliseconds\n"
+            "    \"maxms\": n,              (numeric) Longest flush in milliseconds\n"
+            "    \"totalms\": n             (numeric) Time spent flushing in milliseconds\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getcoincacheinfo", "")
+            + HelpExampleRpc("getcoincacheinfo", "")
+        );
+
+    LOCK(cs_main);
+
+    UniValue ret(UniValue::VOBJ);
+    uint64_t nHits = pcoinsTip->GetHits();
+    uint64_t nMisses = pcoinsTip->GetMisses();
+    ret.push_back(Pair("entries", (uint64_t)pcoinsTip->GetCacheSize()));
+    ret.push_back(Pair("usage", (uint64_t)pcoinsTip->DynamicMemoryUsage()));
+    ret.push_back(Pair("limit", (uint64_t)nCoinCacheUsage));
+    ret.push_back(Pair("keeppercent", (int)nCoinCacheKeepPercent));
+    ret.push_back(Pair("hits", nHits));
+    ret.push_back(Pair("misses", nMisses));
+    ret.push_back(Pair("hitrate", nHits + nMisses == 0 ? 0.0 : (double)nHits / (nHits + nMisses)));
+    ret.push_back(Pair("evicted", pcoinsTip->GetEvicted()));
+
+    CCoinsFlushStats flushStats = GetCoinsFlushStats();
+    UniValue flushes(UniValue::VOBJ);
+    flushes.push_back(Pair("full", flushStats.nFullFlushes));
+    flushes.push_back(Pair("trim", flushStats.nTrimFlushes));
+    flushes.push_back(Pair("lastentries", (uint64_t)flushStats.nLastFlushEntries));
+    flushes.push_back(Pair("lastms", flushStats.nLastFlushTime / 1000));
+    flushes.push_back(Pair("maxms", flushStats.nMaxFlushTime / 1000));
+    flushes.push_back(Pair("totalms", flushStats.nTotalFlushTime / 1000));
+    ret.push_back(Pair("flushes", flushes));
+    return ret;
+}
+
 UniValue preciousblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -2137,7 +2340,8 @@ UniValue exec(const JSONRPCRequest& request)
 		int iSpecificEntry = 0;
 		std::string sEntry = "";
 		int iDays = 30;
-		UniValue aDataList = GetDataList(sType, iDays, iSpecificEntry, sSearch, sEntry);
+		CJSONStreamWriter* pwriter = request.CanStreamResult() ? &request.StreamResult() : nullptr;
+		UniValue aDataList = GetDataList(sType, iDays, iSpecificEntry, sSearch, sEntry, pwriter);
 		return aDataList;
 	}
 	else if (sItem == "getsporkdouble")
@@ -3811,6 +4015,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
     { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           true,  {"count","branchlen"} },
+    { "blockchain",         "getdbstats",             &getdbstats,             true,  {} },
+    { "blockchain",         "getcoincacheinfo",       &getcoincacheinfo,       true,  {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    true,  {"txid","verbose"} },
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true,  {"txid","verbose"} },
@@ -625,77 +625,115 @@ UniValue gobject_vote_alias(const JSONRPCRequest& request)
 }
 #endif
 
-UniValue ListObjects(const std::string& strCachedSignal, const std::string& strType, int nStartTime, std::string sWildCard, double nMinVotes)
+static UniValue GovernanceObjectToJSON(const CGovernanceObject* pGovObj)
 {
-    UniValue objResult(UniValue::VOBJ);
+    UniValue bObj(UniValue::VOBJ);
+    bObj.push_back(Pair("DataHex",  pGovObj->GetDataAsHexString()));
+    bObj.push_back(Pair("DataString",  pGovObj->GetDataAsPlainString()));
+    bObj.push_back(Pair("Hash",  pGovObj->GetHash().ToString()));
+    bObj.push_back(Pair("CollateralHash",  pGovObj->GetCollateralHash().ToString()));
+    bObj.push_back(Pair("ObjectType", pGovObj->GetObjectType()));
+    bObj.push_back(Pair("CreationTime", pGovObj->GetCreationTime()));
+    const COutPoint& masternodeOutpoint = pGovObj->GetMasternodeOutpoint();
+    if (masternodeOutpoint != COutPoint()) {
+        bObj.push_back(Pair("SigningMasternode", masternodeOutpoint.ToStringShort()));
+    }
 
-    // GET MATCHING GOVERNANCE OBJECTS
+    // REPORT STATUS FOR FUNDING VOTES SPECIFICALLY
+    bObj.push_back(Pair("AbsoluteYesCount",  pGovObj->GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING)));
+    bObj.push_back(Pair("YesCount",  pGovObj->GetYesCount(VOTE_SIGNAL_FUNDING)));
+    bObj.push_back(Pair("NoCount",  pGovObj->GetNoCount(VOTE_SIGNAL_FUNDING)));
+    bObj.push_back(Pair("AbstainCount",  pGovObj->GetAbstainCount(VOTE_SIGNAL_FUNDING)));
 
-    LOCK2(cs_main, governance.cs);
+    // REPORT VALIDITY AND CACHING FLAGS FOR VARIOUS SETTINGS
+    std::string strError = "";
+    bObj.push_back(Pair("fBlockchainValidity",  pGovObj->IsValidLocally(strError, false)));
+    bObj.push_back(Pair("IsValidReason",  strError.c_str()));
+    bObj.push_back(Pair("fCachedValid",  pGovObj->IsSetCachedValid()));
+    bObj.push_back(Pair("fCachedFunding",  pGovObj->IsSetCachedFunding()));
+    bObj.push_back(Pair("fCachedDelete",  pGovObj->IsSetCachedDelete()));
+    bObj.push_back(Pair("fCachedEndorsed",  pGovObj->IsSetCachedEndorsed()));
+
+    return bObj;
+}
 
-    std::vector<const CGovernanceObject*> objs = governance.GetAllNewerThan(nStartTime);
-    governance.UpdateLastDiffTime(GetTime());
+UniValue ListObjects(const JSONRPCRequest& request, const std::string& strCachedSignal, const std::string& strType, int nStartTime, std::string sWildCard, double nMinVotes)
+{
+    // GET MATCHING GOVERNANCE OBJECTS
+
+    std::vector<uint256> vHashes;
+    {
+        LOCK2(cs_main, governance.cs);
+
+        std::vector<const CGovernanceObject*> objs = governance.GetAllNewerThan(nStartTime);
+        governance.UpdateLastDiffTime(GetTime());
+
+        for (const auto& pGovObj : objs) {
+            if (strCachedSignal == "valid" && !pGovObj->IsSetCachedValid()) continue;
+            if (strCachedSignal == "funding" && !pGovObj->IsSetCachedFunding()) continue;
+            if (strCachedSignal == "delete" && !pGovObj->IsSetCachedDelete()) continue;
+            if (strCachedSignal == "endorsed" && !pGovObj->IsSetCachedEndorsed()) continue;
+
+            if (strType == "proposals" && pGovObj->GetObjectType() != GOVERNANCE_OBJECT_PROPOSAL) continue;
+            if (strType == "triggers" && pGovObj->GetObjectType() != GOVERNANCE_OBJECT_TRIGGER) continue;
+
+            bool bFound = true;
+            if (!sWildCard.empty())
+            {
+                bFound = false;
+                if (pGovObj->GetHash().GetHex().find(sWildCard) != std::string::npos)
+                    bFound = true;
+                if (pGovObj->GetDataAsPlainString().find(sWildCard) != std::string::npos)
+                    bFound = true;
+            }
+
+            if (nMinVotes > 0)
+            {
+                bFound = pGovObj->GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING) > nMinVotes;
+            }
+
+            if (bFound)
+                vHashes.push_back(pGovObj->GetHash());
+        }
+    }
 
     // CREATE RESULTS FOR USER
 
-    for (const auto& pGovObj : objs) {
-        if (strCachedSignal == "valid" && !pGovObj->IsSetCachedValid()) continue;
-        if (strCachedSignal == "funding" && !pGovObj->IsSetCachedFunding()) continue;
-        if (strCachedSignal == "delete" && !pGovObj->IsSetCachedDelete()) continue;
-        if (strCachedSignal == "endorsed" && !pGovObj->IsSetCachedEndorsed()) continue;
-
-        if (strType == "proposals" && pGovObj->GetObjectType() != GOVERNANCE_OBJECT_PROPOSAL) continue;
-        if (strType == "triggers" && pGovObj->GetObjectType() != GOVERNANCE_OBJECT_TRIGGER) continue;
-
-		bool bFound = true;
-		if (!sWildCard.empty())
-		{
-			bFound = false;
-			if (pGovObj->GetHash().GetHex().find(sWildCard) != std::string::npos)
-				bFound = true;
-			if (pGovObj->GetDataAsPlainString().find(sWildCard) != std::string::npos)
-				bFound = true;
-		}
-
-		if (nMinVotes > 0)
-		{
-			bFound = pGovObj->GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING) > nMinVotes;
-		}
-
-		if (bFound)
-		{
-			UniValue bObj(UniValue::VOBJ);
-			bObj.push_back(Pair("DataHex",  pGovObj->GetDataAsHexString()));
-			bObj.push_back(Pair("DataString",  pGovObj->GetDataAsPlainString()));
-			bObj.push_back(Pair("Hash",  pGovObj->GetHash().ToString()));
-			bObj.push_back(Pair("CollateralHash",  pGovObj->GetCollateralHash().ToString()));
-			bObj.push_back(Pair("ObjectType", pGovObj->GetObjectType()));
-			bObj.push_back(Pair("CreationTime", pGovObj->GetCreationTime()));
-			const COutPoint& masternodeOutpoint = pGovObj->GetMasternodeOutpoint();
-			if (masternodeOutpoint != COutPoint()) {
-				bObj.push_back(Pair("SigningMasternode", masternodeOutpoint.ToStringShort()));
-			}
-
-			// REPORT STATUS FOR FUNDING VOTES SPECIFICALLY
-			bObj.push_back(Pair("AbsoluteYesCount",  pGovObj->GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING)));
-			bObj.push_back(Pair("YesCount",  pGovObj->GetYesCount(VOTE_SIGNAL_FUNDING)));
-			bObj.push_back(Pair("NoCount",  pGovObj->GetNoCount(VOTE_SIGNAL_FUNDING)));
-			bObj.push_back(Pair("AbstainCount",  pGovObj->GetAbstainCount(VOTE_SIGNAL_FUNDING)));
-
-			// REPORT VALIDITY AND CACHING FLAGS FOR VARIOUS SETTINGS
-			std::string strError = "";
-			bObj.push_back(Pair("fBlockchainValidity",  pGovObj->IsValidLocally(strError, false)));
-			bObj.push_back(Pair("IsValidReason",  strError.c_str()));
-			bObj.push_back(Pair("fCachedValid",  pGovObj->IsSetCachedValid()));
-			bObj.push_back(Pair("fCachedFunding",  pGovObj->IsSetCachedFunding()));
-			bObj.push_back(Pair("fCachedDelete",  pGovObj->IsSetCachedDelete()));
-			bObj.push_back(Pair("fCachedEndorsed",  pGovObj->IsSetCachedEndorsed()));
-		
+    // Objects are converted in batches and can be streamed, governance.cs is never held while waiting for the
+    // client. Objects removed in the meantime are skipped.
+    static const size_t BATCH_SIZE = 100;
+    CJSONStreamWriter* pwriter = nullptr;
+    if (request.CanStreamResult()) {
+        pwriter = &request.StreamResult();
+        pwriter->BeginObject();
+    }
 
-			objResult.push_back(Pair(pGovObj->GetHash().ToString(), bObj));
-		}
+    UniValue objResult(UniValue::VOBJ);
+    std::vector<std::pair<std::string, UniValue> > vBatch;
+    for (size_t i = 0; i < vHashes.size(); i += BATCH_SIZE) {
+        vBatch.clear();
+        {
+            LOCK2(cs_main, governance.cs);
+            for (size_t j = i; j < std::min(i + BATCH_SIZE, vHashes.size()); j++) {
+                const CGovernanceObject* pGovObj = governance.FindGovernanceObject(vHashes[j]);
+                if (pGovObj) {
+                    vBatch.emplace_back(vHashes[j].ToString(), GovernanceObjectToJSON(pGovObj));
+                }
+            }
+        }
+        for (const auto& p : vBatch) {
+            if (pwriter) {
+                pwriter->Pair(p.first, p.second);
+            } else {
+                objResult.push_back(Pair(p.first, p.second));
+            }
+        }
     }
 
+    if (pwriter) {
+        pwriter->EndObject();
+        return NullUniValue;
+    }
     return objResult;
 }
 
@@ -728,7 +766,7 @@ UniValue gobject_list(const JSONRPCRequest& request)
 	if (request.params.size() > 3)
 		nMinVotes = cdbl(request.params[3].getValStr(), 0);
     
-    return ListObjects(strCachedSignal, strType, 0, "", nMinVotes);
+    return ListObjects(request, strCachedSignal, strType, 0, "", nMinVotes);
 }
 
 UniValue gobject_list_wild(const JSONRPCRequest& request)
@@ -752,7 +790,7 @@ UniValue gobject_list_wild(const JSONRPCRequest& request)
 	double nMinVotes = 0;
 	if (request.params.size() >= 5)
 		nMinVotes = cdbl(request.params[4].getValStr(), 0);
-    return ListObjects(strCachedSignal, strType, 0, strWild, nMinVotes);
+    return ListObjects(request, strCachedSignal, strType, 0, strWild, nMinVotes);
 }
 
 void gobject_diff_help()
@@ -781,7 +819,7 @@ UniValue gobject_diff(const JSONRPCRequest& request)
     if (strType != "proposals" && strType != "triggers" && strType != "all")
         return "Invalid type, should be 'proposals', 'triggers' or 'all'";
 
-    return ListObjects(strCachedSignal, strType, governance.GetLastDiffTime(), "", 0);
+    return ListObjects(request, strCachedSignal, strType, governance.GetLastDiffTime(), "", 0);
 }
 
 void gobject_get_help()
@@ -1214,7 +1252,9 @@ UniValue leaderboard(const JSONRPCRequest& request)
 		
 	if (nHeight == 0)
 		nHeight = iNextSuperblock;
-	UniValue p = GetProminenceLevels(nHeight, sNickName);
+	// every participant is one member, large campaigns are streamed instead of returned as one object
+	CJSONStreamWriter* pwriter = (nHeight != 0 && request.CanStreamResult()) ? &request.StreamResult() : nullptr;
+	UniValue p = GetProminenceLevels(nHeight, sNickName, pwriter);
 	return p;
 }
 
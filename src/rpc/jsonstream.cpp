@@ -0,0 +1,96 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include <assert.h>
+
+CJSONStreamWriter::CJSONStreamWriter(const Sink& sinkIn, size_t nChunkSizeIn) :
+    sink(sinkIn),
+    nChunkSize(nChunkSizeIn)
+{
+    buffer.reserve(nChunkSize);
+}
+
+void CJSONStreamWriter::BeforeValue()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vFirst.empty()) {
+        if (!vFirst.back()) {
+            buffer += ',';
+        }
+        vFirst.back() = false;
+    }
+}
+
+void CJSONStreamWriter::Append(const std::string& str)
+{
+    buffer += str;
+    if (buffer.size() >= nChunkSize) {
+        Flush();
+    }
+}
+
+void CJSONStreamWriter::BeginObject()
+{
+    BeforeValue();
+    vFirst.push_back(true);
+    Append("{");
+}
+
+void CJSONStreamWriter::EndObject()
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    vFirst.pop_back();
+    Append("}");
+}
+
+void CJSONStreamWriter::BeginArray()
+{
+    BeforeValue();
+    vFirst.push_back(true);
+    Append("[");
+}
+
+void CJSONStreamWriter::EndArray()
+{
+    assert(!vFirst.empty());
+    vFirst.pop_back();
+    Append("]");
+}
+
+void CJSONStreamWriter::Key(const std::string& key)
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    BeforeValue();
+    Append(UniValue(key).write() + ":");
+    fAfterKey = true;
+}
+
+void CJSONStreamWriter::Value(const UniValue& value)
+{
+    BeforeValue();
+    Append(value.write());
+}
+
+void CJSONStreamWriter::Raw(const std::string& str)
+{
+    Append(str);
+}
+
+void CJSONStreamWriter::Flush()
+{
+    if (buffer.empty()) {
+        return;
+    }
+    nBytesWritten += buffer.size();
+    bool fOk = sink(buffer);
+    buffer.clear();
+    if (!fOk) {
+        throw json_stream_aborted();
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPCJSONSTREAM_H
+#define BITCOIN_RPCJSONSTREAM_H
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+/** Thrown by CJSONStreamWriter once the receiving end has gone away */
+class json_stream_aborted : public std::runtime_error
+{
+public:
+    json_stream_aborted() : std::runtime_error("JSON stream receiver has gone away") {}
+};
+
+/**
+ * Writes a JSON document piece by piece and hands it to a sink in chunks of roughly nChunkSize bytes,
+ * so that large results don't need to be held in memory as a complete UniValue tree and string.
+ * Containers are opened and closed explicitly, everything below that level is passed as UniValue
+ * (e.g. one transaction at a time). Separators are inserted automatically.
+ */
+class CJSONStreamWriter
+{
+public:
+    /** Receives the encoded chunks. Returns false if the receiver has gone away, which makes the writer throw */
+    typedef std::function<bool(const std::string&)> Sink;
+
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit CJSONStreamWriter(const Sink& sinkIn, size_t nChunkSizeIn = DEFAULT_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write the key of the next member of the current object */
+    void Key(const std::string& key);
+    /** Write a complete value, either as a member (after Key) or as an array element */
+    void Value(const UniValue& value);
+    void Pair(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+    /** Append already encoded data as-is */
+    void Raw(const std::string& str);
+
+    /** Pass everything written so far to the sink */
+    void Flush();
+
+    /** True if nothing was written yet */
+    bool IsEmpty() const { return nBytesWritten == 0 && buffer.empty(); }
+
+private:
+    void BeforeValue();
+    void Append(const std::string& str);
+
+    Sink sink;
+    size_t nChunkSize;
+    std::string buffer;
+    size_t nBytesWritten{0};
+    //! one entry per open container, true until the first element was written
+    std::vector<bool> vFirst;
+    bool fAfterKey{false};
+};
+
+#endif // BITCOIN_RPCJSONSTREAM_H
@@ -695,6 +695,60 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/**
+ * Reads the optional "limit" and "cursor" fields used for paging through the address index. Paging is
+ * only supported for a single address. The cursor is the hex encoded index key of the last returned
+ * entry, pResumeKey is set to it (or null when no cursor is given).
+ */
+template<typename K>
+size_t getPagingFromParams(const UniValue& params, const std::vector<std::pair<uint160, int> >& addresses, K& resumeKey, const K*& pResumeKey)
+{
+    pResumeKey = nullptr;
+    if (!params[0].isObject()) {
+        return 0;
+    }
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (limitValue.isNull()) {
+        if (!cursorValue.isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor requires limit");
+        }
+        return 0;
+    }
+    int nLimit = limitValue.get_int();
+    if (nLimit <= 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "limit is expected to be positive");
+    }
+    if (addresses.size() != 1) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "limit and cursor are only supported for a single address");
+    }
+    if (!cursorValue.isNull()) {
+        std::string strCursor = cursorValue.get_str();
+        if (!IsHex(strCursor)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor must be hexadecimal");
+        }
+        try {
+            CDataStream ss(ParseHex(strCursor), SER_DISK, CLIENT_VERSION);
+            ss >> resumeKey;
+        } catch (const std::exception&) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        if (resumeKey.hashBytes != addresses[0].first || (int)resumeKey.type != addresses[0].second) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor belongs to a different address");
+        }
+        pResumeKey = &resumeKey;
+    }
+    return (size_t)nLimit;
+}
+
+template<typename K>
+std::string encodeAddressCursor(const K& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    return HexStr(ss.begin(), ss.end());
+}
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -779,6 +833,8 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            "  \"limit\" (number, optional) Return at most this many outputs of a single address\n"
+            "  \"cursor\" (string, optional) Continue after the output identified by a previously returned cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -791,6 +847,11 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"height\"  (number) The block height\n"
             "  }\n"
             "]\n"
+            "\nResult (when limit is given):\n"
+            "{\n"
+            "  \"utxos\": [...]  (array) Outputs as above, in index order instead of by height\n"
+            "  \"cursor\"  (string) Pass this to get the next page, null if there are no more outputs\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -802,15 +863,25 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    CAddressUnspentKey resumeKey;
+    const CAddressUnspentKey* pResumeKey;
+    size_t nLimit = getPagingFromParams(request.params, addresses, resumeKey, pResumeKey);
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+        // one more than requested, to know whether there is another page
+        if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs, nLimit ? nLimit + 1 : 0, pResumeKey)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
     }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    bool fMore = nLimit && unspentOutputs.size() > nLimit;
+    if (fMore) {
+        unspentOutputs.resize(nLimit);
+    } else if (!nLimit) {
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    }
 
     UniValue result(UniValue::VARR);
 
@@ -830,9 +901,70 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         result.push_back(output);
     }
 
+    if (nLimit) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("utxos", result));
+        page.push_back(Pair("cursor", fMore ? UniValue(encodeAddressCursor(unspentOutputs.back().first)) : NullUniValue));
+        return page;
+    }
+
     return result;
 }
 
+static UniValue addressDeltaToJSON(const CAddressIndexKey& key, CAmount amount)
+{
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue delta(UniValue::VOBJ);
+    delta.push_back(Pair("satoshis", amount));
+    delta.push_back(Pair("txid", key.txhash.GetHex()));
+    delta.push_back(Pair("index", (int)key.index));
+    delta.push_back(Pair("blockindex", (int)key.txindex));
+    delta.push_back(Pair("height", key.blockHeight));
+    delta.push_back(Pair("address", address));
+    return delta;
+}
+
+/** Number of index entries read at a time while streaming getaddressdeltas */
+static const size_t ADDRESS_DELTAS_STREAM_PAGE = 10000;
+
+// Reads the deltas of each address a page at a time and writes them out as they are read
+static void streamAddressDeltas(const JSONRPCRequest& request, const std::vector<std::pair<uint160, int> >& addresses, int start, int end)
+{
+    CJSONStreamWriter* pwriter = nullptr;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vPage;
+    for (const auto& address : addresses) {
+        CAddressIndexKey resumeKey;
+        const CAddressIndexKey* pResumeKey = nullptr;
+        do {
+            vPage.clear();
+            if (!GetAddressIndex(address.first, address.second, vPage, start, end, ADDRESS_DELTAS_STREAM_PAGE, pResumeKey)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            if (!pwriter) {
+                // after the first read, so that a disabled index is still reported as an error
+                pwriter = &request.StreamResult();
+                pwriter->BeginArray();
+            }
+            for (const auto& entry : vPage) {
+                pwriter->Value(addressDeltaToJSON(entry.first, entry.second));
+            }
+            if (!vPage.empty()) {
+                resumeKey = vPage.back().first;
+                pResumeKey = &resumeKey;
+            }
+        } while (vPage.size() == ADDRESS_DELTAS_STREAM_PAGE);
+    }
+    if (!pwriter) {
+        pwriter = &request.StreamResult();
+        pwriter->BeginArray();
+    }
+    pwriter->EndArray();
+}
+
 UniValue getaddressdeltas(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1 || !request.params[0].isObject())
@@ -848,6 +980,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many deltas of a single address\n"
+            "  \"cursor\" (string, optional) Continue after the delta identified by a previously returned cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -860,6 +994,11 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (when limit is given):\n"
+            "{\n"
+            "  \"deltas\": [...]  (array) Deltas as above\n"
+            "  \"cursor\"  (string) Pass this to get the next page, null if there are no more deltas\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -886,36 +1025,45 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    if (start <= 0 || end <= 0) {
+        start = end = 0;
+    }
+
+    CAddressIndexKey resumeKey;
+    const CAddressIndexKey* pResumeKey;
+    size_t nLimit = getPagingFromParams(request.params, addresses, resumeKey, pResumeKey);
+
+    if (!nLimit && request.CanStreamResult()) {
+        // high activity addresses have millions of deltas, don't read them all first
+        streamAddressDeltas(request, addresses, start, end);
+        return NullUniValue;
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
+        // one more than requested, to know whether there is another page
+        if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end, nLimit ? nLimit + 1 : 0, pResumeKey)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
     }
 
+    bool fMore = nLimit && addressIndex.size() > nLimit;
+    if (fMore) {
+        addressIndex.resize(nLimit);
+    }
+
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
+        result.push_back(addressDeltaToJSON(it->first, it->second));
+    }
 
-        UniValue delta(UniValue::VOBJ);
-        delta.push_back(Pair("satoshis", it->second));
-        delta.push_back(Pair("txid", it->first.txhash.GetHex()));
-        delta.push_back(Pair("index", (int)it->first.index));
-        delta.push_back(Pair("blockindex", (int)it->first.txindex));
-        delta.push_back(Pair("height", it->first.blockHeight));
-        delta.push_back(Pair("address", address));
-        result.push_back(delta);
+    if (nLimit) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("deltas", result));
+        page.push_back(Pair("cursor", fMore ? UniValue(encodeAddressCursor(addressIndex.back().first)) : NullUniValue));
+        return page;
     }
 
     return result;
@@ -951,22 +1099,16 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
     CAmount balance = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+        CAddressBalance addressBalance;
+        if (!GetAddressBalance((*it).first, (*it).second, addressBalance)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-        balance += it->second;
+        balance += addressBalance.balance;
+        received += addressBalance.received;
     }
 
     UniValue result(UniValue::VOBJ);
@@ -992,12 +1134,19 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Read at most this many index entries of a single address\n"
+            "  \"cursor\" (string, optional) Continue after a previously returned cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (when limit is given):\n"
+            "{\n"
+            "  \"txids\": [...]  (array) Transaction ids as above\n"
+            "  \"cursor\"  (string) Pass this to get the next page, null if there are no more transactions\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -1020,24 +1169,36 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    if (start <= 0 || end <= 0) {
+        start = end = 0;
+    }
+
+    CAddressIndexKey resumeKey;
+    const CAddressIndexKey* pResumeKey;
+    size_t nLimit = getPagingFromParams(request.params, addresses, resumeKey, pResumeKey);
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
+        // one more than requested, to know whether there is another page
+        if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end, nLimit ? nLimit + 1 : 0, pResumeKey)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
     }
 
+    bool fMore = nLimit && addressIndex.size() > nLimit;
+    if (fMore) {
+        addressIndex.resize(nLimit);
+    }
+
     std::set<std::pair<int, std::string> > txids;
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
+        // entries of the same tx are adjacent, the previous page already returned the tx the cursor points to
+        if (pResumeKey && it->first.txhash == pResumeKey->txhash) {
+            continue;
+        }
         int height = it->first.blockHeight;
         std::string txid = it->first.txhash.GetHex();
 
@@ -1056,6 +1217,13 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    if (nLimit) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("txids", result));
+        page.push_back(Pair("cursor", fMore ? UniValue(encodeAddressCursor(addressIndex.back().first)) : NullUniValue));
+        return page;
+    }
+
     return result;
 
 }
@@ -102,6 +102,15 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "       n,                        (numeric) The heights of blocks we're currently asking from this peer\n"
             "       ...\n"
             "    ],\n"
+            "    \"compactblocks\": {         (json object) Compact block reconstruction statistics\n"
+            "       \"blocks\": n,             (numeric) Compact blocks received from this peer which we tried to reconstruct\n"
+            "       \"reconstructed\": n,      (numeric) Of those, blocks reconstructed without a getblocktxn round trip\n"
+            "       \"txnlocal\": n,           (numeric) Transactions of those blocks found in the mempool or extra pools\n"
+            "       \"txnretained\": n,        (numeric) Of those, transactions found in the pool of islocked and special transactions\n"
+            "       \"txnrequested\": n,       (numeric) Transactions requested with getblocktxn\n"
+            "       \"getblocktxn\": n,        (numeric) Number of getblocktxn requests answered\n"
+            "       \"getblocktxntime\": n     (numeric) Average getblocktxn round trip time in seconds (if any)\n"
+            "    },\n"
             "    \"whitelisted\": true|false, (boolean) Whether the peer is whitelisted\n"
             "    \"bytessent_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes sent aggregated by message type\n"
@@ -166,6 +175,16 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
                 heights.push_back(height);
             }
             obj.push_back(Pair("inflight", heights));
+            UniValue cmpct(UniValue::VOBJ);
+            cmpct.push_back(Pair("blocks", statestats.nCmpctBlocks));
+            cmpct.push_back(Pair("reconstructed", statestats.nCmpctBlocksReconstructed));
+            cmpct.push_back(Pair("txnlocal", statestats.nCmpctTxnLocal));
+            cmpct.push_back(Pair("txnretained", statestats.nCmpctTxnRetained));
+            cmpct.push_back(Pair("txnrequested", statestats.nCmpctTxnRequested));
+            cmpct.push_back(Pair("getblocktxn", statestats.nGetBlockTxnReplies));
+            if (statestats.nGetBlockTxnReplies)
+                cmpct.push_back(Pair("getblocktxntime", (double)statestats.nGetBlockTxnTime / statestats.nGetBlockTxnReplies / 1e6));
+            obj.push_back(Pair("compactblocks", cmpct));
         }
         obj.push_back(Pair("whitelisted", stats.fWhitelisted));
 
@@ -407,6 +426,20 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
             "  \"timeoffset\": xxxxx,                   (numeric) the time offset\n"
             "  \"connections\": xxxxx,                  (numeric) the number of connections\n"
             "  \"networkactive\": true|false,           (bool) whether p2p networking is enabled\n"
+            "  \"socketevents\": \"xxx\",                (string) the socket events mode, either select or epoll\n"
+            "  \"sockethandler\": {                     (json object) socket handler loop statistics\n"
+            "    \"loops\": xxxxx,                      (numeric) the number of socket handler loops so far\n"
+            "    \"avgbusytime\": x.xxx,                (numeric) average time in milliseconds a loop spent outside of waiting for socket events\n"
+            "    \"lastbusytime\": x.xxx                (numeric) time in milliseconds the last loop spent outside of waiting for socket events\n"
+            "  },\n"
+            "  \"messageworkers\": {                    (json object) statistics of messages processed by the message worker pool, per message type\n"
+            "    \"xxx\": {\n"
+            "      \"queued\": xxxxx,                   (numeric) messages currently waiting for or being processed\n"
+            "      \"processed\": xxxxx,                (numeric) messages processed so far\n"
+            "      \"avgwaittime\": x.xxx,              (numeric) average time in milliseconds between receipt and start of processing\n"
+            "      \"avgprocesstime\": x.xxx            (numeric) average processing time in milliseconds\n"
+            "    }, ...\n"
+            "  },\n"
             "  \"networks\": [                          (array) information per network\n"
             "  {\n"
             "    \"name\": \"xxx\",                     (string) network (ipv4, ipv6 or onion)\n"
@@ -446,7 +479,25 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
     if (g_connman) {
         obj.push_back(Pair("networkactive", g_connman->GetNetworkActive()));
         obj.push_back(Pair("connections",   (int)g_connman->GetNodeCount(CConnman::CONNECTIONS_ALL)));
+        obj.push_back(Pair("socketevents",  GetSocketEventsModeStr(g_connman->GetSocketEventsMode())));
+        CConnman::SocketHandlerStats stats = g_connman->GetSocketHandlerStats();
+        UniValue socketHandler(UniValue::VOBJ);
+        socketHandler.push_back(Pair("loops", stats.nLoops));
+        socketHandler.push_back(Pair("avgbusytime", stats.nLoops ? (double)stats.nBusyTime / stats.nLoops / 1000 : 0.0));
+        socketHandler.push_back(Pair("lastbusytime", (double)stats.nLastBusyTime / 1000));
+        obj.push_back(Pair("sockethandler", socketHandler));
+    }
+    UniValue messageWorkers(UniValue::VOBJ);
+    for (const auto& p : GetAsyncMessageStats()) {
+        const CAsyncMessageStats& stats = p.second;
+        UniValue msgStats(UniValue::VOBJ);
+        msgStats.push_back(Pair("queued", stats.nQueued));
+        msgStats.push_back(Pair("processed", stats.nProcessed));
+        msgStats.push_back(Pair("avgwaittime", stats.nProcessed ? (double)stats.nWaitTime / stats.nProcessed / 1000 : 0.0));
+        msgStats.push_back(Pair("avgprocesstime", stats.nProcessed ? (double)stats.nProcessTime / stats.nProcessed / 1000 : 0.0));
+        messageWorkers.push_back(Pair(p.first, msgStats));
     }
+    obj.push_back(Pair("messageworkers", messageWorkers));
     obj.push_back(Pair("networks",      GetNetworksInfo()));
     obj.push_back(Pair("relayfee",      ValueFromAmount(::minRelayTxFee.GetFeePerK())));
     obj.push_back(Pair("incrementalfee", ValueFromAmount(::incrementalRelayFee.GetFeePerK())));
@@ -1020,69 +1020,102 @@ UniValue protx_list(const JSONRPCRequest& request)
         type = request.params[1].get_str();
     }
 
-    UniValue ret(UniValue::VARR);
+    std::vector<CDeterministicMNCPtr> vMNs;
+    bool detailed = false;
 
-    LOCK(cs_main);
+    {
+        LOCK(cs_main);
 
-    if (type == "wallet") {
-        if (!pwallet) {
-            throw std::runtime_error("\"protx list wallet\" not supported when wallet is disabled");
-        }
+        if (type == "wallet") {
+            if (!pwallet) {
+                throw std::runtime_error("\"protx list wallet\" not supported when wallet is disabled");
+            }
 #ifdef ENABLE_WALLET
-        LOCK2(cs_main, pwallet->cs_wallet);
-
-        if (request.params.size() > 3) {
-            protx_list_help();
-        }
+            LOCK2(cs_main, pwallet->cs_wallet);
 
-        bool detailed = request.params.size() > 2 ? ParseBoolV(request.params[2], "detailed") : false;
+            if (request.params.size() > 3) {
+                protx_list_help();
+            }
 
-        int height = request.params.size() > 3 ? ParseInt32V(request.params[3], "height") : chainActive.Height();
-        if (height < 1 || height > chainActive.Height()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid height specified");
-        }
+            detailed = request.params.size() > 2 ? ParseBoolV(request.params[2], "detailed") : false;
 
-        std::vector<COutPoint> vOutpts;
-        pwallet->ListProTxCoins(vOutpts);
-        std::set<COutPoint> setOutpts;
-        for (const auto& outpt : vOutpts) {
-            setOutpts.emplace(outpt);
-        }
+            int height = request.params.size() > 3 ? ParseInt32V(request.params[3], "height") : chainActive.Height();
+            if (height < 1 || height > chainActive.Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid height specified");
+            }
 
-        CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
-        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
-            if (setOutpts.count(dmn->collateralOutpoint) ||
-                CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner) ||
-                CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting) ||
-                CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout) ||
-                CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout)) {
-                ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+            std::vector<COutPoint> vOutpts;
+            pwallet->ListProTxCoins(vOutpts);
+            std::set<COutPoint> setOutpts;
+            for (const auto& outpt : vOutpts) {
+                setOutpts.emplace(outpt);
             }
-        });
+
+            CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
+            mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+                if (setOutpts.count(dmn->collateralOutpoint) ||
+                    CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner) ||
+                    CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting) ||
+                    CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout) ||
+                    CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout)) {
+                    vMNs.push_back(dmn);
+                }
+            });
 #endif
-    } else if (type == "valid" || type == "registered") {
-        if (request.params.size() > 4) {
-            protx_list_help();
-        }
+        } else if (type == "valid" || type == "registered") {
+            if (request.params.size() > 4) {
+                protx_list_help();
+            }
 
-        LOCK(cs_main);
+            detailed = request.params.size() > 2 ? ParseBoolV(request.params[2], "detailed") : false;
 
-        bool detailed = request.params.size() > 2 ? ParseBoolV(request.params[2], "detailed") : false;
+            int height = request.params.size() > 3 ? ParseInt32V(request.params[3], "height") : chainActive.Height();
+            if (height < 1 || height > chainActive.Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid height specified");
+            }
 
-        int height = request.params.size() > 3 ? ParseInt32V(request.params[3], "height") : chainActive.Height();
-        if (height < 1 || height > chainActive.Height()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid height specified");
+            CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
+            bool onlyValid = type == "valid";
+            mnList.ForEachMN(onlyValid, [&](const CDeterministicMNCPtr& dmn) {
+                vMNs.push_back(dmn);
+            });
+        } else {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid type specified");
         }
+    }
 
-        CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
-        bool onlyValid = type == "valid";
-        mnList.ForEachMN(onlyValid, [&](const CDeterministicMNCPtr& dmn) {
-            ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
-        });
-    } else {
-        throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid type specified");
+    // Detailed entries are built in batches under cs_main and can be streamed, cs_main is never held while
+    // waiting for the client.
+    static const size_t BATCH_SIZE = 1000;
+    CJSONStreamWriter* pwriter = nullptr;
+    if (request.CanStreamResult()) {
+        pwriter = &request.StreamResult();
+        pwriter->BeginArray();
     }
 
+    UniValue ret(UniValue::VARR);
+    std::vector<UniValue> vBatch;
+    for (size_t i = 0; i < vMNs.size(); i += BATCH_SIZE) {
+        vBatch.clear();
+        {
+            LOCK(cs_main);
+            for (size_t j = i; j < std::min(i + BATCH_SIZE, vMNs.size()); j++) {
+                vBatch.push_back(BuildDMNListEntry(pwallet, vMNs[j], detailed));
+            }
+        }
+        for (const auto& entry : vBatch) {
+            if (pwriter) {
+                pwriter->Value(entry);
+            } else {
+                ret.push_back(entry);
+            }
+        }
+    }
+
+    if (pwriter) {
+        pwriter->EndArray();
+        return NullUniValue;
+    }
     return ret;
 }
 
@@ -1644,7 +1677,9 @@ UniValue datalist(const JSONRPCRequest& request)
 		dDays = cdbl(request.params[1].get_str(),0);
 	int iSpecificEntry = 0;
 	std::string sEntry;
-	UniValue aDataList = GetDataList(sType, (int)dDays, iSpecificEntry, "", sEntry);
+	// prayers and diaries pile up, stream them when the transport allows it
+	CJSONStreamWriter* pwriter = request.CanStreamResult() ? &request.StreamResult() : nullptr;
+	UniValue aDataList = GetDataList(sType, (int)dDays, iSpecificEntry, "", sEntry, pwriter);
 	return aDataList;
 }
 
@@ -8,6 +8,7 @@
 #include "rpc/server.h"
 
 #include "base58.h"
+#include "httpserver.h"
 #include "init.h"
 #include "random.h"
 #include "sync.h"
@@ -317,6 +318,70 @@ UniValue stop(const JSONRPCRequest& jsonRequest)
     return "BiblePay Core server stopping";
 }
 
+UniValue getrpcinfo(const JSONRPCRequest& jsonRequest)
+{
+    if (jsonRequest.fHelp || jsonRequest.params.size() != 0)
+        throw std::runtime_error(
+            "getrpcinfo\n"
+            "\nReturns the state of the HTTP work queues and per method timings since startup.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"queues\": [              (array) one entry per work queue\n"
+            "    {\n"
+            "      \"name\": \"xxx\",       (string) default, fast, slow or wallet\n"
+            "      \"threads\": n,         (numeric) number of worker threads\n"
+            "      \"running\": n,         (numeric) requests being handled right now\n"
+            "      \"depth\": n,           (numeric) requests waiting for a thread\n"
+            "      \"maxdepth\": n,        (numeric) requests beyond this are rejected\n"
+            "      \"rejected\": n         (numeric) requests rejected since startup\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"methods\": {             (object) per method (\"batch\" for batch requests)\n"
+            "    \"method\": {\n"
+            "      \"count\": n,           (numeric) requests handled\n"
+            "      \"rejected\": n,        (numeric) requests rejected because the queue was full\n"
+            "      \"avgwait\": n,         (numeric) average time spent in the queue, in microseconds\n"
+            "      \"maxwait\": n,         (numeric) longest time spent in the queue, in microseconds\n"
+            "      \"avgexec\": n,         (numeric) average time spent executing, in microseconds\n"
+            "      \"maxexec\": n          (numeric) longest time spent executing, in microseconds\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrpcinfo", "")
+            + HelpExampleRpc("getrpcinfo", ""));
+
+    UniValue queues(UniValue::VARR);
+    for (const auto& stats : GetHTTPWorkQueueStats()) {
+        UniValue queue(UniValue::VOBJ);
+        queue.push_back(Pair("name", stats.name));
+        queue.push_back(Pair("threads", stats.nThreads));
+        queue.push_back(Pair("running", stats.nRunning));
+        queue.push_back(Pair("depth", (uint64_t)stats.nDepth));
+        queue.push_back(Pair("maxdepth", (uint64_t)stats.nMaxDepth));
+        queue.push_back(Pair("rejected", stats.nRejected));
+        queues.push_back(queue);
+    }
+
+    UniValue methods(UniValue::VOBJ);
+    for (const auto& p : GetHTTPWorkLabelStats()) {
+        const HTTPWorkLabelStats& stats = p.second;
+        UniValue method(UniValue::VOBJ);
+        method.push_back(Pair("count", stats.nCount));
+        method.push_back(Pair("rejected", stats.nRejected));
+        method.push_back(Pair("avgwait", stats.nCount ? stats.nWaitTotal / (int64_t)stats.nCount : 0));
+        method.push_back(Pair("maxwait", stats.nWaitMax));
+        method.push_back(Pair("avgexec", stats.nCount ? stats.nExecTotal / (int64_t)stats.nCount : 0));
+        method.push_back(Pair("maxexec", stats.nExecMax));
+        methods.push_back(Pair(p.first, method));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("queues", queues));
+    result.push_back(Pair("methods", methods));
+    return result;
+}
+
 /**
  * Call Table
  */
@@ -326,6 +391,7 @@ static const CRPCCommand vRPCCommands[] =
     /* Overall control/query calls */
     { "control",            "help",                   &help,                   true,  {"command"}  },
     { "control",            "stop",                   &stop,                   true,  {}  },
+    { "control",            "getrpcinfo",             &getrpcinfo,             true,  {}  },
 };
 
 CRPCTable::CRPCTable()
@@ -411,6 +477,25 @@ bool RPCIsInWarmup(std::string *outStatus)
     return fRPCInWarmup;
 }
 
+CJSONStreamWriter& JSONRPCRequest::StreamResult() const
+{
+    assert(resultWriter && resultWriter->IsEmpty());
+    // same layout as JSONRPCReplyObj
+    resultWriter->BeginObject();
+    resultWriter->Key("result");
+    return *resultWriter;
+}
+
+void JSONRPCRequest::FinishStreamedResult() const
+{
+    assert(IsResultStreamed());
+    resultWriter->Pair("error", NullUniValue);
+    resultWriter->Pair("id", id);
+    resultWriter->EndObject();
+    resultWriter->Raw("\n");
+    resultWriter->Flush();
+}
+
 void JSONRPCRequest::parse(const UniValue& valRequest)
 {
     // Parse request
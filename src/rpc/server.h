@@ -7,11 +7,13 @@
 #define BITCOIN_RPCSERVER_H
 
 #include "amount.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h"
 #include "uint256.h"
 
 #include <list>
 #include <map>
+#include <memory>
 #include <stdint.h>
 #include <string>
 
@@ -50,9 +52,21 @@ public:
     bool fHelp;
     std::string URI;
     std::string authUser;
+    /** Set by transports which can send the result while it is being generated, see StreamResult */
+    std::shared_ptr<CJSONStreamWriter> resultWriter;
 
     JSONRPCRequest() { id = NullUniValue; params = NullUniValue; fHelp = false; }
     void parse(const UniValue& valRequest);
+
+    bool CanStreamResult() const { return resultWriter != nullptr; }
+    /**
+     * Starts the reply. The handler then writes exactly one value (the result) to the returned writer
+     * and returns NullUniValue. Only call this if CanStreamResult() is true.
+     */
+    CJSONStreamWriter& StreamResult() const;
+    /** Finishes the reply envelope after a streamed result */
+    void FinishStreamedResult() const;
+    bool IsResultStreamed() const { return resultWriter && !resultWriter->IsEmpty(); }
 };
 
 /** Query whether RPC is running */
@@ -1328,7 +1328,7 @@ int GetSignalInt(std::string sLocalSignal)
 	return 0;
 }
 
-UniValue GetDataList(std::string sType, int iMaxAgeInDays, int& iSpecificEntry, std::string sSearch, std::string& outEntry)
+UniValue GetDataList(std::string sType, int iMaxAgeInDays, int& iSpecificEntry, std::string sSearch, std::string& outEntry, CJSONStreamWriter* pwriter)
 {
 	int64_t nEpoch = GetAdjustedTime() - (iMaxAgeInDays * 86400);
 	if (nEpoch < 0) nEpoch = 0;
@@ -1336,39 +1336,61 @@ UniValue GetDataList(std::string sType, int iMaxAgeInDays, int& iSpecificEntry,
 	boost::to_upper(sType);
 	if (sType=="PRAYERS")
 		sType="PRAYER";  // Just in case the user specified PRAYERS
-	ret.push_back(Pair("DataList",sType));
+	auto fnPush = [&](const std::string& sKey, const std::string& sValue)
+	{
+		if (pwriter)
+			pwriter->Pair(sKey, sValue);
+		else
+			ret.push_back(Pair(sKey, sValue));
+	};
+	if (pwriter)
+		pwriter->BeginObject();
+	fnPush("DataList", sType);
 	int iPos = 0;
 	int iTotalRecords = 0;
-	for (auto ii : mvApplicationCache) 
-	{
-		if (ii.first.first == sType)
-		{
-			std::pair<std::string, int64_t> v = mvApplicationCache[std::make_pair(ii.first.first, ii.first.second)];
-			int64_t nTimestamp = v.second;
-			if (nTimestamp > nEpoch || nTimestamp == 0)
+	// The entries of a type are adjacent in the cache. They are visited in batches under csWriteWait, which is never
+	// held while a streamed result waits for the client.
+	static const size_t BATCH_SIZE = 1000;
+	std::vector<std::pair<std::string, std::string> > vBatch;
+	std::pair<std::string, std::string> keyLast = std::make_pair(sType, std::string());
+	bool fFirst = true;
+	bool fDone = false;
+	while (!fDone)
+	{
+		vBatch.clear();
+		{
+			LOCK(csWriteWait);
+			auto it = fFirst ? mvApplicationCache.lower_bound(keyLast) : mvApplicationCache.upper_bound(keyLast);
+			for (; it != mvApplicationCache.end() && it->first.first == sType && vBatch.size() < BATCH_SIZE; ++it)
 			{
-				iTotalRecords++;
-				if (iPos == iSpecificEntry) 
-					outEntry = v.first;
-				std::string sTimestamp = TimestampToHRDate((double)nTimestamp);
-				if (!sSearch.empty())
+				keyLast = it->first;
+				int64_t nTimestamp = it->second.second;
+				if (nTimestamp > nEpoch || nTimestamp == 0)
 				{
-					if (boost::iequals(ii.first.first, sSearch) || Contains(ii.first.second, sSearch))
-					{
-						ret.push_back(Pair(ii.first.second + " (" + sTimestamp + ")", v.first));
-					}
+					iTotalRecords++;
+					if (iPos == iSpecificEntry) 
+						outEntry = it->second.first;
+					iPos++;
+					if (!sSearch.empty() && !boost::iequals(it->first.first, sSearch) && !Contains(it->first.second, sSearch))
+						continue;
+					std::string sTimestamp = TimestampToHRDate((double)nTimestamp);
+					vBatch.push_back(std::make_pair(it->first.second + " (" + sTimestamp + ")", it->second.first));
 				}
-				else
-				{
-					ret.push_back(Pair(ii.first.second + " (" + sTimestamp + ")", v.first));
-				}
-				iPos++;
 			}
+			fDone = it == mvApplicationCache.end() || it->first.first != sType;
 		}
+		fFirst = false;
+		for (const auto& p : vBatch)
+			fnPush(p.first, p.second);
 	}
 	iSpecificEntry++;
 	if (iSpecificEntry >= iTotalRecords)
 		iSpecificEntry=0;  // Reset the iterator.
+	if (pwriter)
+	{
+		pwriter->EndObject();
+		return NullUniValue;
+	}
 	return ret;
 }
 
@@ -10,6 +10,7 @@
 #include "net.h"
 #include "utilstrencodings.h"
 #include "validation.h"
+#include "rpc/jsonstream.h"
 #include <univalue.h>
 
 class CWallet;
@@ -205,7 +206,8 @@ bool SubmitProposalToNetwork(uint256 txidFee, int64_t nStartTime, std::string sH
 int GetLastDCSuperblockWithPayment(int nChainHeight);
 std::string SubmitToIPFS(std::string sPath, std::string& sError);
 std::string SendBusinessObject(std::string sType, std::string sPrimaryKey, std::string sValue, double dStorageFee, std::string sSignKey, bool fSign, std::string& sError);
-UniValue GetDataList(std::string sType, int iMaxAgeInDays, int& iSpecificEntry, std::string sSearch, std::string& outEntry);
+/** Writes the list to pwriter instead of returning it if it is given */
+UniValue GetDataList(std::string sType, int iMaxAgeInDays, int& iSpecificEntry, std::string sSearch, std::string& outEntry, CJSONStreamWriter* pwriter = nullptr);
 UserVote GetSumOfSignal(std::string sType, std::string sIPFSHash);
 int GetSignalInt(std::string sLocalSignal);
 double GetDifficulty(const CBlockIndex* blockindex);
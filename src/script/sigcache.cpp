@@ -5,13 +5,20 @@
 
 #include "sigcache.h"
 
+#include "chainparams.h"
+#include "clientversion.h"
+#include "crypto/hmac_sha256.h"
+#include "hash.h"
 #include "memusage.h"
 #include "pubkey.h"
 #include "random.h"
+#include "streams.h"
 #include "uint256.h"
 #include "util.h"
 
 #include "cuckoocache.h"
+#include <atomic>
+#include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
 
 namespace {
@@ -50,9 +57,11 @@ private:
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
     map_type setValid;
     boost::shared_mutex cs_sigcache;
+    //! Set once an entry was inserted under the current nonce
+    std::atomic<bool> fUsed;
 
 public:
-    CSignatureCache()
+    CSignatureCache() : fUsed(false)
     {
         GetRandBytes(nonce.begin(), 32);
     }
@@ -73,12 +82,43 @@ public:
     void Set(uint256& entry)
     {
         boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        fUsed = true;
         setValid.insert(entry);
     }
     uint32_t setup_bytes(size_t n)
     {
         return setValid.setup_bytes(n);
     }
+
+    void GetSnapshot(std::vector<uint256>& vEntries)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        setValid.for_each_live([&vEntries](const uint256& entry) { vEntries.push_back(entry); });
+    }
+
+    /**
+     * Replace the random nonce by one which is kept across restarts. Entries
+     * are only valid for the nonce they were computed with, so this is refused
+     * once an entry was computed. Must not run concurrently with ComputeEntry,
+     * i.e. before script verification starts.
+     */
+    bool SetNonce(const uint256& nonceIn)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        if (fUsed)
+            return false;
+        nonce = nonceIn;
+        return true;
+    }
+
+    /** Take over the entries of a snapshot taken under the current nonce */
+    void LoadSnapshot(const std::vector<uint256>& vEntries)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        fUsed = true;
+        for (const uint256& entry : vEntries)
+            setValid.insert(entry);
+    }
 };
 
 /* In previous versions of this code, signatureCache was a local static variable
@@ -102,6 +142,179 @@ void InitSignatureCache()
             (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
 }
 
+static const uint32_t SIGCACHE_DUMP_VERSION = 2;
+
+/**
+ * A persisted signature cache is only good with the nonce its entries were computed
+ * with, and an entry in it lets a signature pass unchecked. So the nonce never goes
+ * into the snapshot: both it and the key authenticating the snapshot are derived
+ * from a secret of this node, kept in its own file.
+ */
+static bool fHaveSnapshotKey = false;
+static uint256 snapshotKey;
+
+static boost::filesystem::path GetSignatureCachePath()
+{
+    return GetDataDir() / "sigcache.dat";
+}
+
+static boost::filesystem::path GetSignatureCacheKeyPath()
+{
+    return GetDataDir() / "sigcache.key";
+}
+
+static uint256 DeriveSignatureCacheKey(const uint256& secret, const std::string& strPurpose)
+{
+    uint256 key;
+    CHMAC_SHA256(secret.begin(), secret.size()).Write((const unsigned char*)strPurpose.data(), strPurpose.size()).Finalize(key.begin());
+    return key;
+}
+
+static uint256 SnapshotMAC(const CDataStream& ssSigCache)
+{
+    uint256 mac;
+    CHMAC_SHA256(snapshotKey.begin(), snapshotKey.size()).Write((const unsigned char*)&ssSigCache[0], ssSigCache.size()).Finalize(mac.begin());
+    return mac;
+}
+
+/** Read the secret of this node, or create one */
+static bool ReadSignatureCacheSecret(uint256& secret)
+{
+    boost::filesystem::path pathKey = GetSignatureCacheKeyPath();
+    CAutoFile filein(fopen(pathKey.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    if (!filein.IsNull()) {
+        try {
+            filein >> secret;
+            return true;
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize or I/O error - %s, creating a new key\n", __func__, e.what());
+        }
+    }
+    filein.fclose();
+
+    GetRandBytes(secret.begin(), secret.size());
+    /** the umask determines what permissions are used to create this file -
+     * these are set to 077 in init.cpp unless overridden with -sysperms.
+     */
+    CAutoFile fileout(fopen(pathKey.string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull())
+        return error("%s: Failed to open file %s", __func__, pathKey.string());
+    try {
+        fileout << secret;
+    } catch (const std::exception& e) {
+        return error("%s: Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout.Get());
+    return true;
+}
+
+bool LoadSignatureCache()
+{
+    uint256 secret;
+    if (!ReadSignatureCacheSecret(secret))
+        return error("%s: No signature cache key, the signature cache will not be persisted", __func__);
+    if (!signatureCache.SetNonce(DeriveSignatureCacheKey(secret, "sigcache nonce")))
+        return error("%s: Signature cache already in use, it will not be persisted", __func__);
+    snapshotKey = DeriveSignatureCacheKey(secret, "sigcache snapshot");
+    fHaveSnapshotKey = true;
+
+    boost::filesystem::path pathSigCache = GetSignatureCachePath();
+    FILE *file = fopen(pathSigCache.string().c_str(), "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        LogPrintf("No signature cache snapshot on disk, starting with an empty signature cache\n");
+        return false;
+    }
+
+    uint64_t fileSize = boost::filesystem::file_size(pathSigCache);
+    uint64_t dataSize = fileSize >= sizeof(uint256) ? fileSize - sizeof(uint256) : 0;
+    std::vector<unsigned char> vchData(dataSize);
+    uint256 macIn;
+    try {
+        filein.read((char *)vchData.data(), dataSize);
+        filein >> macIn;
+    } catch (const std::exception& e) {
+        filein.fclose();
+        boost::filesystem::remove(pathSigCache);
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    filein.fclose();
+    // The snapshot is only good for one start, whatever happens after this
+    boost::filesystem::remove(pathSigCache);
+
+    // Nothing of a snapshot which was not written by this node under its current key is used
+    CDataStream ssSigCache(vchData, SER_DISK, CLIENT_VERSION);
+    if (vchData.empty() || macIn != SnapshotMAC(ssSigCache))
+        return error("%s: Authentication failed, dropping snapshot", __func__);
+
+    unsigned char pchMsgTmp[4];
+    uint32_t nVersion;
+    uint256 hashGenesis;
+    std::vector<uint256> vEntries;
+    try {
+        ssSigCache >> FLATDATA(pchMsgTmp);
+        ssSigCache >> nVersion;
+        ssSigCache >> hashGenesis;
+        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)) || hashGenesis != Params().GenesisBlock().GetHash())
+            return error("%s: Invalid network magic number", __func__);
+        if (nVersion != SIGCACHE_DUMP_VERSION)
+            return error("%s: Unsupported snapshot version %u", __func__, nVersion);
+        ssSigCache >> vEntries;
+        if (!ssSigCache.empty())
+            return error("%s: Trailing data after the entries, dropping snapshot", __func__);
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    signatureCache.LoadSnapshot(vEntries);
+
+    LogPrintf("Loaded %u signature cache entries from %s\n", vEntries.size(), pathSigCache.string());
+    return true;
+}
+
+void DumpSignatureCache()
+{
+    if (!fHaveSnapshotKey) {
+        LogPrintf("%s: No signature cache key, not writing a snapshot\n", __func__);
+        return;
+    }
+
+    int64_t nStart = GetTimeMicros();
+
+    std::vector<uint256> vEntries;
+    signatureCache.GetSnapshot(vEntries);
+
+    CDataStream ssSigCache(SER_DISK, CLIENT_VERSION);
+    ssSigCache << FLATDATA(Params().MessageStart());
+    ssSigCache << SIGCACHE_DUMP_VERSION;
+    ssSigCache << Params().GenesisBlock().GetHash();
+    ssSigCache << vEntries;
+    uint256 mac = SnapshotMAC(ssSigCache);
+    ssSigCache << mac;
+
+    boost::filesystem::path pathTmp = GetDataDir() / "sigcache.dat.new";
+    FILE *file = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull()) {
+        LogPrintf("%s: Failed to open file %s\n", __func__, pathTmp.string());
+        return;
+    }
+    try {
+        fileout << ssSigCache;
+    } catch (const std::exception& e) {
+        LogPrintf("%s: Serialize or I/O error - %s\n", __func__, e.what());
+        return;
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+    if (!RenameOver(pathTmp, GetSignatureCachePath())) {
+        LogPrintf("%s: Rename-into-place failed\n", __func__);
+        return;
+    }
+
+    LogPrintf("Dumped %u signature cache entries: %gs\n", vEntries.size(), (GetTimeMicros() - nStart) * 0.000001);
+}
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
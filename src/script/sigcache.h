@@ -16,6 +16,8 @@
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Don't keep the signature cache across restarts by default
+static const bool DEFAULT_PERSIST_SIG_CACHE = false;
 
 class CPubKey;
 
@@ -32,4 +34,14 @@ public:
 
 void InitSignatureCache();
 
+/**
+ * Switch the signature cache to the nonce kept in sigcache.key, creating the key
+ * if needed, and load the snapshot written by DumpSignatureCache() if it was
+ * written under that key. Has to be called right after InitSignatureCache(),
+ * before any signature was checked. The snapshot is removed from disk.
+ */
+bool LoadSignatureCache();
+/** Write the valid entries of the signature cache to disk, authenticated with the key of LoadSignatureCache() */
+void DumpSignatureCache();
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -1385,11 +1385,18 @@ bool Included(std::string sFilterNickName, std::string sCPK)
 	return fIncluded;
 }
 
-UniValue GetProminenceLevels(int nHeight, std::string sFilterNickName)
+UniValue GetProminenceLevels(int nHeight, std::string sFilterNickName, CJSONStreamWriter* pwriter)
 {
 	UniValue results(UniValue::VOBJ);
 	if (nHeight == 0) 
 		return NullUniValue;
+	auto fnPush = [&](const std::string& sKey, const std::string& sValue)
+	{
+		if (pwriter)
+			pwriter->Pair(sKey, sValue);
+		else
+			results.push_back(Pair(sKey, sValue));
+	};
       
 	CAmount nPaymentsLimit = CSuperblock::GetPaymentsLimit(nHeight, false);
 	nPaymentsLimit -= MAX_BLOCK_SUBSIDY * COIN;
@@ -1401,7 +1408,9 @@ UniValue GetProminenceLevels(int nHeight, std::string sFilterNickName)
 	std::vector<std::string> vData = Split(sData.c_str(), "\n");
 	std::vector<std::string> vDetails = Split(sDetails.c_str(), "\n");
 	std::vector<std::string> vDiaries = Split(sDiaries.c_str(), "\n");
-	results.push_back(Pair("Prominence v1.1", "Details"));
+	if (pwriter)
+		pwriter->BeginObject();
+	fnPush("Prominence v1.1", "Details");
 	// DETAIL ROW FORMAT: sCampaignName + "|" + Members.Address + "|" + nPoints + "|" + nProminence + "|" + NickName + "|\n";
 	std::string sMyCPK = DefaultRecAddress("Christian-Public-Key");
 
@@ -1420,11 +1429,11 @@ UniValue GetProminenceLevels(int nHeight, std::string sFilterNickName)
 				sNickName = "N/A";
 			std::string sNarr = sCampaignName + ": " + sCPK + " [" + sNickName + "], Pts: " + RoundToString(nPoints, 2);
 			if (Included(sFilterNickName, sCPK))
-				results.push_back(Pair(sNarr, RoundToString(nProminence, 2) + "%"));
+				fnPush(sNarr, RoundToString(nProminence, 2) + "%");
 		}
 	}
 	if (vDiaries.size() > 0)
-		results.push_back(Pair("Healing", "Diary Entries"));
+		fnPush("Healing", "Diary Entries");
 	for (int i = 0; i < vDiaries.size(); i++)
 	{
 		std::vector<std::string> vRow = Split(vDiaries[i].c_str(), "|");
@@ -1432,14 +1441,14 @@ UniValue GetProminenceLevels(int nHeight, std::string sFilterNickName)
 		{
 			std::string sCPK = vRow[0];
 			if (Included(sFilterNickName, sCPK))
-				results.push_back(Pair(Caption(vRow[1], 10), vRow[2]));
+				fnPush(Caption(vRow[1], 10), vRow[2]);
 		}
 	}
 
 	double dTotalPaid = 0;
 	// Allow room for a change in QT between first contract creation time and next superblock
 	double nMaxContractPercentage = .98;
-	results.push_back(Pair("Prominence", "Totals"));
+	fnPush("Prominence", "Totals");
 	for (int i = 0; i < vData.size(); i++)
 	{
 		std::vector<std::string> vRow = Split(vData[i].c_str(), "|");
@@ -1457,10 +1466,15 @@ UniValue GetProminenceLevels(int nHeight, std::string sFilterNickName)
 			std::string sNarr = sCampaign + ": " + sCPK + " [" + Caption(sNickName, 10) + "]" + ", Pts: " + RoundToString(nPoints, 2) 
 				+ ", Reward: " + RoundToString(nPayment, 3);
 			if (Included(sFilterNickName, sCPK))
-				results.push_back(Pair(sNarr, RoundToString(nProminence, 3) + "%"));
+				fnPush(sNarr, RoundToString(nProminence, 3) + "%");
 		}
 	}
 
+	if (pwriter)
+	{
+		pwriter->EndObject();
+		return NullUniValue;
+	}
 	return results;
 }
 
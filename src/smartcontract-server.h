@@ -10,6 +10,7 @@
 #include "net.h"
 #include "utilstrencodings.h"
 #include "rpcpog.h"
+#include "rpc/jsonstream.h"
 #include <univalue.h>
 
 class CWallet;
@@ -23,7 +24,8 @@ uint256 GetPAMHashByContract(std::string sContract);
 uint256 GetPAMHash(std::string sAddresses, std::string sAmounts);
 bool VoteForGSCContract(int nHeight, std::string sMyContract, std::string& sError);
 std::string ExecuteGenericSmartContractQuorumProcess();
-UniValue GetProminenceLevels(int nHeight, std::string sFilterName);
+/** Writes the levels to pwriter instead of returning them if it is given */
+UniValue GetProminenceLevels(int nHeight, std::string sFilterName, CJSONStreamWriter* pwriter = nullptr);
 bool NickNameExists(std::string sProjectName, std::string sNickName);
 int GetRequiredQuorumLevel(int nHeight);
 void GetTransactionPoints(CBlockIndex* pindex, CTransactionRef tx, double& nCoinAge, CAmount& nDonation);
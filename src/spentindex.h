@@ -369,5 +369,31 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+/** Running totals of an address, kept up to date while blocks are connected and disconnected */
+struct CAddressBalance {
+    CAmount balance;
+    CAmount received;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+    }
+
+    CAddressBalance() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0;
+    }
+};
 
 #endif // BITCOIN_SPENTINDEX_H
@@ -123,14 +123,8 @@ void CSporkManager::ProcessSpork(CNode* pfrom, const std::string& strCommand, CD
 
         uint256 hash = spork.GetHash();
 
-        std::string strLogMsg;
-        {
-            LOCK(cs_main);
-            connman.RemoveAskFor(hash);
-            if(!chainActive.Tip()) 
-				return;
-            strLogMsg = strprintf("SPORK -- hash: %s id: %d value: %10d bestHeight: %d peer=%d", hash.ToString(), spork.nSporkID, spork.nValue, chainActive.Height(), pfrom->id);
-        }
+        connman.RemoveAskFor(hash);
+        std::string strLogMsg = strprintf("SPORK -- hash: %s id: %d value: %10d bestHeight: %d peer=%d", hash.ToString(), spork.nSporkID, spork.nValue, connman.GetBestHeight(), pfrom->id);
 
         if (spork.nTimeSigned > GetAdjustedTime() + 2 * 60 * 60) {
             LOCK(cs_main);
@@ -0,0 +1,272 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+#define BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+
+#include <algorithm>
+#include <assert.h>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <new>
+#include <vector>
+
+/**
+ * Memory resource for node based containers, which allocate many objects of the
+ * same few sizes and free them one by one.
+ *
+ * Memory is taken from the system in chunks of ChunkSizeBytes(). Blocks of up to
+ * MAX_BLOCK_SIZE_BYTES are carved out of the current chunk and, when freed, put on
+ * a free list for their size, from which later allocations of that size are served.
+ * Chunks are only given back when the resource is destroyed, which releases all of
+ * them at once instead of one block after another. Larger blocks, like the bucket
+ * array of a hash map with more than a few buckets, go straight to operator new.
+ *
+ * This keeps the many small allocations of a large cache away from malloc, so they
+ * neither cost a call each nor fragment the heap, and the memory the container
+ * holds is exactly NumAllocatedChunks() * ChunkSizeBytes() plus its large blocks.
+ *
+ * To give memory back without emptying the container, chunks can be retired: see
+ * RetireChunks().
+ *
+ * Not thread safe, like the containers using it.
+ */
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+class PoolResource
+{
+    static_assert(ALIGN_BYTES > 0 && (ALIGN_BYTES & (ALIGN_BYTES - 1)) == 0, "ALIGN_BYTES must be a power of two");
+
+    /** Header of a free block, which links it into the free list for its size */
+    struct ListNode {
+        ListNode* pNext;
+        explicit ListNode(ListNode* pNextIn) : pNext(pNextIn) {}
+    };
+
+    /** Blocks are multiples of this size, so every block can hold a ListNode and is aligned */
+    static constexpr std::size_t ELEM_ALIGN_BYTES = ALIGN_BYTES > alignof(ListNode) ? ALIGN_BYTES : alignof(ListNode);
+    static_assert(MAX_BLOCK_SIZE_BYTES >= ELEM_ALIGN_BYTES, "MAX_BLOCK_SIZE_BYTES too small");
+
+    const std::size_t nChunkSizeBytes;
+
+    /** Free lists, indexed by block size in units of ELEM_ALIGN_BYTES */
+    std::vector<ListNode*> vFreeLists;
+
+    /** All chunks taken from the system, released in the destructor */
+    std::list<char*> listChunks;
+
+    /** Part of the newest chunk which has not been handed out yet */
+    char* pAvailable;
+    char* pAvailableEnd;
+
+    /** The chunks sorted by address, with those being retired marked, between IndexChunks() and ReleaseRetiredChunks() */
+    std::vector<char*> vIndexedChunks;
+    std::vector<bool> vRetired;
+    bool fRetiring;
+
+    static constexpr std::size_t RoundUpToElemAlign(std::size_t nBytes)
+    {
+        return (nBytes + ELEM_ALIGN_BYTES - 1) / ELEM_ALIGN_BYTES * ELEM_ALIGN_BYTES;
+    }
+
+    static constexpr bool IsPooled(std::size_t nBytes, std::size_t nAlignment)
+    {
+        return nAlignment <= ELEM_ALIGN_BYTES && nBytes <= MAX_BLOCK_SIZE_BYTES;
+    }
+
+    void PushFree(char* p, std::size_t nIndex)
+    {
+        vFreeLists[nIndex] = new (p) ListNode(vFreeLists[nIndex]);
+    }
+
+    /** Put the rest of the current chunk on the free lists and start a new one */
+    void AllocateChunk()
+    {
+        std::size_t nRemaining = pAvailableEnd - pAvailable;
+        if (nRemaining > 0) {
+            PushFree(pAvailable, nRemaining / ELEM_ALIGN_BYTES);
+        }
+        char* pChunk = static_cast<char*>(::operator new(nChunkSizeBytes));
+        listChunks.push_back(pChunk);
+        pAvailable = pChunk;
+        pAvailableEnd = pChunk + nChunkSizeBytes;
+    }
+
+public:
+    /** Largest block served from the chunks */
+    static constexpr std::size_t MAX_BLOCK_SIZE = MAX_BLOCK_SIZE_BYTES;
+
+    explicit PoolResource(std::size_t nChunkSizeBytesIn = 262144) :
+        nChunkSizeBytes(RoundUpToElemAlign(std::max(nChunkSizeBytesIn, MAX_BLOCK_SIZE_BYTES))),
+        vFreeLists(RoundUpToElemAlign(MAX_BLOCK_SIZE_BYTES) / ELEM_ALIGN_BYTES + 1, nullptr),
+        pAvailable(nullptr),
+        pAvailableEnd(nullptr),
+        fRetiring(false)
+    {
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource()
+    {
+        for (char* pChunk : listChunks) {
+            ::operator delete(pChunk);
+        }
+    }
+
+    void* Allocate(std::size_t nBytes, std::size_t nAlignment)
+    {
+        if (!IsPooled(nBytes, nAlignment)) {
+            return ::operator new(nBytes);
+        }
+        std::size_t nBlockBytes = RoundUpToElemAlign(nBytes);
+        std::size_t nIndex = nBlockBytes / ELEM_ALIGN_BYTES;
+        if (vFreeLists[nIndex] != nullptr) {
+            ListNode* pNode = vFreeLists[nIndex];
+            vFreeLists[nIndex] = pNode->pNext;
+            return pNode;
+        }
+        if (static_cast<std::size_t>(pAvailableEnd - pAvailable) < nBlockBytes) {
+            AllocateChunk();
+        }
+        char* p = pAvailable;
+        pAvailable += nBlockBytes;
+        return p;
+    }
+
+    void Deallocate(void* p, std::size_t nBytes, std::size_t nAlignment) noexcept
+    {
+        if (!IsPooled(nBytes, nAlignment)) {
+            ::operator delete(p);
+            return;
+        }
+        if (fRetiring && IsRetired(p)) {
+            return;
+        }
+        PushFree(static_cast<char*>(p), RoundUpToElemAlign(nBytes) / ELEM_ALIGN_BYTES);
+    }
+
+    std::size_t NumAllocatedChunks() const { return listChunks.size(); }
+    std::size_t ChunkSizeBytes() const { return nChunkSizeBytes; }
+
+    /** Number the chunks there are now, for ChunkIndex() and RetireChunks() */
+    void IndexChunks()
+    {
+        vIndexedChunks.assign(listChunks.begin(), listChunks.end());
+        std::sort(vIndexedChunks.begin(), vIndexedChunks.end(), std::less<char*>());
+        vRetired.assign(vIndexedChunks.size(), false);
+    }
+
+    /** Number of the indexed chunk a pooled block lies in, or -1 for one taken after IndexChunks() */
+    int ChunkIndex(const void* p) const
+    {
+        const char* pc = static_cast<const char*>(p);
+        std::vector<char*>::const_iterator it = std::upper_bound(vIndexedChunks.begin(), vIndexedChunks.end(), pc, std::less<const char*>());
+        if (it == vIndexedChunks.begin() || pc >= *(it - 1) + nChunkSizeBytes) {
+            return -1;
+        }
+        return it - vIndexedChunks.begin() - 1;
+    }
+
+    bool IsRetired(const void* p) const
+    {
+        int nChunk = ChunkIndex(p);
+        return nChunk >= 0 && vRetired[nChunk];
+    }
+
+    /**
+     * Stop handing out the memory of the indexed chunks for which vRetire is set: their
+     * free blocks are dropped and blocks in them which are freed later are not reused.
+     * The caller then moves the blocks still in use out of them, by allocating new ones,
+     * which come from the other chunks, and freeing the old, and gives them back to the
+     * system with ReleaseRetiredChunks(). Only one container may still use a retired chunk.
+     */
+    void RetireChunks(const std::vector<bool>& vRetire)
+    {
+        assert(vRetire.size() == vIndexedChunks.size());
+        vRetired = vRetire;
+        fRetiring = true;
+        for (ListNode*& pFree : vFreeLists) {
+            ListNode** ppNext = &pFree;
+            while (*ppNext != nullptr) {
+                if (IsRetired(*ppNext)) {
+                    *ppNext = (*ppNext)->pNext;
+                } else {
+                    ppNext = &(*ppNext)->pNext;
+                }
+            }
+        }
+        if (pAvailable != nullptr && IsRetired(pAvailable)) {
+            pAvailable = pAvailableEnd = nullptr;
+        }
+    }
+
+    /** Free the retired chunks, which must not hold blocks in use anymore */
+    void ReleaseRetiredChunks()
+    {
+        for (std::list<char*>::iterator it = listChunks.begin(); it != listChunks.end();) {
+            if (IsRetired(*it)) {
+                ::operator delete(*it);
+                it = listChunks.erase(it);
+            } else {
+                it++;
+            }
+        }
+        vIndexedChunks.clear();
+        vRetired.clear();
+        fRetiring = false;
+    }
+};
+
+/**
+ * Allocator handing out memory of a PoolResource, for use with std containers.
+ * All copies and rebinds share the resource, which has to outlive the container.
+ */
+template <class T, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES = alignof(T)>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> ResourceType;
+
+    template <class U>
+    struct rebind {
+        typedef PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> other;
+    };
+
+    PoolAllocator(ResourceType* resourceIn) noexcept : resource(resourceIn) {}
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) noexcept : resource(other.GetResource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    ResourceType* GetResource() const noexcept { return resource; }
+
+private:
+    ResourceType* resource;
+};
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator==(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a, const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return a.GetResource() == b.GetResource();
+}
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator!=(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a, const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_POOL_H
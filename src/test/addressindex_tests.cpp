@@ -0,0 +1,160 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "spentindex.h"
+#include "txdb.h"
+#include "utilstrencodings.h"
+
+#include "test/test_biblepay.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+static std::vector<std::pair<CAddressIndexKey, CAmount> > BuildBlockEntries(const uint160& addressHash, int nHeight, int nCount)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vect;
+    for (int i = 0; i < nCount; i++) {
+        bool fSpending = i % 3 == 2;
+        CAmount nValue = (i + 1) * COIN;
+        vect.emplace_back(CAddressIndexKey(1, addressHash, nHeight, i / 2, GetRandHash(), i, fSpending), fSpending ? -nValue : nValue);
+    }
+    return vect;
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_balance)
+{
+    CBlockTreeDB db(1 << 20, true, true);
+    uint160 addressHash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314"));
+    uint160 otherHash = uint160(ParseHex("1112131415161718191a1b1c1d1e1f2021222324"));
+
+    auto vect1 = BuildBlockEntries(addressHash, 10, 9);
+    auto vect2 = BuildBlockEntries(addressHash, 11, 6);
+    auto vectOther = BuildBlockEntries(otherHash, 11, 3);
+    vect2.insert(vect2.end(), vectOther.begin(), vectOther.end());
+
+    CAmount nBalance1 = 0, nReceived1 = 0;
+    for (const auto& p : vect1) {
+        nBalance1 += p.second;
+        nReceived1 += std::max<CAmount>(0, p.second);
+    }
+    CAmount nBalance2 = nBalance1, nReceived2 = nReceived1;
+    for (const auto& p : vect2) {
+        if (p.first.hashBytes != addressHash)
+            continue;
+        nBalance2 += p.second;
+        nReceived2 += std::max<CAmount>(0, p.second);
+    }
+
+    CAddressBalance balance;
+    BOOST_CHECK(db.WriteAddressIndex(vect1, true));
+    BOOST_CHECK(db.ReadAddressBalance(addressHash, 1, balance));
+    BOOST_CHECK_EQUAL(balance.balance, nBalance1);
+    BOOST_CHECK_EQUAL(balance.received, nReceived1);
+
+    BOOST_CHECK(db.WriteAddressIndex(vect2, true));
+    BOOST_CHECK(db.ReadAddressBalance(addressHash, 1, balance));
+    BOOST_CHECK_EQUAL(balance.balance, nBalance2);
+    BOOST_CHECK_EQUAL(balance.received, nReceived2);
+    BOOST_CHECK(db.ReadAddressBalance(otherHash, 1, balance));
+    BOOST_CHECK_EQUAL(balance.balance, 0);
+    BOOST_CHECK_EQUAL(balance.received, 3 * COIN);
+
+    // replaying a block (or part of it) must not count it twice
+    BOOST_CHECK(db.WriteAddressIndex(vect2, true));
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vectPart(vect1.begin(), vect1.begin() + 4);
+    BOOST_CHECK(db.WriteAddressIndex(vectPart, true));
+    BOOST_CHECK(db.ReadAddressBalance(addressHash, 1, balance));
+    BOOST_CHECK_EQUAL(balance.balance, nBalance2);
+    BOOST_CHECK_EQUAL(balance.received, nReceived2);
+
+    // disconnecting reverts the aggregate, also when done twice
+    BOOST_CHECK(db.EraseAddressIndex(vect2, true));
+    BOOST_CHECK(db.EraseAddressIndex(vect2, true));
+    BOOST_CHECK(db.ReadAddressBalance(addressHash, 1, balance));
+    BOOST_CHECK_EQUAL(balance.balance, nBalance1);
+    BOOST_CHECK_EQUAL(balance.received, nReceived1);
+    BOOST_CHECK(!db.ReadAddressBalance(otherHash, 1, balance));
+    BOOST_CHECK(balance.IsNull());
+
+    BOOST_CHECK(db.EraseAddressIndex(vect1, true));
+    BOOST_CHECK(!db.ReadAddressBalance(addressHash, 1, balance));
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_paging)
+{
+    CBlockTreeDB db(1 << 20, true, true);
+    uint160 addressHash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314"));
+    uint160 otherHash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121315"));
+
+    for (int nHeight = 1; nHeight <= 5; nHeight++) {
+        BOOST_CHECK(db.WriteAddressIndex(BuildBlockEntries(addressHash, nHeight, 7)));
+        BOOST_CHECK(db.WriteAddressIndex(BuildBlockEntries(otherHash, nHeight, 2)));
+    }
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vAll;
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, vAll));
+    BOOST_CHECK_EQUAL(vAll.size(), 35);
+
+    // pages follow each other in key order without gaps or repeats
+    for (size_t nLimit : {1, 4, 7, 34, 35, 100}) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vPaged;
+        CAddressIndexKey resumeKey;
+        bool fResume = false;
+        while (true) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > vPage;
+            BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, vPage, 0, 0, nLimit, fResume ? &resumeKey : nullptr));
+            BOOST_CHECK(vPage.size() <= nLimit);
+            if (vPage.empty())
+                break;
+            vPaged.insert(vPaged.end(), vPage.begin(), vPage.end());
+            resumeKey = vPage.back().first;
+            fResume = true;
+        }
+        BOOST_CHECK_EQUAL(vPaged.size(), vAll.size());
+        for (size_t i = 0; i < std::min(vPaged.size(), vAll.size()); i++) {
+            BOOST_CHECK(vPaged[i].first.txhash == vAll[i].first.txhash);
+            BOOST_CHECK_EQUAL(vPaged[i].first.index, vAll[i].first.index);
+        }
+    }
+
+    // height range and limit combined
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vRange;
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, vRange, 2, 3, 10));
+    BOOST_CHECK_EQUAL(vRange.size(), 10);
+    BOOST_CHECK_EQUAL(vRange.front().first.blockHeight, 2);
+    BOOST_CHECK_EQUAL(vRange.back().first.blockHeight, 3);
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vRangeRest;
+    BOOST_CHECK(db.ReadAddressIndex(addressHash, 1, vRangeRest, 2, 3, 10, &vRange.back().first));
+    BOOST_CHECK_EQUAL(vRangeRest.size(), 4);
+
+    // unspent outputs page the same way
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+    for (int i = 0; i < 9; i++) {
+        vUnspent.emplace_back(CAddressUnspentKey(1, addressHash, GetRandHash(), i), CAddressUnspentValue(i * COIN, CScript(), 1));
+    }
+    vUnspent.emplace_back(CAddressUnspentKey(1, otherHash, GetRandHash(), 0), CAddressUnspentValue(COIN, CScript(), 1));
+    BOOST_CHECK(db.UpdateAddressUnspentIndex(vUnspent));
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vAllUnspent, vPagedUnspent;
+    BOOST_CHECK(db.ReadAddressUnspentIndex(addressHash, 1, vAllUnspent));
+    BOOST_CHECK_EQUAL(vAllUnspent.size(), 9);
+    CAddressUnspentKey resumeKey;
+    bool fResume = false;
+    while (true) {
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vPage;
+        BOOST_CHECK(db.ReadAddressUnspentIndex(addressHash, 1, vPage, 4, fResume ? &resumeKey : nullptr));
+        if (vPage.empty())
+            break;
+        vPagedUnspent.insert(vPagedUnspent.end(), vPage.begin(), vPage.end());
+        resumeKey = vPage.back().first;
+        fResume = true;
+    }
+    BOOST_CHECK_EQUAL(vPagedUnspent.size(), vAllUnspent.size());
+    for (size_t i = 0; i < std::min(vPagedUnspent.size(), vAllUnspent.size()); i++) {
+        BOOST_CHECK(vPagedUnspent[i].first.txhash == vAllUnspent[i].first.txhash);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,13 @@
 
 #include "util.h"
 
+#include "memusage.h"
+#include "support/allocators/pool.h"
 #include "support/allocators/secure.h"
 #include "test/test_biblepay.h"
 
+#include <unordered_map>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(allocator_tests, BasicTestingSetup)
@@ -231,4 +235,88 @@ BOOST_AUTO_TEST_CASE(lockedpool_tests_live)
     BOOST_CHECK(pool.stats().used == initial.used);
 }
 
+BOOST_AUTO_TEST_CASE(pool_resource_tests)
+{
+    PoolResource<64, 8> resource(1024);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 0U);
+
+    // Blocks of a size are handed out back to back from one chunk and reused once freed
+    void* a = resource.Allocate(24, 8);
+    void* b = resource.Allocate(24, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+    BOOST_CHECK_EQUAL((char*)b - (char*)a, 24);
+    resource.Deallocate(a, 24, 8);
+    BOOST_CHECK(resource.Allocate(20, 8) == a);
+
+    // Large blocks bypass the pool
+    void* c = resource.Allocate(128, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+    resource.Deallocate(c, 128, 8);
+
+    // A new chunk is only taken when the current one is used up
+    for (int i = 0; i < 1024 / 64; i++) {
+        resource.Allocate(64, 8);
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+
+    // Containers share the resource through the allocator and its memory usage counts whole chunks
+    typedef PoolAllocator<std::pair<const int, int>, 64, 8> Allocator;
+    Allocator::ResourceType mapResource;
+    {
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Allocator> map(0, std::hash<int>(), std::equal_to<int>(), &mapResource);
+        for (int i = 0; i < 1000; i++) {
+            map[i] = i;
+        }
+        BOOST_CHECK_EQUAL(mapResource.NumAllocatedChunks(), 1U);
+        BOOST_CHECK(memusage::DynamicUsage(map) >= mapResource.ChunkSizeBytes());
+    }
+    BOOST_CHECK_EQUAL(mapResource.NumAllocatedChunks(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(pool_resource_retire_chunks)
+{
+    PoolResource<64, 8> resource(1024);
+    std::vector<void*> vBlocks;
+    for (int i = 0; i < 3 * 1024 / 64; i++) {
+        vBlocks.push_back(resource.Allocate(64, 8));
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 3U);
+
+    // Leave a few blocks in use in each chunk
+    std::vector<void*> vInUse;
+    for (size_t i = 0; i < vBlocks.size(); i++) {
+        if (i % 8 == 0) {
+            vInUse.push_back(vBlocks[i]);
+        } else {
+            resource.Deallocate(vBlocks[i], 64, 8);
+        }
+    }
+
+    resource.IndexChunks();
+    std::vector<bool> vRetire(3, true);
+    int nKeep = resource.ChunkIndex(vInUse.front());
+    BOOST_CHECK(nKeep >= 0);
+    vRetire[nKeep] = false;
+    resource.RetireChunks(vRetire);
+
+    // Blocks moved out of the retired chunks are served by the kept one, and freeing the old ones does not reuse them
+    for (void*& p : vInUse) {
+        if (resource.IsRetired(p)) {
+            resource.Deallocate(p, 64, 8);
+            p = resource.Allocate(64, 8);
+            BOOST_CHECK_EQUAL(resource.ChunkIndex(p), nKeep);
+        }
+    }
+    resource.ReleaseRetiredChunks();
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // The rest of the kept chunk is still available
+    for (size_t i = vInUse.size(); i < 1024 / 64; i++) {
+        vInUse.push_back(resource.Allocate(64, 8));
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+    resource.Allocate(64, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -314,6 +314,30 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(RetainedTxnRoundTripTest)
+{
+    CTxMemPool pool;
+    CBlock block(BuildBlockTestCase());
+
+    // vtx[1] is only known from the extra pool, vtx[2] only from the retained pool
+    std::vector<std::pair<uint256, CTransactionRef>> extra = {{block.vtx[1]->GetHash(), block.vtx[1]}};
+    std::vector<std::pair<uint256, CTransactionRef>> retained = {{uint256(), nullptr}, {block.vtx[2]->GetHash(), block.vtx[2]}};
+
+    CCriticalSection cs_retained;
+
+    CBlockHeaderAndShortTxIDs shortIDs(block);
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_CHECK(partialBlock.InitData(shortIDs, extra, retained, &cs_retained) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(1));
+    BOOST_CHECK(partialBlock.IsTxAvailable(2));
+    BOOST_CHECK_EQUAL(partialBlock.GetLocalCount(), 2U);
+    BOOST_CHECK_EQUAL(partialBlock.GetRetainedCount(), 1U);
+
+    CBlock block2;
+    BOOST_CHECK(partialBlock.FillBlock(block2, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = GetRandHash();
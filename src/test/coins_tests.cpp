@@ -121,6 +121,7 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     bool found_an_entry = false;
     bool missed_an_entry = false;
     bool uncached_an_entry = false;
+    bool trimmed_a_cache = false;
 
     // A simple map to track what we expect the cache stack to represent.
     std::map<COutPoint, Coin> result;
@@ -211,7 +212,13 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
             // Every 100 iterations, flush an intermediate cache
             if (stack.size() > 1 && insecure_rand() % 2 == 0) {
                 unsigned int flushIndex = insecure_rand() % (stack.size() - 1);
-                stack[flushIndex]->Flush();
+                if (insecure_rand() % 2 == 0) {
+                    stack[flushIndex]->Flush();
+                } else {
+                    // Keep a random part of the entries, which must not change what the stack represents
+                    stack[flushIndex]->FlushAndTrim(stack[flushIndex]->DynamicMemoryUsage() * (insecure_rand() % 4) / 4);
+                    trimmed_a_cache = true;
+                }
             }
         }
         if (insecure_rand() % 100 == 0) {
@@ -254,6 +261,70 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     BOOST_CHECK(found_an_entry);
     BOOST_CHECK(missed_an_entry);
     BOOST_CHECK(uncached_an_entry);
+    BOOST_CHECK(trimmed_a_cache);
+}
+
+BOOST_AUTO_TEST_CASE(coins_cache_flush_and_trim)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    // Enough coins to fill several chunks of the cache's memory pool
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 20000; i++) {
+        outpoints.push_back(COutPoint(GetRandHash(), 0));
+        Coin coin;
+        coin.out.nValue = 1 + i;
+        coin.out.scriptPubKey.assign(20U, 0);
+        coin.nHeight = 1;
+        cache.AddCoin(outpoints.back(), std::move(coin), false);
+    }
+    cache.SpendCoin(outpoints[0]);
+
+    // Using the last thousand coins after the next block makes them the most recently used ones
+    cache.SetBestBlock(GetRandHash());
+    for (int i = 19000; i < 20000; i++) {
+        BOOST_CHECK(!cache.AccessCoin(outpoints[i]).IsSpent());
+    }
+
+    size_t nTargetUsage = cache.DynamicMemoryUsage() / 2;
+    BOOST_CHECK(cache.FlushAndTrim(nTargetUsage));
+    cache.SelfTest();
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= nTargetUsage);
+    BOOST_CHECK(cache.GetEvicted() > 0);
+    for (int i = 19000; i < 20000; i++) {
+        BOOST_CHECK(cache.HaveCoinInCache(outpoints[i]));
+        BOOST_CHECK_EQUAL(cache.map().at(outpoints[i]).flags, 0);
+    }
+
+    // All changes reached the base view before the older coins were dropped
+    Coin coin;
+    BOOST_CHECK(!base.GetCoin(outpoints[0], coin) || coin.IsSpent());
+    for (int i = 1; i < 20000; i++) {
+        BOOST_CHECK(base.GetCoin(outpoints[i], coin));
+        BOOST_CHECK_EQUAL(coin.out.nValue, 1 + i);
+    }
+    BOOST_CHECK(!cache.HaveCoin(outpoints[0]));
+    BOOST_CHECK(cache.HaveCoin(outpoints[1]));
+
+    // The bucket array of a map with a few coins lies in one of the pool's chunks, which must
+    // survive the compaction even when no coin is left in it
+    BOOST_CHECK(cache.FlushAndTrim(0));
+    for (int i = 0; i < 3; i++) {
+        Coin newcoin;
+        newcoin.out.nValue = 1;
+        newcoin.out.scriptPubKey.assign(20U, 0);
+        newcoin.nHeight = 2;
+        cache.AddCoin(COutPoint(GetRandHash(), 1), std::move(newcoin), false);
+    }
+    BOOST_CHECK(cache.FlushAndTrim(0));
+    cache.SelfTest();
+    BOOST_CHECK(cache.HaveCoin(outpoints[1]));
+
+    // A plain flush gives all memory of the pool back
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), memusage::DynamicUsage(cache.map()));
+    BOOST_CHECK(cache.DynamicMemoryUsage() < nTargetUsage / 4);
 }
 
 // Store of all necessary tx and undo data for next test
@@ -587,7 +658,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map(0, SaltedOutpointHasher(), std::equal_to<COutPoint>(), &resource);
     InsertCoinsMapEntry(map, value, flags);
     view.BatchWrite(map, {});
 }
@@ -391,4 +391,32 @@ BOOST_AUTO_TEST_CASE(cuckoocache_generations)
     test_cache_generations<CuckooCache::cache<uint256, uint256Hasher>>();
 }
 
+/* Test that for_each_live visits exactly the elements which were not erased,
+ * and that inserting them into a new cache restores its contents.
+ */
+BOOST_AUTO_TEST_CASE(cuckoocache_for_each_live)
+{
+    insecure_rand = FastRandomContext(true);
+    CuckooCache::cache<uint256, uint256Hasher> cc{};
+    cc.setup_bytes(1 << 20);
+    std::vector<uint256> hashes(1000);
+    for (uint256& h : hashes) {
+        insecure_GetRandHash(h);
+        cc.insert(h);
+    }
+    for (size_t i = 0; i < hashes.size() / 2; ++i)
+        cc.contains(hashes[i], true);
+
+    std::vector<uint256> live;
+    cc.for_each_live([&live](const uint256& h) { live.push_back(h); });
+    BOOST_CHECK_EQUAL(live.size(), hashes.size() / 2);
+
+    CuckooCache::cache<uint256, uint256Hasher> restored{};
+    restored.setup_bytes(1 << 20);
+    for (const uint256& h : live)
+        restored.insert(h);
+    for (size_t i = 0; i < hashes.size(); ++i)
+        BOOST_CHECK_EQUAL(restored.contains(hashes[i], false), i >= hashes.size() / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -318,6 +318,43 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_options_and_stats)
+{
+    boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CDBWrapperOptions dbOptions = CDBWrapperOptions::FromCacheSize(1 << 20);
+    dbOptions.nBloomBits = 0;
+    dbOptions.nBlockSize = 1 << 16;
+    CDBWrapper dbw(ph, dbOptions, true, false, false);
+
+    uint256 in = GetRandHash();
+    uint256 res;
+    BOOST_CHECK(dbw.Write('k', in));
+    BOOST_CHECK(dbw.Read('k', res));
+    BOOST_CHECK(!dbw.Read('l', res));
+    {
+        std::unique_ptr<CDBIterator> it(dbw.NewIterator());
+        it->Seek('k');
+        BOOST_CHECK(it->Valid() && it->GetValue(res));
+    }
 
+    CDBWrapperStats stats = dbw.GetStats();
+    BOOST_CHECK_EQUAL(stats.strName, "memory");
+    BOOST_CHECK_EQUAL(stats.options.nBloomBits, 0);
+    BOOST_CHECK_EQUAL(stats.options.nBlockSize, 65536U);
+    // the obfuscation key lookup on open counts as a read too
+    BOOST_CHECK_EQUAL(stats.nReads, 3U);
+    BOOST_CHECK_EQUAL(stats.nReadsFound, 1U);
+    BOOST_CHECK_EQUAL(stats.nBytesRead, in.size());
+    // IsEmpty() isn't called for non-obfuscated databases
+    BOOST_CHECK_EQUAL(stats.nIterators, 1U);
+    BOOST_CHECK_EQUAL(stats.nIteratorBytesRead, in.size());
+    BOOST_CHECK_EQUAL(stats.nBatches, 1U);
+
+    bool fFound = false;
+    for (const auto& s : GetDBWrapperStats()) {
+        fFound |= s.strPath == ph.string();
+    }
+    BOOST_CHECK(fFound);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "flat-database.h"
+
+#include "test/test_biblepay.h"
+#include "test/test_random.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+struct CTestStore
+{
+    std::vector<int> vecItems;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(vecItems);
+    }
+
+    void Clear() { vecItems.clear(); }
+    void CheckAndRemove() {}
+    std::string ToString() const { return strprintf("Items: %d", vecItems.size()); }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flatdb_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(flatdb_file_backend)
+{
+    boost::filesystem::path pathDB = GetDataDir() / "teststore.dat";
+
+    CTestStore store;
+    for (int i = 0; i < 100000; i++) {
+        store.vecItems.push_back(insecure_rand());
+    }
+    CFlatDB<CTestStore> flatdb("teststore.dat", "magicTestStore", FLATDB_BACKEND_FILE);
+    BOOST_CHECK(flatdb.Dump(store));
+    CTestStore loaded;
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_CHECK(loaded.vecItems == store.vecItems);
+
+    // the object is streamed from disk, a corrupted file must still be caught by the checksum
+    {
+        FILE* file = fopen(pathDB.string().c_str(), "r+b");
+        BOOST_CHECK(file != nullptr);
+        fseek(file, boost::filesystem::file_size(pathDB) / 2, SEEK_SET);
+        int c = fgetc(file);
+        fseek(file, boost::filesystem::file_size(pathDB) / 2, SEEK_SET);
+        fputc(c ^ 0xff, file);
+        fclose(file);
+    }
+    loaded.Clear();
+    BOOST_CHECK(!flatdb.Load(loaded));
+    BOOST_CHECK(loaded.vecItems.empty());
+    boost::filesystem::remove(pathDB);
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_log_backend)
+{
+    boost::filesystem::path pathDB = GetDataDir() / "teststore.dat";
+    boost::filesystem::path pathLog = GetDataDir() / "teststore.log";
+
+    // start with the old single-file format, the log backend must pick it up
+    CTestStore store;
+    for (int i = 0; i < 100000; i++) {
+        store.vecItems.push_back(insecure_rand());
+    }
+    BOOST_CHECK(CFlatDB<CTestStore>("teststore.dat", "magicTestStore", FLATDB_BACKEND_FILE).Dump(store));
+    BOOST_CHECK(boost::filesystem::exists(pathDB));
+    uint64_t nObjSize = boost::filesystem::file_size(pathDB);
+
+    CFlatDB<CTestStore> flatdb("teststore.dat", "magicTestStore", FLATDB_BACKEND_LOG);
+    CTestStore loaded;
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_CHECK(loaded.vecItems == store.vecItems);
+
+    BOOST_CHECK(flatdb.Dump(store));
+    BOOST_CHECK(!boost::filesystem::exists(pathDB));
+    uint64_t nSize1 = boost::filesystem::file_size(pathLog);
+
+    // dumping the same state again only appends a snapshot record
+    BOOST_CHECK(flatdb.Dump(store));
+    uint64_t nSize2 = boost::filesystem::file_size(pathLog);
+    BOOST_CHECK(nSize2 - nSize1 < nObjSize / 100);
+
+    // a small change only appends the chunks around it
+    std::vector<int> vecPrevItems = store.vecItems;
+    store.vecItems[50000]++;
+    BOOST_CHECK(flatdb.Dump(store));
+    uint64_t nSize3 = boost::filesystem::file_size(pathLog);
+    BOOST_CHECK(nSize3 > nSize2);
+    BOOST_CHECK(nSize3 - nSize2 < nObjSize / 4);
+
+    loaded.Clear();
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_CHECK(loaded.vecItems == store.vecItems);
+
+    // a torn append falls back to the previous snapshot...
+    boost::filesystem::resize_file(pathLog, nSize3 - 1);
+    loaded.Clear();
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_CHECK(loaded.vecItems == vecPrevItems);
+
+    // ...and gets compacted away on the next dump
+    BOOST_CHECK(flatdb.Dump(store));
+    BOOST_CHECK(boost::filesystem::file_size(pathLog) < nSize1 + nObjSize / 100);
+    loaded.Clear();
+    BOOST_CHECK(flatdb.Load(loaded));
+    BOOST_CHECK(loaded.vecItems == store.vecItems);
+
+    // the log is compacted once it outgrows the live data
+    for (int i = 0; i < 2 * FLATDB_LOG_COMPACT_RATIO; i++) {
+        store.vecItems[insecure_rand() % store.vecItems.size()]++;
+        BOOST_CHECK(flatdb.Dump(store));
+        BOOST_CHECK(boost::filesystem::file_size(pathLog) < FLATDB_LOG_COMPACT_RATIO * (nObjSize + nObjSize / 10));
+    }
+
+    // a corrupted chunk is detected while loading
+    boost::filesystem::resize_file(pathLog, boost::filesystem::file_size(pathLog) - 1);
+    BOOST_CHECK(flatdb.Dump(store));
+    {
+        FILE* file = fopen(pathLog.string().c_str(), "r+b");
+        BOOST_CHECK(file != nullptr);
+        fseek(file, boost::filesystem::file_size(pathLog) / 2, SEEK_SET);
+        int c = fgetc(file);
+        fseek(file, boost::filesystem::file_size(pathLog) / 2, SEEK_SET);
+        fputc(c ^ 0xff, file);
+        fclose(file);
+    }
+    loaded.Clear();
+    flatdb.Load(loaded);
+    BOOST_CHECK(loaded.vecItems.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "governance-votedb.h"
+#include "random.h"
+
+#include "test/test_biblepay.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_votedb_tests, BasicTestingSetup)
+
+static CGovernanceVote MakeVote(const COutPoint& outpoint, const uint256& nParentHash, int64_t nTime)
+{
+    CGovernanceVote vote(outpoint, nParentHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    vote.SetTime(nTime);
+    return vote;
+}
+
+BOOST_AUTO_TEST_CASE(votefile_add_and_replace)
+{
+    uint256 nParentHash = GetRandHash();
+    CGovernanceObjectVoteFile voteFile;
+
+    std::vector<CGovernanceVote> votes;
+    for (int i = 0; i < 10; i++) {
+        votes.emplace_back(MakeVote(COutPoint(GetRandHash(), i), nParentHash, 1000));
+        voteFile.AddVote(votes.back());
+    }
+    // adding the same vote again is a no-op
+    voteFile.AddVote(votes[0]);
+    BOOST_CHECK_EQUAL(voteFile.GetVoteCount(), 10);
+
+    for (const auto& vote : votes) {
+        BOOST_CHECK(voteFile.HasVote(vote.GetHash()));
+    }
+
+    // votes are kept sorted by hash
+    const auto& vecVotes = voteFile.GetVotes();
+    for (size_t i = 1; i < vecVotes.size(); i++) {
+        BOOST_CHECK(vecVotes[i - 1].GetHash() < vecVotes[i].GetHash());
+    }
+
+    // a newer vote of the same masternode for the same signal replaces the old one
+    CGovernanceVote newVote = MakeVote(votes[3].GetMasternodeOutpoint(), nParentHash, 2000);
+    voteFile.AddVote(newVote);
+    BOOST_CHECK_EQUAL(voteFile.GetVoteCount(), 10);
+    BOOST_CHECK(voteFile.HasVote(newVote.GetHash()));
+    BOOST_CHECK(!voteFile.HasVote(votes[3].GetHash()));
+
+    voteFile.RemoveVotesFromMasternode(votes[5].GetMasternodeOutpoint());
+    BOOST_CHECK_EQUAL(voteFile.GetVoteCount(), 9);
+    BOOST_CHECK(!voteFile.HasVote(votes[5].GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(votefile_serialization)
+{
+    uint256 nParentHash = GetRandHash();
+    CGovernanceObjectVoteFile voteFile;
+    for (int i = 0; i < 10; i++) {
+        voteFile.AddVote(MakeVote(COutPoint(GetRandHash(), i), nParentHash, 1000 + i));
+    }
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << voteFile;
+
+    // votes used to be stored in a std::list, which must still be readable
+    std::list<CGovernanceVote> listVotes(voteFile.GetVotes().rbegin(), voteFile.GetVotes().rend());
+    CDataStream ssOld(SER_DISK, CLIENT_VERSION);
+    ssOld << voteFile.GetVoteCount() << listVotes;
+
+    CGovernanceObjectVoteFile voteFile2, voteFile3;
+    ss >> voteFile2;
+    ssOld >> voteFile3;
+
+    BOOST_CHECK_EQUAL(voteFile2.GetVoteCount(), 10);
+    BOOST_CHECK_EQUAL(voteFile3.GetVoteCount(), 10);
+    for (size_t i = 0; i < voteFile.GetVotes().size(); i++) {
+        BOOST_CHECK(voteFile.GetVotes()[i].GetHash() == voteFile2.GetVotes()[i].GetHash());
+        BOOST_CHECK(voteFile.GetVotes()[i].GetHash() == voteFile3.GetVotes()[i].GetHash());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
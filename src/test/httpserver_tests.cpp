@@ -0,0 +1,195 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "httpserver.h"
+#include "compat.h"
+#include "netbase.h"
+#include "rpc/protocol.h"
+#include "util.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+
+#include "test/test_biblepay.h"
+#include "test/test_random.h"
+
+#include <atomic>
+
+#include <event2/util.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+static const size_t CHUNK_SIZE = 100 * 1000;
+// well above HTTP_MAX_PENDING_REPLY_BYTES, so that a slow client makes the handler wait
+static const int CHUNK_COUNT = 200;
+
+struct HTTPServerSetup : public BasicTestingSetup
+{
+    int nPort;
+    std::atomic<int> nChunksWritten{0};
+    std::atomic<bool> fAborted{false};
+    std::atomic<bool> fDone{false};
+    std::atomic<bool> fHoldReply{false};
+    std::atomic<bool> fInHandler{false};
+
+    HTTPServerSetup()
+    {
+        nPort = 20000 + insecure_rand() % 20000;
+        ForceSetArg("-rpcport", std::to_string(nPort));
+        BOOST_REQUIRE(InitHTTPServer());
+        RegisterHTTPHandler("/chunked", true, [this](HTTPRequest* req, const std::string&) {
+            fInHandler = true;
+            while (fHoldReply) {
+                MilliSleep(10);
+            }
+            req->WriteHeader("Content-Type", "text/plain");
+            req->StartChunkedReply(HTTP_OK);
+            for (int i = 0; i < CHUNK_COUNT; i++) {
+                if (!req->WriteReplyChunk(std::string(CHUNK_SIZE, 'a' + i % 26))) {
+                    fAborted = true;
+                    break;
+                }
+                nChunksWritten++;
+            }
+            req->EndChunkedReply();
+            fDone = true;
+            return true;
+        });
+        BOOST_REQUIRE(StartHTTPServer());
+    }
+
+    ~HTTPServerSetup()
+    {
+        InterruptHTTPServer();
+        StopHTTPServer();
+        UnregisterHTTPHandler("/chunked", true);
+        ForceSetArg("-rpcport", "");
+    }
+
+    SOCKET Connect()
+    {
+        SOCKET hSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        BOOST_REQUIRE(hSocket != INVALID_SOCKET);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(nPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        BOOST_REQUIRE(connect(hSocket, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        std::string strRequest = "GET /chunked HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+        BOOST_REQUIRE(send(hSocket, strRequest.data(), strRequest.size(), MSG_NOSIGNAL) == (int)strRequest.size());
+        return hSocket;
+    }
+
+    bool WaitForHandler()
+    {
+        for (int i = 0; i < 1000 && !fDone; i++) {
+            MilliSleep(10);
+        }
+        return fDone;
+    }
+};
+
+std::string ReadAll(SOCKET hSocket)
+{
+    std::string strResponse;
+    char buf[4096];
+    while (true) {
+        int nBytes = recv(hSocket, buf, sizeof(buf), 0);
+        if (nBytes <= 0)
+            break;
+        strResponse.append(buf, nBytes);
+    }
+    return strResponse;
+}
+
+// Returns the body of a chunked HTTP response, or an empty string if it is not properly framed
+std::string DecodeChunkedBody(const std::string& strResponse)
+{
+    size_t nPos = strResponse.find("\r\n\r\n");
+    if (nPos == std::string::npos || strResponse.find("Transfer-Encoding: chunked") > nPos)
+        return "";
+    nPos += 4;
+    std::string strBody;
+    while (true) {
+        size_t nLineEnd = strResponse.find("\r\n", nPos);
+        if (nLineEnd == std::string::npos)
+            return "";
+        size_t nSize = strtoul(strResponse.substr(nPos, nLineEnd - nPos).c_str(), nullptr, 16);
+        nPos = nLineEnd + 2;
+        if (nSize == 0)
+            return strBody;
+        if (nPos + nSize + 2 > strResponse.size() || strResponse.compare(nPos + nSize, 2, "\r\n") != 0)
+            return "";
+        strBody.append(strResponse, nPos, nSize);
+        nPos += nSize + 2;
+    }
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(httpserver_tests, HTTPServerSetup)
+
+BOOST_AUTO_TEST_CASE(httpserver_chunked_reply)
+{
+    SOCKET hSocket = Connect();
+
+    // don't read for a while, the handler has to wait for the client instead of queueing everything
+    // (the socket buffers take a few MB as well, but far less than the whole reply)
+    MilliSleep(500);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    BOOST_CHECK(!fDone);
+#endif
+
+    std::string strResponse = ReadAll(hSocket);
+    CloseSocket(hSocket);
+    BOOST_CHECK(WaitForHandler());
+    BOOST_CHECK(!fAborted);
+    BOOST_CHECK_EQUAL(nChunksWritten, CHUNK_COUNT);
+
+    BOOST_CHECK(strResponse.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    std::string strBody = DecodeChunkedBody(strResponse);
+    BOOST_CHECK_EQUAL(strBody.size(), CHUNK_SIZE * CHUNK_COUNT);
+    bool fContentOk = strBody.size() == CHUNK_SIZE * CHUNK_COUNT;
+    for (int i = 0; i < CHUNK_COUNT && fContentOk; i++) {
+        fContentOk = strBody.compare(i * CHUNK_SIZE, CHUNK_SIZE, std::string(CHUNK_SIZE, 'a' + i % 26)) == 0;
+    }
+    BOOST_CHECK(fContentOk);
+}
+
+BOOST_AUTO_TEST_CASE(httpserver_chunked_reply_disconnect)
+{
+    SOCKET hSocket = Connect();
+
+    // a client going away in the middle of the reply makes the handler stop generating it
+    char buf[4096];
+    BOOST_CHECK(recv(hSocket, buf, sizeof(buf), 0) > 0);
+    CloseSocket(hSocket);
+    BOOST_CHECK(WaitForHandler());
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    BOOST_CHECK(fAborted);
+    BOOST_CHECK(nChunksWritten < CHUNK_COUNT);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(httpserver_chunked_reply_disconnect_before_start)
+{
+    // the handler is still preparing its reply when the client goes away, evhttp doesn't read from the
+    // connection while the request is outstanding so it only finds out once the reply is being sent
+    fHoldReply = true;
+    SOCKET hSocket = Connect();
+    for (int i = 0; i < 1000 && !fInHandler; i++) {
+        MilliSleep(10);
+    }
+    BOOST_CHECK(fInHandler);
+    CloseSocket(hSocket);
+    MilliSleep(200);
+    fHoldReply = false;
+    BOOST_CHECK(WaitForHandler());
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    BOOST_CHECK(fAborted);
+    BOOST_CHECK(nChunksWritten < CHUNK_COUNT);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+// Copyright (c) 2019 The BiblePay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "validation.h"
+#include "streams.h"
+#include "txmempool.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include "test/test_biblepay.h"
+#include "test/test_random.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(mempool_persist_tests, TestingSetup)
+
+static CMutableTransaction MakeTx(uint32_t n)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(GetRandHash(), n);
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1000 + n;
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    return tx;
+}
+
+// Writes three chunks of transactions and one of fee deltas, as DumpMempool does
+static void WriteTestChunks(const boost::filesystem::path& path, std::vector<CTransactionRef>& vTxs, std::map<uint256, CAmount>& mapDeltas, std::vector<uint64_t>& vChunkPos)
+{
+    CAutoFile file(fopen(path.string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    uint64_t nPos = 0;
+    for (int nChunk = 0; nChunk < 3; nChunk++) {
+        CDataStream ssChunk(SER_DISK, CLIENT_VERSION);
+        for (uint32_t i = 0; i < 10; i++) {
+            vTxs.push_back(MakeTransactionRef(MakeTx(nChunk * 10 + i)));
+            ssChunk << *vTxs.back() << (int64_t)GetTime() << (int64_t)0;
+        }
+        vChunkPos.push_back(nPos);
+        nPos += 4 + 4 + 4 + ssChunk.size() + 32;
+        WriteMempoolChunk(file, 10, ssChunk);
+    }
+    mapDeltas[GetRandHash()] = 1234;
+    CDataStream ssDeltas(SER_DISK, CLIENT_VERSION);
+    ssDeltas << mapDeltas;
+    vChunkPos.push_back(nPos);
+    WriteMempoolChunk(file, 0, ssDeltas);
+}
+
+static int64_t ReadTestChunks(const boost::filesystem::path& path, std::vector<CTransactionRef>& vTxs, std::map<uint256, CAmount>& mapDeltas)
+{
+    int64_t nCorrupt = 0;
+    BOOST_CHECK(ReadMempoolChunks(fopen(path.string().c_str(), "rb"), [&](uint32_t nChunkTxs, CDataStream& ssChunk) {
+        if (nChunkTxs == 0) {
+            ssChunk >> mapDeltas;
+            return true;
+        }
+        for (uint32_t i = 0; i < nChunkTxs; i++) {
+            CMutableTransaction tx;
+            int64_t nTime, nFeeDelta;
+            ssChunk >> tx >> nTime >> nFeeDelta;
+            vTxs.push_back(MakeTransactionRef(tx));
+        }
+        return true;
+    }, nCorrupt));
+    return nCorrupt;
+}
+
+static void OverwriteByte(const boost::filesystem::path& path, uint64_t nPos, unsigned char ch)
+{
+    FILE* file = fopen(path.string().c_str(), "r+b");
+    BOOST_REQUIRE(file);
+    fseek(file, nPos, SEEK_SET);
+    fwrite(&ch, 1, 1, file);
+    fclose(file);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_chunks_round_trip)
+{
+    boost::filesystem::path path = GetDataDir() / "mempool_chunks.dat";
+    std::vector<CTransactionRef> vWritten, vRead;
+    std::map<uint256, CAmount> mapWritten, mapRead;
+    std::vector<uint64_t> vChunkPos;
+    WriteTestChunks(path, vWritten, mapWritten, vChunkPos);
+
+    BOOST_CHECK_EQUAL(ReadTestChunks(path, vRead, mapRead), 0);
+    BOOST_REQUIRE_EQUAL(vRead.size(), vWritten.size());
+    for (size_t i = 0; i < vRead.size(); i++) {
+        BOOST_CHECK(vRead[i]->GetHash() == vWritten[i]->GetHash());
+    }
+    BOOST_CHECK(mapRead == mapWritten);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_chunks_skip_corrupt)
+{
+    boost::filesystem::path path = GetDataDir() / "mempool_chunks.dat";
+
+    // A flipped byte in the data of the second chunk only loses that chunk
+    {
+        std::vector<CTransactionRef> vWritten, vRead;
+        std::map<uint256, CAmount> mapWritten, mapRead;
+        std::vector<uint64_t> vChunkPos;
+        WriteTestChunks(path, vWritten, mapWritten, vChunkPos);
+        OverwriteByte(path, vChunkPos[1] + 12 + 20, 0xff);
+        BOOST_CHECK_EQUAL(ReadTestChunks(path, vRead, mapRead), 1);
+        BOOST_REQUIRE_EQUAL(vRead.size(), 20U);
+        for (size_t i = 0; i < 10; i++) {
+            BOOST_CHECK(vRead[i]->GetHash() == vWritten[i]->GetHash());
+            BOOST_CHECK(vRead[10 + i]->GetHash() == vWritten[20 + i]->GetHash());
+        }
+        BOOST_CHECK(mapRead == mapWritten);
+    }
+
+    // So does a corrupt length prefix, whether it now points into the next chunk or past the end of the file
+    for (unsigned char ch : {0x01, 0x7f}) {
+        std::vector<CTransactionRef> vWritten, vRead;
+        std::map<uint256, CAmount> mapWritten, mapRead;
+        std::vector<uint64_t> vChunkPos;
+        WriteTestChunks(path, vWritten, mapWritten, vChunkPos);
+        OverwriteByte(path, vChunkPos[1] + 8 + 1, ch);
+        BOOST_CHECK(ReadTestChunks(path, vRead, mapRead) >= 1);
+        BOOST_REQUIRE_EQUAL(vRead.size(), 20U);
+        BOOST_CHECK(vRead[10]->GetHash() == vWritten[20]->GetHash());
+        BOOST_CHECK(mapRead == mapWritten);
+    }
+
+    // A torn last chunk loses only what is missing
+    {
+        std::vector<CTransactionRef> vWritten, vRead;
+        std::map<uint256, CAmount> mapWritten, mapRead;
+        std::vector<uint64_t> vChunkPos;
+        WriteTestChunks(path, vWritten, mapWritten, vChunkPos);
+        boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 1);
+        BOOST_CHECK_EQUAL(ReadTestChunks(path, vRead, mapRead), 1);
+        BOOST_CHECK_EQUAL(vRead.size(), 30U);
+        BOOST_CHECK(mapRead.empty());
+    }
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_dump_load)
+{
+    // Transactions spending unknown coins are not accepted again, but every one of them
+    // has to come back out of the file, and so do the fee deltas
+    TestMemPoolEntryHelper entry;
+    entry.Time(GetTime());
+    for (uint32_t i = 0; i < 2500; i++) {
+        CMutableTransaction tx = MakeTx(i);
+        mempool.addUnchecked(tx.GetHash(), entry.FromTx(tx));
+    }
+    uint256 hashPrioritised = GetRandHash();
+    mempool.PrioritiseTransaction(hashPrioritised, 5678);
+
+    DumpMempool();
+    mempool.clear();
+    mempool.ClearPrioritisation(hashPrioritised);
+    BOOST_CHECK(LoadMempool());
+
+    CMempoolLoadStats stats = GetMempoolLoadStats();
+    BOOST_CHECK_EQUAL(stats.nTotal, 2500U);
+    BOOST_CHECK_EQUAL(stats.nAccepted + stats.nFailed + stats.nExpired, 2500);
+    {
+        LOCK(mempool.cs);
+        BOOST_CHECK(mempool.mapDeltas.count(hashPrioritised));
+        BOOST_CHECK_EQUAL(mempool.mapDeltas[hashPrioritised], 5678);
+    }
+    mempool.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,7 @@
 #include "miner.h"
 #include "policy/policy.h"
 #include "pubkey.h"
+#include "script/interpreter.h"
 #include "script/standard.h"
 #include "txmempool.h"
 #include "uint256.h"
@@ -433,4 +434,86 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_FIXTURE_TEST_CASE(block_template_cache, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    CScript scriptA = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CScript scriptB = CScript() << OP_TRUE;
+
+    std::unique_ptr<CBlockTemplate> templateA = blockTemplateCache.Get(chainparams, scriptA, "", "");
+    std::unique_ptr<CBlockTemplate> templateB = blockTemplateCache.Get(chainparams, scriptB, "", "guid");
+    BOOST_CHECK(templateA && templateB);
+    BOOST_CHECK(templateA->block.hashPrevBlock == chainActive.Tip()->GetBlockHash());
+
+    // both are copies of the same template, only the coinbase differs
+    BOOST_CHECK(templateA->block.hashPrevBlock == templateB->block.hashPrevBlock);
+    BOOST_CHECK_EQUAL(templateA->block.vtx.size(), templateB->block.vtx.size());
+    BOOST_CHECK(templateA->block.vtx[0]->vout[0].scriptPubKey == scriptA);
+    BOOST_CHECK(templateB->block.vtx[0]->vout[0].scriptPubKey == scriptB);
+    BOOST_CHECK_EQUAL(templateA->block.vtx[0]->vout[0].nValue, templateB->block.vtx[0]->vout[0].nValue);
+    BOOST_CHECK(templateA->block.vtx[0]->vout[0].sTxOutMessage.find("<MINERGUID>") == std::string::npos);
+    BOOST_CHECK(templateB->block.vtx[0]->vout[0].sTxOutMessage.find("<MINERGUID>guid</MINERGUID>") != std::string::npos);
+
+    // a new tip replaces the template
+    CreateAndProcessBlock(std::vector<CMutableTransaction>(), scriptA);
+    std::unique_ptr<CBlockTemplate> templateC = blockTemplateCache.Get(chainparams, scriptA, "", "");
+    BOOST_CHECK(templateC);
+    BOOST_CHECK(templateC->block.hashPrevBlock == chainActive.Tip()->GetBlockHash());
+    BOOST_CHECK(templateC->block.hashPrevBlock != templateA->block.hashPrevBlock);
+}
+
+static CMutableTransaction SpendToKey(const CTransaction& txFrom, const CKey& key, CAmount nValue)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(txFrom.GetHash(), 0);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = nValue;
+    tx.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(txFrom.vout[0].scriptPubKey, tx, 0, SIGHASH_ALL);
+    BOOST_CHECK(key.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    tx.vin[0].scriptSig << vchSig;
+    return tx;
+}
+
+BOOST_FIXTURE_TEST_CASE(block_assembler_extend, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CValidationState state;
+
+    CMutableTransaction tx1 = SpendToKey(coinbaseTxns[0], coinbaseKey, 1 * COIN);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(AcceptToMemoryPool(mempool, state, MakeTransactionRef(tx1), false, NULL, true, 0));
+    }
+    std::unique_ptr<CBlockTemplate> prev = BlockAssembler(chainparams).CreateNewBlock(scriptPubKey, "", "", 0);
+    BOOST_CHECK(prev && prev->fAllPackagesSelected);
+    BOOST_CHECK_EQUAL(prev->block.vtx.size(), 2);
+
+    // a child of a transaction in the template is appended
+    CMutableTransaction tx2 = SpendToKey(tx1, coinbaseKey, 50 * CENT);
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(AcceptToMemoryPool(mempool, state, MakeTransactionRef(tx2), false, NULL, true, 0));
+    }
+    std::unique_ptr<CBlockTemplate> extended = BlockAssembler(chainparams).ExtendBlock(*prev);
+    std::unique_ptr<CBlockTemplate> full = BlockAssembler(chainparams).CreateNewBlock(scriptPubKey, "", "", 0);
+    BOOST_CHECK(extended && full);
+    BOOST_CHECK_EQUAL(extended->block.vtx.size(), 3);
+    BOOST_CHECK(extended->block.vtx[2]->GetHash() == tx2.GetHash());
+    BOOST_CHECK(extended->block.vtx[0]->vout[0].scriptPubKey == scriptPubKey);
+    BOOST_CHECK_EQUAL(extended->vTxFees[0], full->vTxFees[0]);
+    BOOST_CHECK_EQUAL(extended->block.vtx[0]->GetValueOut(), full->block.vtx[0]->GetValueOut());
+    BOOST_CHECK_EQUAL(extended->nBlockSize, full->nBlockSize);
+
+    // after a removal the whole mempool has to be looked at again
+    mempool.removeRecursive(tx2);
+    BOOST_CHECK(!BlockAssembler(chainparams).ExtendBlock(*extended));
+    mempool.clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
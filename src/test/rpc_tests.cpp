@@ -320,6 +320,52 @@ BOOST_AUTO_TEST_CASE(rpc_ban)
     BOOST_CHECK_EQUAL(adr.get_str(), "2001:4d48:ac57:400:cacf:e9ff:fe1d:9c63/128");
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    UniValue tx(UniValue::VOBJ);
+    tx.push_back(Pair("txid", "abcd"));
+    tx.push_back(Pair("size", 225));
+    UniValue txs(UniValue::VARR);
+    txs.push_back(tx);
+    txs.push_back(tx);
+    txs.push_back(tx);
+    UniValue expected(UniValue::VOBJ);
+    expected.push_back(Pair("hash", "00ff"));
+    expected.push_back(Pair("tx", txs));
+    expected.push_back(Pair("empty", UniValue(UniValue::VARR)));
+
+    // tiny chunks, so that every few bytes go to the sink separately
+    std::vector<std::string> chunks;
+    CJSONStreamWriter writer([&](const std::string& s) { chunks.push_back(s); return true; }, 8);
+    BOOST_CHECK(writer.IsEmpty());
+    writer.BeginObject();
+    writer.Pair("hash", "00ff");
+    writer.Key("tx");
+    writer.BeginArray();
+    for (size_t i = 0; i < txs.size(); i++) {
+        writer.Value(tx);
+    }
+    writer.EndArray();
+    writer.Key("empty");
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndObject();
+    writer.Flush();
+    BOOST_CHECK(!writer.IsEmpty());
+    BOOST_CHECK(chunks.size() > 1);
+
+    std::string strJSON;
+    for (const auto& chunk : chunks) {
+        strJSON += chunk;
+    }
+    BOOST_CHECK_EQUAL(strJSON, expected.write());
+
+    // a receiver that went away aborts the writer
+    CJSONStreamWriter aborted([](const std::string& s) { return false; }, 8);
+    aborted.BeginArray();
+    BOOST_CHECK_THROW(aborted.Value(tx), json_stream_aborted);
+}
+
 #if ENABLE_MINER
 BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
 {
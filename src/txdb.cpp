@@ -13,7 +13,9 @@
 #include "ui_interface.h"
 #include "init.h"
 
+#include <set>
 #include <stdint.h>
+#include <tuple>
 
 #include <boost/thread.hpp>
 
@@ -23,6 +25,7 @@ static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSBALANCE = 'A';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
@@ -129,6 +132,28 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
     return Read(DB_LAST_BLOCK, nFile);
 }
 
+bool CCoinsViewDB::BatchWriteDirty(const CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    CDBBatch batch(db);
+    size_t changed = 0;
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            CoinEntry entry(&it->first);
+            if (it->second.coin.IsSpent())
+                batch.Erase(entry);
+            else
+                batch.Write(entry, it->second.coin);
+            changed++;
+        }
+    }
+    if (!hashBlock.IsNull())
+        batch.Write(DB_BEST_BLOCK, hashBlock);
+
+    bool ret = db.WriteBatch(batch);
+	if (fDebugSpam)
+		LogPrint("coindb", "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)mapCoins.size());
+    return ret;
+}
+
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
 {
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper*>(&db)->NewIterator(), GetBestBlock());
@@ -239,16 +264,29 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
 }
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           size_t nLimit, const CAddressUnspentKey* pResumeKey) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (pResumeKey) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, *pResumeKey));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
+    size_t nCount = 0;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
         if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+            if (pResumeKey && key.second.txhash == pResumeKey->txhash && key.second.index == pResumeKey->index) {
+                pcursor->Next();
+                continue;
+            }
+            if (nLimit != 0 && nCount++ == nLimit) {
+                break;
+            }
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
                 unspentOutputs.push_back(std::make_pair(key.second, nValue));
@@ -264,32 +302,111 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
     return true;
 }
 
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
+/**
+ * Balances are only adjusted for entries which are actually added or removed, so that writing the same
+ * block twice (e.g. when blocks are replayed after an unclean shutdown) doesn't count it twice.
+ * The entries already in the index are looked up with one iterator seek per address and height instead of
+ * one read per entry.
+ */
+static void UpdateAddressBalances(CBlockTreeDB& db, CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, bool fConnect)
+{
+    typedef std::tuple<unsigned int, uint160, int> AddressHeight;
+    typedef std::tuple<unsigned int, uint256, size_t, bool> AddressEntry;
+
+    std::map<AddressHeight, std::vector<const std::pair<CAddressIndexKey, CAmount>*> > mapByAddressHeight;
+    for (const auto& p : vect) {
+        mapByAddressHeight[AddressHeight(p.first.type, p.first.hashBytes, p.first.blockHeight)].push_back(&p);
+    }
+
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    std::map<std::pair<unsigned int, uint160>, CAddressBalance> mapDeltas;
+    for (const auto& group : mapByAddressHeight) {
+        unsigned int type = std::get<0>(group.first);
+        const uint160& addressHash = std::get<1>(group.first);
+        int nHeight = std::get<2>(group.first);
+
+        std::set<AddressEntry> setExisting;
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, nHeight)));
+        while (pcursor->Valid()) {
+            std::pair<char,CAddressIndexKey> key;
+            if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX || key.second.type != type ||
+                key.second.hashBytes != addressHash || key.second.blockHeight != nHeight) {
+                break;
+            }
+            setExisting.emplace(key.second.txindex, key.second.txhash, key.second.index, key.second.spending);
+            pcursor->Next();
+        }
+
+        for (const auto* p : group.second) {
+            bool fExists = setExisting.count(AddressEntry(p->first.txindex, p->first.txhash, p->first.index, p->first.spending)) != 0;
+            if (fExists == fConnect) {
+                continue;
+            }
+            auto& delta = mapDeltas[std::make_pair(type, addressHash)];
+            delta.balance += p->second;
+            if (p->second > 0) {
+                delta.received += p->second;
+            }
+        }
+    }
+    for (const auto& p : mapDeltas) {
+        CAddressBalance balance;
+        db.ReadAddressBalance(p.first.second, p.first.first, balance);
+        if (fConnect) {
+            balance.balance += p.second.balance;
+            balance.received += p.second.received;
+        } else {
+            balance.balance -= p.second.balance;
+            balance.received -= p.second.received;
+        }
+        auto key = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(p.first.first, p.first.second));
+        if (balance.IsNull()) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, balance);
+        }
+    }
+}
+
+bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect, bool fUpdateBalances) {
     CDBBatch batch(*this);
+    if (fUpdateBalances)
+        UpdateAddressBalances(*this, batch, vect, true);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
     return WriteBatch(batch);
 }
 
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
+bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect, bool fUpdateBalances) {
     CDBBatch batch(*this);
+    if (fUpdateBalances)
+        UpdateAddressBalances(*this, batch, vect, false);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ReadAddressBalance(uint160 addressHash, int type, CAddressBalance &balance) {
+    balance.SetNull();
+    return Read(std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash)), balance);
+}
+
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
+                                    int start, int end,
+                                    size_t nLimit, const CAddressIndexKey* pResumeKey) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
-    if (start > 0 && end > 0) {
+    if (pResumeKey) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, *pResumeKey));
+    } else if (start > 0 && end > 0) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
     }
 
+    size_t nCount = 0;
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressIndexKey> key;
@@ -297,6 +414,14 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
             if (end > 0 && key.second.blockHeight > end) {
                 break;
             }
+            if (pResumeKey && key.second.blockHeight == pResumeKey->blockHeight && key.second.txindex == pResumeKey->txindex &&
+                key.second.txhash == pResumeKey->txhash && key.second.index == pResumeKey->index && key.second.spending == pResumeKey->spending) {
+                pcursor->Next();
+                continue;
+            }
+            if (nLimit != 0 && nCount++ == nLimit) {
+                break;
+            }
             CAmount nValue;
             if (pcursor->GetValue(nValue)) {
                 addressIndex.push_back(std::make_pair(key.second, nValue));
@@ -337,7 +337,8 @@ void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmount modifyFee,
 }
 
 CTxMemPool::CTxMemPool() :
-    nTransactionsUpdated(0)
+    nTransactionsUpdated(0),
+    nTransactionsRemoved(0)
 {
     _clear(); //lock free clear
 
@@ -372,6 +373,12 @@ void CTxMemPool::AddTransactionsUpdated(unsigned int n)
     nTransactionsUpdated += n;
 }
 
+unsigned int CTxMemPool::GetTransactionsRemoved() const
+{
+    LOCK(cs);
+    return nTransactionsRemoved;
+}
+
 bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry, setEntries &setAncestors, bool validFeeEstimate)
 {
     NotifyEntryAdded(entry.GetSharedTx());
@@ -707,6 +714,7 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     mapLinks.erase(it);
     mapTx.erase(it);
     nTransactionsUpdated++;
+    nTransactionsRemoved++;
     minerPolicyEstimator->removeTx(hash);
     removeAddressIndex(hash);
     removeSpentIndex(hash);
@@ -1012,6 +1020,7 @@ void CTxMemPool::_clear()
     blockSinceLastRollingFeeBump = false;
     rollingMinimumFeeRate = 0;
     ++nTransactionsUpdated;
+    ++nTransactionsRemoved;
 }
 
 void CTxMemPool::clear()
@@ -1401,6 +1410,7 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
                 mapTx.modify(descendantIt, update_ancestor_state(0, nFeeDelta, 0, 0));
             }
             ++nTransactionsUpdated;
+            ++nTransactionsRemoved;
         }
     }
     LogPrintf("PrioritiseTransaction: %s feerate += %s\n", hash.ToString(), FormatMoney(nFeeDelta));
@@ -28,6 +28,14 @@ public:
     }
 
 
+    // changes the number of entries kept, which takes effect on the next insertion
+    void set_max_size(size_t _maxSize)
+    {
+        assert(_maxSize != 0);
+        maxSize = _maxSize;
+        truncateThreshold = _maxSize * 2;
+    }
+
     template<typename Value2>
     void _emplace(const Key& key, Value2&& v)
     {
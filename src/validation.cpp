@@ -85,6 +85,8 @@ std::atomic_bool fImporting(false);
 bool fReindex = false;
 bool fTxIndex = true;
 bool fAddressIndex = false;
+/** Whether the block tree db has aggregated address balances, only true for address indexes built from scratch */
+bool fAddressBalanceIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
 bool fHavePruned = false;
@@ -98,6 +100,7 @@ unsigned int nBytesPerSigOp = DEFAULT_BYTES_PER_SIGOP;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
 size_t nCoinCacheUsage = 5000 * 300;
+unsigned int nCoinCacheKeepPercent = DEFAULT_DB_CACHE_KEEP;
 uint64_t nPruneTarget = 0;
 bool fAlerts = DEFAULT_ALERTS;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
@@ -1077,29 +1080,57 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
 }
 
 bool GetAddressIndex(uint160 addressHash, int type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end,
+                     size_t nLimit, const CAddressIndexKey* pResumeKey)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end, nLimit, pResumeKey))
         return error("unable to get txids for address");
 
     return true;
 }
 
 bool GetAddressUnspent(uint160 addressHash, int type,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       size_t nLimit, const CAddressUnspentKey* pResumeKey)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs, nLimit, pResumeKey))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressBalance(uint160 addressHash, int type, CAddressBalance &balance)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (fAddressBalanceIndex) {
+        // no entry means the address was never used
+        pblocktree->ReadAddressBalance(addressHash, type, balance);
+        return true;
+    }
+
+    // index was built before balances were aggregated, sum up all deltas
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex))
+        return error("unable to get txids for address");
+
+    balance.SetNull();
+    for (const auto& p : addressIndex) {
+        if (p.second > 0) {
+            balance.received += p.second;
+        }
+        balance.balance += p.second;
+    }
+    return true;
+}
+
 /** Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock */
 bool GetTransaction(const uint256 &hash, CTransactionRef &txOut, const Consensus::Params& consensusParams, uint256 &hashBlock, bool fAllowSlow)
 {
@@ -1911,7 +1942,7 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
     }
 
     if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
+        if (!pblocktree->EraseAddressIndex(addressIndex, fAddressBalanceIndex)) {
             AbortNode(state, "Failed to delete address index");
             return DISCONNECT_FAILED;
         }
@@ -1962,6 +1993,197 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Read of one block input from the coins database, run on the prefetch threads.
+ * A failed read leaves the coin spent, so that the validation thread reads it
+ * again itself and handles the error the usual way.
+ */
+class CCoinsPrefetch
+{
+private:
+    const CCoinsView *pbase;
+    COutPoint outpoint;
+    Coin *pcoin;
+
+public:
+    CCoinsPrefetch(): pbase(NULL), pcoin(NULL) {}
+    CCoinsPrefetch(const CCoinsView& baseIn, const COutPoint& outpointIn, Coin& coinIn) :
+        pbase(&baseIn), outpoint(outpointIn), pcoin(&coinIn) { }
+
+    bool operator()() {
+        try {
+            if (!pbase->GetCoin(outpoint, *pcoin))
+                pcoin->Clear();
+        } catch (const std::exception&) {
+            pcoin->Clear();
+        }
+        return true;
+    }
+
+    void swap(CCoinsPrefetch &check) {
+        std::swap(pbase, check.pbase);
+        std::swap(outpoint, check.outpoint);
+        std::swap(pcoin, check.pcoin);
+    }
+};
+
+static CCheckQueue<CCoinsPrefetch> coinsprefetchqueue(128);
+
+void ThreadCoinsPrefetch() {
+    RenameThread("biblepay-prefetch");
+    coinsprefetchqueue.Thread();
+}
+
+/**
+ * Bring the coins spent by a block into pcoinsTip before ConnectBlock walks its
+ * transactions. The ones which are not cached yet are read from the coins database
+ * by all prefetch threads at once, rather than one by one as each input is checked.
+ * Returns the number of coins read from the database.
+ */
+static unsigned int PrefetchCoins(const CBlock& block, const CCoinsViewCache& view)
+{
+    AssertLockHeld(cs_main);
+    if (!nScriptCheckThreads || !pcoinsTip || !pcoinsdbview)
+        return 0;
+
+    std::set<uint256> setBlockTxids;
+    std::vector<COutPoint> vOutpoints;
+    for (const auto& tx : block.vtx) {
+        if (!tx->IsCoinBase()) {
+            for (const CTxIn& txin : tx->vin) {
+                // outputs created earlier in this block and coins which are cached already need no read
+                if (setBlockTxids.count(txin.prevout.hash) || view.HaveCoinInCache(txin.prevout) || pcoinsTip->HaveCoinInCache(txin.prevout))
+                    continue;
+                vOutpoints.push_back(txin.prevout);
+            }
+        }
+        setBlockTxids.insert(tx->GetHash());
+    }
+    if (vOutpoints.empty())
+        return 0;
+
+    std::vector<Coin> vCoins(vOutpoints.size());
+    std::vector<CCoinsPrefetch> vReads;
+    vReads.reserve(vOutpoints.size());
+    for (size_t i = 0; i < vOutpoints.size(); i++)
+        vReads.emplace_back(*pcoinsdbview, vOutpoints[i], vCoins[i]);
+
+    CCheckQueueControl<CCoinsPrefetch> control(&coinsprefetchqueue);
+    control.Add(vReads);
+    control.Wait();
+
+    // pcoinsTip is only modified here, on the validation thread, once all reads are done
+    for (size_t i = 0; i < vOutpoints.size(); i++)
+        pcoinsTip->AddPrefetchedCoin(vOutpoints[i], std::move(vCoins[i]));
+    return vOutpoints.size();
+}
+
+/**
+ * Proof of work check of one incoming header, run on the header check threads
+ * before AcceptBlockHeader takes cs_main.
+ */
+class CHeaderPoWCheck
+{
+private:
+    const CBlockHeader *pheader;
+    const Consensus::Params *pparams;
+    CHeaderPoWPrecheck *presult;
+
+public:
+    CHeaderPoWCheck(): pheader(NULL), pparams(NULL), presult(NULL) {}
+    CHeaderPoWCheck(const CBlockHeader& headerIn, const Consensus::Params& paramsIn, CHeaderPoWPrecheck& resultIn) :
+        pheader(&headerIn), pparams(&paramsIn), presult(&resultIn) { }
+
+    bool operator()() {
+        presult->fValid = CheckProofOfWork(pheader->GetHash(), pheader->nBits, *pparams, pheader->GetBlockTime(),
+                                           presult->nPrevBlockTime, presult->nPrevHeight, pheader->nNonce, NULL, false);
+        return presult->fValid;
+    }
+
+    void swap(CHeaderPoWCheck &check) {
+        std::swap(pheader, check.pheader);
+        std::swap(pparams, check.pparams);
+        std::swap(presult, check.presult);
+    }
+};
+
+// BibleHash is expensive, so the threads take few headers at a time
+static CCheckQueue<CHeaderPoWCheck> headerpowqueue(8);
+
+void ThreadHeaderPoWCheck() {
+    RenameThread("biblepay-hdrpow");
+    headerpowqueue.Thread();
+}
+
+bool CheckHeadersPoW(const std::vector<CBlockHeader>& headers, int64_t nPrevBlockTime, int nPrevHeight, const Consensus::Params& params, std::vector<CHeaderPoWPrecheck>& vPrecheck)
+{
+    assert(vPrecheck.size() == headers.size());
+
+    std::vector<CHeaderPoWCheck> vChecks;
+    vChecks.reserve(headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        vPrecheck[i].nPrevBlockTime = i == 0 ? nPrevBlockTime : headers[i - 1].GetBlockTime();
+        vPrecheck[i].nPrevHeight = nPrevHeight + i;
+        vPrecheck[i].fValid = false;
+        if (!vPrecheck[i].fKnown)
+            vChecks.emplace_back(headers[i], params, vPrecheck[i]);
+    }
+
+    // the calling thread works through the queue too, so this also runs without header check threads
+    CCheckQueueControl<CHeaderPoWCheck> control(&headerpowqueue);
+    control.Add(vChecks);
+    return control.Wait();
+}
+
+void PrepareHeadersPoW(const std::vector<CBlockHeader>& headers, std::vector<CHeaderPoWPrecheck>& vPrecheck)
+{
+    AssertLockHeld(cs_main);
+    vPrecheck.clear();
+    if (headers.empty())
+        return;
+
+    BlockMap::iterator mi = mapBlockIndex.find(headers[0].hashPrevBlock);
+    if (mi == mapBlockIndex.end())
+        return;
+    // A header's hash is the hashPrevBlock of the one after it, so only the last one needs hashing to find
+    // the headers in the block index. If the run is not continuous, this only misjudges which headers to
+    // skip, as AcceptBlockHeader compares the previous block data a check was done with to the real one.
+    uint256 hashLast = headers.back().GetHash();
+    std::vector<CHeaderPoWPrecheck> vResult(headers.size());
+    vResult[0].nPrevBlockTime = mi->second->GetBlockTime();
+    vResult[0].nPrevHeight = mi->second->nHeight;
+    bool fChecks = false;
+    for (size_t i = 0; i < headers.size(); i++) {
+        vResult[i].fKnown = mapBlockIndex.count(i + 1 < headers.size() ? headers[i + 1].hashPrevBlock : hashLast) > 0;
+        if (!vResult[i].fKnown)
+            fChecks = true;
+    }
+    if (fChecks)
+        vPrecheck.swap(vResult);
+}
+
+/**
+ * Check the proof of work of incoming headers in parallel and outside of cs_main, leaving
+ * AcceptBlockHeader only the contextual checks. Headers which are not checked here, because
+ * they do not connect or are known already, and the ones that fail are checked by
+ * AcceptBlockHeader as usual, which then also reports the error.
+ * Returns the number of headers checked.
+ */
+static unsigned int PrecheckHeadersPoW(const std::vector<CBlockHeader>& headers, const CChainParams& chainparams, std::vector<CHeaderPoWPrecheck>& vPrecheck)
+{
+    if (vPrecheck.empty())
+        return 0;
+    assert(vPrecheck.size() == headers.size());
+
+    unsigned int nChecks = 0;
+    for (const CHeaderPoWPrecheck& precheck : vPrecheck) {
+        if (!precheck.fKnown)
+            nChecks++;
+    }
+    CheckHeadersPoW(headers, vPrecheck[0].nPrevBlockTime, vPrecheck[0].nPrevHeight, chainparams.GetConsensus(), vPrecheck);
+    return nChecks;
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2024,6 +2246,7 @@ static ThresholdConditionCache warningcache[VERSIONBITS_NUM_BITS];
 
 static int64_t nTimeCheck = 0;
 static int64_t nTimeForks = 0;
+static int64_t nTimePrefetch = 0;
 static int64_t nTimeVerify = 0;
 static int64_t nTimeISFilter = 0;
 static int64_t nTimeSubsidy = 0;	
@@ -2038,6 +2261,89 @@ static int64_t nTimeIndex = 0;
 static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 
+/**
+ * BIBLEPAY: check a block against instantsend locks, the allowed block value and the
+ * masternode and superblock payees. None of these depend on the block's scripts, so
+ * ConnectBlock runs them while the script check threads are still verifying inputs.
+ * They have no side effects of their own: the chainlocked islocks to drop and whether
+ * to remember the block as rejected are returned, for ConnectBlock to apply once the
+ * scripts have verified.
+ */
+static bool CheckBlockLocksAndPayees(const CBlock& block, const CBlockIndex* pindex, CAmount blockReward, CValidationState& state,
+                                     std::vector<llmq::CInstantSendLockPtr>& vChainLockConflicts, bool& fRejectBlock)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    // It's possible that we simply don't have enough data and this could fail
+    // (i.e. block itself could be a correct one and we need to store it),
+    // that's why this is in ConnectBlock. Could be the other way around however -
+    // the peer who sent us this block is missing some data and wasn't able
+    // to recognize that block is actually invalid.
+
+	// BIBLEPAY : CHECK TRANSACTIONS FOR INSTANTSEND	
+
+     if (sporkManager.IsSporkActive(SPORK_3_INSTANTSEND_BLOCK_FILTERING) && sporkManager.IsSporkActive(SPORK_16_INSTANTSEND_AUTOLOCKS)) 
+	 {	
+        // Require other nodes to comply, send them some data in case they are missing it.	
+        for (const auto& tx : block.vtx) {	
+            // skip txes that have no inputs	
+            if (tx->vin.empty()) continue;	
+            // LOOK FOR TRANSACTION LOCK IN OUR MAP OF OUTPOINTS	
+            for (const auto& txin : tx->vin) {	
+                uint256 hashLocked;	
+                if (instantsend.GetLockedOutPointTxHash(txin.prevout, hashLocked) && hashLocked != tx->GetHash()) {	
+                    // The node which relayed this should switch to correct chain.	
+                    // TODO: relay instantsend data/proof.	
+                    fRejectBlock = true;
+			        return state.DoS(10, error("ConnectBlock(BIBLEPAY): transaction %s conflicts with transaction lock %s", tx->GetHash().ToString(), hashLocked.ToString()),	
+                                     REJECT_INVALID, "conflict-tx-lock");	
+                }	
+            }	
+            llmq::CInstantSendLockPtr conflictLock = llmq::quorumInstantSendManager->GetConflictingLock(*tx);	
+            if (!conflictLock) {	
+                continue;	
+            }	
+            if (llmq::chainLocksHandler->HasChainLock(pindex->nHeight, pindex->GetBlockHash())) {	
+                vChainLockConflicts.push_back(conflictLock);
+            } else {	
+                // The node which relayed this should switch to correct chain.	
+                // TODO: relay instantsend data/proof.	
+                fRejectBlock = true;
+                return state.DoS(10, error("ConnectBlock(DASH): transaction %s conflicts with transaction lock %s", tx->GetHash().ToString(), conflictLock->txid.ToString()),	
+                                 REJECT_INVALID, "conflict-tx-lock");	
+            }	
+        }	
+    } else {	
+        LogPrintf("ConnectBlock(BIBLEPAY): spork is off, skipping transaction locking checks\n");	
+    }	
+
+    int64_t nTime1 = GetTimeMicros(); nTimeISFilter += nTime1 - nTimeStart;
+    LogPrint("bench", "      - IS filter: %.2fms [%.2fs]\n", 0.001 * (nTime1 - nTimeStart), nTimeISFilter * 0.000001);
+
+    // TODO: resync data (both ways?) and try to reprocess this block later.
+    std::string strError;
+	
+    if (!IsBlockValueValid(block, pindex->nHeight, blockReward, strError)) {
+        return state.DoS(0, error("ConnectBlock(BIBLEPAY): %s", strError), REJECT_INVALID, "bad-cb-amount");
+    }
+    int64_t nTime2 = GetTimeMicros(); nTimeValueValid += nTime2 - nTime1;
+    LogPrint("bench", "      - IsBlockValueValid: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeValueValid * 0.000001);
+	
+	// Since we still live in the hybrid scenario (.13 + .14):
+	if (GetSporkDouble("SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT", 0) == 1) 
+	{
+		if (!IsBlockPayeeValid(*block.vtx[0], pindex->nHeight, blockReward)) {
+			fRejectBlock = true;
+			return state.DoS(0, error("ConnectBlock(BIBLEPAY): couldn't find masternode or superblock payments"),
+									REJECT_INVALID, "bad-cb-payee");
+		}
+	}
+    int64_t nTime3 = GetTimeMicros(); nTimePayeeValid += nTime3 - nTime2;
+    LogPrint("bench", "      - IsBlockPayeeValid: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimePayeeValid * 0.000001);
+
+    return true;
+}
+
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
@@ -2191,6 +2497,13 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     if (fDebugSpam)
 		LogPrint("bench", "    - Fork checks: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeForks * 0.000001);
 
+    // Read the inputs which are not cached yet in parallel, so the loop below and the script
+    // checks it queues are not held up by one database read after another
+    unsigned int nPrefetched = PrefetchCoins(block, view);
+    int64_t nTimePrefetched = GetTimeMicros(); nTimePrefetch += nTimePrefetched - nTime2;
+    LogPrint("bench", "    - Prefetch %u coins: %.2fms [%.2fs]\n", nPrefetched, 0.001 * (nTimePrefetched - nTime2), nTimePrefetch * 0.000001);
+    nTime2 = nTimePrefetched;
+
     CBlockUndo blockundo;
 
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : NULL);
@@ -2346,84 +2659,46 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     if (fDebugSpam)
 		LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * 0.000001);
 
+    // BIBLEPAY : MODIFIED TO CHECK MASTERNODE PAYMENTS AND SUPERBLOCKS
+    CAmount blockReward = nFees + GetBlockSubsidy(pindex->pprev->nBits, pindex->pprev->nHeight, chainparams.GetConsensus(), false);
+    CValidationState stateLocksAndPayees;
+    std::vector<llmq::CInstantSendLockPtr> vChainLockConflicts;
+    bool fRejectBlock = false;
+    bool fLocksAndPayeesValid = CheckBlockLocksAndPayees(block, pindex, blockReward, stateLocksAndPayees, vChainLockConflicts, fRejectBlock);
+    int64_t nTime4 = GetTimeMicros(); nTimeDashSpecific += nTime4 - nTime3;
+    LogPrint("bench", "    - Locks and payees (overlapped with verify): %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeDashSpecific * 0.000001);
+
     if (!control.Wait())
         return state.DoS(100, false);
-    int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
+    int64_t nTime5 = GetTimeMicros(); nTimeVerify += nTime5 - nTime2;
     if (fDebugSpam)
-		LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * 0.000001);
-
-    // BIBLEPAY : MODIFIED TO CHECK MASTERNODE PAYMENTS AND SUPERBLOCKS
-
-    // It's possible that we simply don't have enough data and this could fail
-    // (i.e. block itself could be a correct one and we need to store it),
-    // that's why this is in ConnectBlock. Could be the other way around however -
-    // the peer who sent us this block is missing some data and wasn't able
-    // to recognize that block is actually invalid.
-
-	// BIBLEPAY : CHECK TRANSACTIONS FOR INSTANTSEND	
-
-     if (sporkManager.IsSporkActive(SPORK_3_INSTANTSEND_BLOCK_FILTERING) && sporkManager.IsSporkActive(SPORK_16_INSTANTSEND_AUTOLOCKS)) 
-	 {	
-        // Require other nodes to comply, send them some data in case they are missing it.	
-        for (const auto& tx : block.vtx) {	
-            // skip txes that have no inputs	
-            if (tx->vin.empty()) continue;	
-            // LOOK FOR TRANSACTION LOCK IN OUR MAP OF OUTPOINTS	
-            for (const auto& txin : tx->vin) {	
-                uint256 hashLocked;	
-                if (instantsend.GetLockedOutPointTxHash(txin.prevout, hashLocked) && hashLocked != tx->GetHash()) {	
-                    // The node which relayed this should switch to correct chain.	
-                    // TODO: relay instantsend data/proof.	
-                    LOCK(cs_main);	
-                    mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));	
-			        return state.DoS(10, error("ConnectBlock(BIBLEPAY): transaction %s conflicts with transaction lock %s", tx->GetHash().ToString(), hashLocked.ToString()),	
-                                     REJECT_INVALID, "conflict-tx-lock");	
-                }	
-            }	
-            llmq::CInstantSendLockPtr conflictLock = llmq::quorumInstantSendManager->GetConflictingLock(*tx);	
-            if (!conflictLock) {	
-                continue;	
-            }	
-            if (llmq::chainLocksHandler->HasChainLock(pindex->nHeight, pindex->GetBlockHash())) {	
-                llmq::quorumInstantSendManager->RemoveChainLockConflictingLock(::SerializeHash(*conflictLock), *conflictLock);	
-                assert(llmq::quorumInstantSendManager->GetConflictingLock(*tx) == nullptr);	
-            } else {	
-                // The node which relayed this should switch to correct chain.	
-                // TODO: relay instantsend data/proof.	
-                LOCK(cs_main);	
-                mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));	
-                return state.DoS(10, error("ConnectBlock(DASH): transaction %s conflicts with transaction lock %s", tx->GetHash().ToString(), conflictLock->txid.ToString()),	
-                                 REJECT_INVALID, "conflict-tx-lock");	
-            }	
-        }	
-    } else {	
-        LogPrintf("ConnectBlock(BIBLEPAY): spork is off, skipping transaction locking checks\n");	
-    }	
-
-    // BIBLEPAY : MODIFIED TO CHECK MASTERNODE PAYMENTS AND SUPERBLOCKS	
+		LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin, %.2fms after connect) [%.2fs]\n", nInputs - 1, 0.001 * (nTime5 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime5 - nTime2) / (nInputs-1), 0.001 * (nTime5 - nTime4), nTimeVerify * 0.000001);
+
+    // Only a block with valid scripts may drop islocks or be remembered as rejected
+    std::set<uint256> setRemovedLocks;
+    for (const auto& conflictLock : vChainLockConflicts) {
+        uint256 hashLock = ::SerializeHash(*conflictLock);
+        if (setRemovedLocks.insert(hashLock).second) {
+            llmq::quorumInstantSendManager->RemoveChainLockConflictingLock(hashLock, *conflictLock);
+        }
+    }
+    if (fRejectBlock) {
+        mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
+    }
 
-    // TODO: resync data (both ways?) and try to reprocess this block later.
-    CAmount blockReward = nFees + GetBlockSubsidy(pindex->pprev->nBits, pindex->pprev->nHeight, chainparams.GetConsensus(), false);
-    std::string strError;
-	
-    if (!IsBlockValueValid(block, pindex->nHeight, blockReward, strError)) {
-        return state.DoS(0, error("ConnectBlock(BIBLEPAY): %s", strError), REJECT_INVALID, "bad-cb-amount");
+    // A script failure is reported first, as it was when these checks ran after it
+    if (!fLocksAndPayeesValid) {
+        state = stateLocksAndPayees;
+        return false;
     }
-	
-	// Since we still live in the hybrid scenario (.13 + .14):
-	if (GetSporkDouble("SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT", 0) == 1) 
-	{
-		if (!IsBlockPayeeValid(*block.vtx[0], pindex->nHeight, blockReward)) {
-			mapRejectedBlocks.insert(std::make_pair(block.GetHash(), GetTime()));
-			return state.DoS(0, error("ConnectBlock(BIBLEPAY): couldn't find masternode or superblock payments"),
-									REJECT_INVALID, "bad-cb-payee");
-		}
-	}
 
+    // Special transactions update the masternode list and quorum state, so they are only processed for verified blocks
 	if (!ProcessSpecialTxsInBlock(block, pindex, state, fJustCheck, fScriptChecks)) {	
         return error("ConnectBlock(DASH): ProcessSpecialTxsInBlock for block %s failed with %s",	
                      pindex->GetBlockHash().ToString(), FormatStateMessage(state));	
     }
+    int64_t nTime6 = GetTimeMicros(); nTimeProcessSpecial += nTime6 - nTime5;
+    LogPrint("bench", "    - ProcessSpecialTxsInBlock: %.2fms [%.2fs]\n", 0.001 * (nTime6 - nTime5), nTimeProcessSpecial * 0.000001);
 
     // END BIBLEPAY
 
@@ -2454,7 +2729,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             return AbortNode(state, "Failed to write transaction index");
 
     if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
+        if (!pblocktree->WriteAddressIndex(addressIndex, fAddressBalanceIndex)) {
             return AbortNode(state, "Failed to write address index");
         }
 
@@ -2493,6 +2768,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     return true;
 }
 
+static CCriticalSection cs_coinsFlushStats;
+static CCoinsFlushStats coinsFlushStats = {};
+
 /**
  * Update the on-disk chain state.
  * The caches and indexes are flushed depending on the mode we're called with
@@ -2588,13 +2866,39 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         // overwrite one. Still, use a conservative safety factor of 2.
         if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
             return state.Error("out of disk space");
-        // Flush the chainstate (which may refer to block index entries).
-        if (!pcoinsTip->Flush())
-            return AbortNode(state, "Failed to write to coin database");
+        // Flush the chainstate (which may refer to block index entries). Unless -dbcachekeep=0, the
+        // cache keeps its entries; only when it grew too large are the least recently used ones
+        // dropped, so block validation does not have to read the hot coins back from disk.
+        size_t nEntries = pcoinsTip->GetCacheSize();
+        bool fTrim = nCoinCacheKeepPercent > 0;
+        if (fTrim) {
+            // The evo database counts against -dbcache as well, so leave room for what it holds
+            size_t nTargetUsage = std::numeric_limits<size_t>::max();
+            if (fCacheLarge || fCacheCritical) {
+                size_t nKeepUsage = nCoinCacheUsage / 100 * nCoinCacheKeepPercent;
+                size_t nEvoUsage = evoDb->GetMemoryUsage() * DB_PEAK_USAGE_FACTOR;
+                nTargetUsage = nKeepUsage > nEvoUsage ? (nKeepUsage - nEvoUsage) / DB_PEAK_USAGE_FACTOR : 0;
+            }
+            if (!pcoinsTip->FlushAndTrim(nTargetUsage))
+                return AbortNode(state, "Failed to write to coin database");
+        } else {
+            if (!pcoinsTip->Flush())
+                return AbortNode(state, "Failed to write to coin database");
+        }
 		if (!evoDb->CommitRootTransaction()) {	
             return AbortNode(state, "Failed to commit EvoDB");	
         }
         nLastFlush = nNow;
+        int64_t nFlushTime = GetTimeMicros() - nNow;
+        {
+            LOCK(cs_coinsFlushStats);
+            (fTrim ? coinsFlushStats.nTrimFlushes : coinsFlushStats.nFullFlushes)++;
+            coinsFlushStats.nLastFlushTime = nFlushTime;
+            coinsFlushStats.nMaxFlushTime = std::max(coinsFlushStats.nMaxFlushTime, nFlushTime);
+            coinsFlushStats.nTotalFlushTime += nFlushTime;
+            coinsFlushStats.nLastFlushEntries = nEntries;
+        }
+        LogPrint("bench", "  - Flush chainstate (%u coins cached, %u kept): %.2fms\n", (unsigned int)nEntries, pcoinsTip->GetCacheSize(), nFlushTime * 0.001);
     }
     if (fDoFullFlush || ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000)) {
         // Update best block in wallet (so we can detect restored wallets).
@@ -2612,6 +2916,12 @@ void FlushStateToDisk() {
     FlushStateToDisk(state, FLUSH_STATE_ALWAYS);
 }
 
+CCoinsFlushStats GetCoinsFlushStats()
+{
+    LOCK(cs_coinsFlushStats);
+    return coinsFlushStats;
+}
+
 void PruneAndFlush() {
     CValidationState state;
     fCheckForPruning = true;
@@ -3752,7 +4062,7 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, const Co
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, const CHeaderPoWPrecheck* pprecheck = NULL)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3783,7 +4093,9 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 
 		pindexPrev = (*mi).second;
 		// R ANDREWS - Now we can check the block header:
-		if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), true, block.GetBlockTime(), pindexPrev ? pindexPrev->nTime : 0, pindexPrev ? pindexPrev->nHeight : 0, pindexPrev))
+		// Proof of work already checked by PrecheckHeadersPoW against the same previous block is not checked again
+		bool fPoWChecked = pprecheck && pprecheck->fValid && pprecheck->nPrevBlockTime == pindexPrev->GetBlockTime() && pprecheck->nPrevHeight == pindexPrev->nHeight;
+		if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), !fPoWChecked, block.GetBlockTime(), pindexPrev ? pindexPrev->nTime : 0, pindexPrev ? pindexPrev->nHeight : 0, pindexPrev))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
 		if (pindexPrev->nStatus & BLOCK_FAILED_MASK)
@@ -3824,19 +4136,34 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, std::vector<CHeaderPoWPrecheck>* pvPrecheck)
 {
+    int64_t nTimeStart = GetTimeMicros();
+    std::vector<CHeaderPoWPrecheck> vPrecheckOwn;
+    if (!pvPrecheck) {
+        LOCK(cs_main);
+        PrepareHeadersPoW(headers, vPrecheckOwn);
+        pvPrecheck = &vPrecheckOwn;
+    }
+    std::vector<CHeaderPoWPrecheck>& vPrecheck = *pvPrecheck;
+    unsigned int nChecked = PrecheckHeadersPoW(headers, chainparams, vPrecheck);
+    int64_t nTimePrecheck = GetTimeMicros();
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        int64_t nTimeLocked = GetTimeMicros();
+        for (size_t i = 0; i < headers.size(); i++) {
             CBlockIndex *pindex = NULL; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!AcceptBlockHeader(headers[i], state, chainparams, &pindex, vPrecheck.empty() ? NULL : &vPrecheck[i])) {
                 return false;
             }
             if (ppindex) {
                 *ppindex = pindex;
             }
         }
+        int64_t nTimeAccepted = GetTimeMicros();
+        LogPrint("bench", "- Process %u headers: PoW of %u checked in %.2fms, cs_main wait %.2fms, accepted in %.2fms\n",
+                 (unsigned int)headers.size(), nChecked, 0.001 * (nTimePrecheck - nTimeStart),
+                 0.001 * (nTimeLocked - nTimePrecheck), 0.001 * (nTimeAccepted - nTimeLocked));
     }
     NotifyHeaderTip();
     return true;
@@ -4338,6 +4665,9 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     // Check whether we have an address index
     pblocktree->ReadFlag("addressindex", fAddressIndex);
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
+    fAddressBalanceIndex = false;
+    pblocktree->ReadFlag("addressbalanceindex", fAddressBalanceIndex);
+    fAddressBalanceIndex &= fAddressIndex;
 
     // Check whether we have a timestamp index
     pblocktree->ReadFlag("timestampindex", fTimestampIndex);
@@ -4538,6 +4868,8 @@ bool InitBlockIndex(const CChainParams& chainparams)
     // Use the provided setting for -addressindex in the new database
     fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
     pblocktree->WriteFlag("addressindex", fAddressIndex);
+    fAddressBalanceIndex = fAddressIndex;
+    pblocktree->WriteFlag("addressbalanceindex", fAddressBalanceIndex);
 
     // Use the provided setting for -timestampindex in the new database
     fTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
@@ -4900,15 +5232,200 @@ int VersionBitsTipStateSinceHeight(const Consensus::Params& params, Consensus::D
     return VersionBitsStateSinceHeight(chainActive.Tip(), params, pos, versionbitscache);
 }
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION_SINGLE_STREAM = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION = 2;
+/** Limits of one chunk of mempool.dat, which is also what is verified in parallel at once when loading it */
+static const unsigned int MEMPOOL_DUMP_CHUNK_TXS = 1000;
+static const size_t MEMPOOL_DUMP_CHUNK_BYTES = 4 * 1024 * 1024;
+/** Number of fee deltas in one chunk of mempool.dat */
+static const size_t MEMPOOL_DUMP_CHUNK_DELTAS = 50000;
+/** Starts every chunk of mempool.dat, so that the next chunk can be found after a corrupt one */
+static const unsigned char MEMPOOL_DUMP_CHUNK_MARKER[4] = {0xf3, 0x6d, 0x70, 0x63};
 
-bool LoadMempool(void)
+static CCriticalSection cs_mempoolLoadStats;
+static CMempoolLoadStats mempoolLoadStats = {};
+
+CMempoolLoadStats GetMempoolLoadStats()
 {
-	if (GetBoolArg("-zapwallettxes", false)) {	
-        LogPrintf("Skipping mempool.dat because of zapwallettxes\n");	
-        return true;	
+    LOCK(cs_mempoolLoadStats);
+    return mempoolLoadStats;
+}
+
+struct CMempoolDumpEntry
+{
+    CTransactionRef tx;
+    int64_t nTime;
+    int64_t nFeeDelta;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(tx);
+        READWRITE(nTime);
+        READWRITE(nFeeDelta);
+    }
+};
+
+/**
+ * Check the scripts of a chunk of transactions read from mempool.dat on the
+ * script check threads, storing the results in the signature cache, so that
+ * accepting them one by one under cs_main afterwards only hits the cache.
+ * The results are not used otherwise, AcceptToMemoryPool does all checks again.
+ */
+static void PreverifyMempoolChunk(const std::vector<CMempoolDumpEntry>& vEntries)
+{
+    if (!nScriptCheckThreads)
+        return;
+
+    // Copy the spent coins out of the chain state and mempool, adding the outputs
+    // of the chunk itself for chains of unconfirmed transactions
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    std::vector<const CTransaction*> vToCheck;
+    {
+        LOCK2(cs_main, mempool.cs);
+        CCoinsViewMemPool viewMemPool(pcoinsTip, mempool);
+        for (const CMempoolDumpEntry& entry : vEntries) {
+            const CTransaction& tx = *entry.tx;
+            if (tx.IsCoinBase())
+                continue;
+            bool fHaveInputs = true;
+            for (const CTxIn& txin : tx.vin) {
+                if (view.HaveCoinInCache(txin.prevout))
+                    continue;
+                Coin coin;
+                if (!viewMemPool.GetCoin(txin.prevout, coin) || coin.IsSpent()) {
+                    fHaveInputs = false;
+                    break;
+                }
+                view.AddCoin(txin.prevout, std::move(coin), true);
+            }
+            if (fHaveInputs)
+                vToCheck.push_back(&tx);
+            for (size_t i = 0; i < tx.vout.size(); i++)
+                view.AddCoin(COutPoint(tx.GetHash(), i), Coin(tx.vout[i], MEMPOOL_HEIGHT, false), true);
+        }
+    }
+
+    std::vector<CScriptCheck> vChecks;
+    for (const CTransaction* ptx : vToCheck) {
+        for (unsigned int i = 0; i < ptx->vin.size(); i++) {
+            const Coin& coin = view.AccessCoin(ptx->vin[i].prevout);
+            vChecks.emplace_back(coin.out.scriptPubKey, coin.out.nValue, *ptx, i, STANDARD_SCRIPT_VERIFY_FLAGS, true);
+        }
+    }
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
+/** Accept one transaction read from mempool.dat, returns false when shutdown was requested */
+static bool LoadMempoolEntry(const CMempoolDumpEntry& entry, int64_t nExpiryTimeout, int64_t nNow, int64_t& count, int64_t& failed, int64_t& skipped)
+{
+    CAmount amountdelta = entry.nFeeDelta;
+    if (amountdelta) {
+        mempool.PrioritiseTransaction(entry.tx->GetHash(), amountdelta);
+    }
+    CValidationState state;
+    if (entry.nTime + nExpiryTimeout > nNow) {
+        LOCK(cs_main);
+        AcceptToMemoryPoolWithTime(mempool, state, entry.tx, true, NULL, entry.nTime);
+        if (state.IsValid()) {
+            ++count;
+        } else {
+            ++failed;
+        }
+    } else {
+        ++skipped;
+    }
+    return !ShutdownRequested();
+}
+
+static void UpdateMempoolLoadStats(int64_t count, int64_t failed, int64_t skipped)
+{
+    LOCK(cs_mempoolLoadStats);
+    mempoolLoadStats.nAccepted = count;
+    mempoolLoadStats.nFailed = failed;
+    mempoolLoadStats.nExpired = skipped;
+}
+
+static uint256 MempoolChunkHash(uint32_t nChunkTxs, const std::vector<unsigned char>& vchData)
+{
+    return (CHashWriter(SER_GETHASH, 0) << nChunkTxs << vchData).GetHash();
+}
+
+void WriteMempoolChunk(CAutoFile& file, uint32_t nChunkTxs, const CDataStream& ssChunk)
+{
+    std::vector<unsigned char> vchData(ssChunk.begin(), ssChunk.end());
+    file << FLATDATA(MEMPOOL_DUMP_CHUNK_MARKER) << nChunkTxs << (uint32_t)vchData.size();
+    file.write((const char*)vchData.data(), vchData.size());
+    file << MempoolChunkHash(nChunkTxs, vchData);
+}
+
+bool ReadMempoolChunks(FILE* fileIn, const std::function<bool(uint32_t, CDataStream&)>& fnChunk, int64_t& nCorrupt)
+{
+    // Like LoadExternalBlockFile: after anything unexpected, go on from one byte after
+    // the last marker. The checksum covers the length, so a corrupt length prefix is
+    // detected as well and the search for the next marker starts within the chunk.
+    const uint32_t nMaxChunkSize = MEMPOOL_DUMP_CHUNK_BYTES + MaxBlockSize(true);
+    const uint64_t nMaxChunkBytes = sizeof(MEMPOOL_DUMP_CHUNK_MARKER) + 2 * sizeof(uint32_t) + nMaxChunkSize + sizeof(uint256);
+    // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
+    CBufferedFile file(fileIn, 2 * nMaxChunkBytes, nMaxChunkBytes, SER_DISK, CLIENT_VERSION);
+    uint64_t nRewind = file.GetPos();
+    while (true) {
+        file.SetPos(nRewind);
+        if (file.eof())
+            break;
+        nRewind++; // start one byte further next time, in case of failure
+        file.SetLimit();
+        uint32_t nChunkTxs;
+        uint32_t nSize;
+        try {
+            unsigned char buf[sizeof(MEMPOOL_DUMP_CHUNK_MARKER)];
+            file.FindByte(MEMPOOL_DUMP_CHUNK_MARKER[0]);
+            nRewind = file.GetPos() + 1;
+            file >> FLATDATA(buf);
+            if (memcmp(buf, MEMPOOL_DUMP_CHUNK_MARKER, sizeof(buf)))
+                continue;
+            file >> nChunkTxs >> nSize;
+            if (nSize > nMaxChunkSize) {
+                nCorrupt++;
+                continue;
+            }
+        } catch (const std::exception&) {
+            // no further chunk
+            break;
+        }
+        std::vector<unsigned char> vchData(nSize);
+        uint256 hashIn;
+        try {
+            file.read((char*)vchData.data(), vchData.size());
+            file >> hashIn;
+        } catch (const std::exception&) {
+            // a torn chunk at the end of the file, or a length beyond it
+            nCorrupt++;
+            continue;
+        }
+        if (hashIn != MempoolChunkHash(nChunkTxs, vchData)) {
+            nCorrupt++;
+            continue;
+        }
+        nRewind = file.GetPos();
+        CDataStream ssChunk(vchData, SER_DISK, CLIENT_VERSION);
+        try {
+            if (!fnChunk(nChunkTxs, ssChunk))
+                return false;
+        } catch (const std::ios_base::failure&) {
+            // intact but not what it claims to hold, the chunks after it are fine
+            nCorrupt++;
+        }
     }
+    return true;
+}
 
+static bool LoadMempoolFile()
+{
     int64_t nExpiryTimeout = GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60;
     FILE* filestr = fopen((GetDataDir() / "mempool.dat").string().c_str(), "rb");
     CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
@@ -4920,45 +5437,58 @@ bool LoadMempool(void)
     int64_t count = 0;
     int64_t skipped = 0;
     int64_t failed = 0;
+    int64_t corrupt = 0;
     int64_t nNow = GetTime();
 
     try {
         uint64_t version;
         file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        if (version != MEMPOOL_DUMP_VERSION && version != MEMPOOL_DUMP_VERSION_SINGLE_STREAM) {
             return false;
         }
         uint64_t num;
         file >> num;
-        while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+        {
+            LOCK(cs_mempoolLoadStats);
+            mempoolLoadStats.nTotal = num;
+        }
+        std::map<uint256, CAmount> mapDeltas;
+        if (version == MEMPOOL_DUMP_VERSION_SINGLE_STREAM) {
+            while (num--) {
+                CMempoolDumpEntry entry;
+                file >> entry;
+                if (!LoadMempoolEntry(entry, nExpiryTimeout, nNow, count, failed, skipped))
+                    return false;
+                UpdateMempoolLoadStats(count, failed, skipped);
             }
-            CValidationState state;
-            if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(mempool, state, tx, true, NULL, nTime);
-                if (state.IsValid()) {
-                    ++count;
-                } else {
-                    ++failed;
+            file >> mapDeltas;
+        } else {
+            // Chunks of transactions, each with its own checksum, followed by ones
+            // without transactions which hold the fee deltas
+            bool fCompleted = ReadMempoolChunks(file.release(), [&](uint32_t nChunkTxs, CDataStream& ssChunk) {
+                if (nChunkTxs == 0) {
+                    std::map<uint256, CAmount> mapChunkDeltas;
+                    ssChunk >> mapChunkDeltas;
+                    mapDeltas.insert(mapChunkDeltas.begin(), mapChunkDeltas.end());
+                    return true;
                 }
-            } else {
-                ++skipped;
-            }
-            if (ShutdownRequested())
+                std::vector<CMempoolDumpEntry> vEntries;
+                vEntries.reserve(std::min(nChunkTxs, MEMPOOL_DUMP_CHUNK_TXS));
+                while (vEntries.size() < nChunkTxs) {
+                    vEntries.emplace_back();
+                    ssChunk >> vEntries.back();
+                }
+                PreverifyMempoolChunk(vEntries);
+                for (const CMempoolDumpEntry& entry : vEntries) {
+                    if (!LoadMempoolEntry(entry, nExpiryTimeout, nNow, count, failed, skipped))
+                        return false;
+                }
+                UpdateMempoolLoadStats(count, failed, skipped);
+                return true;
+            }, corrupt);
+            if (!fCompleted)
                 return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
-        file >> mapDeltas;
 
         for (const auto& i : mapDeltas) {
             mempool.PrioritiseTransaction(i.first, i.second);
@@ -4968,10 +5498,33 @@ bool LoadMempool(void)
         return false;
     }
 
-    LogPrintf("Imported mempool transactions from disk: %i successes, %i failed, %i expired\n", count, failed, skipped);
+    LogPrintf("Imported mempool transactions from disk: %i successes, %i failed, %i expired, %i corrupt chunks skipped\n", count, failed, skipped, corrupt);
     return true;
 }
 
+bool LoadMempool(void)
+{
+	if (GetBoolArg("-zapwallettxes", false)) {	
+        LogPrintf("Skipping mempool.dat because of zapwallettxes\n");	
+        return true;	
+    }
+
+    int64_t nStart = GetTimeMillis();
+    {
+        LOCK(cs_mempoolLoadStats);
+        mempoolLoadStats.fLoading = true;
+    }
+    bool fLoaded = LoadMempoolFile();
+    {
+        LOCK(cs_mempoolLoadStats);
+        mempoolLoadStats.fLoading = false;
+        mempoolLoadStats.fLoaded = fLoaded;
+        mempoolLoadStats.nLoadTime = GetTimeMillis() - nStart;
+    }
+    LogPrint("bench", "Loading mempool.dat took %dms\n", GetTimeMillis() - nStart);
+    return fLoaded;
+}
+
 void DumpMempool(void)
 {
     int64_t start = GetTimeMicros();
@@ -5002,14 +5555,40 @@ void DumpMempool(void)
         file << version;
 
         file << (uint64_t)vinfo.size();
+        // Each chunk is serialized into a buffer first, so that it can be
+        // written with its length and checksum
+        CDataStream ssChunk(SER_DISK, CLIENT_VERSION);
+        uint32_t nChunkTxs = 0;
+        auto writeChunk = [&]() {
+            WriteMempoolChunk(file, nChunkTxs, ssChunk);
+            ssChunk.clear();
+            nChunkTxs = 0;
+        };
         for (const auto& i : vinfo) {
-            file << *(i.tx);
-            file << (int64_t)i.nTime;
-            file << (int64_t)i.nFeeDelta;
+            ssChunk << *(i.tx);
+            ssChunk << (int64_t)i.nTime;
+            ssChunk << (int64_t)i.nFeeDelta;
             mapDeltas.erase(i.tx->GetHash());
+            if (++nChunkTxs == MEMPOOL_DUMP_CHUNK_TXS || ssChunk.size() >= MEMPOOL_DUMP_CHUNK_BYTES)
+                writeChunk();
         }
+        if (nChunkTxs)
+            writeChunk();
 
-        file << mapDeltas;
+        // The remaining fee deltas, in chunks without transactions
+        std::map<uint256, CAmount> mapChunkDeltas;
+        for (const auto& i : mapDeltas) {
+            mapChunkDeltas.insert(i);
+            if (mapChunkDeltas.size() == MEMPOOL_DUMP_CHUNK_DELTAS) {
+                ssChunk << mapChunkDeltas;
+                writeChunk();
+                mapChunkDeltas.clear();
+            }
+        }
+        if (!mapChunkDeltas.empty()) {
+            ssChunk << mapChunkDeltas;
+            writeChunk();
+        }
         FileCommit(file.Get());
         file.fclose();
         RenameOver(GetDataDir() / "mempool.dat.new", GetDataDir() / "mempool.dat");
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <functional>
 #include <map>
 #include <set>
 #include <stdint.h>
@@ -37,6 +38,7 @@
 #include <boost/filesystem/path.hpp>
 #include "support/allocators/secure.h" //For SecureString
 
+class CAutoFile;
 class CBlockIndex;
 class CBlockTreeDB;
 class CBloomFilter;
@@ -44,6 +46,7 @@ class CChainParams;
 class CCoinsViewDB;
 class CInv;
 class CConnman;
+class CDataStream;
 class CScriptCheck;
 class CTxMemPool;
 class CValidationInterface;
@@ -109,6 +112,8 @@ static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 static const unsigned int DATABASE_WRITE_INTERVAL = 60 * 60;
 /** Time to wait (in seconds) between flushing chainstate to disk. */
 static const unsigned int DATABASE_FLUSH_INTERVAL = 24 * 60 * 60;
+/** Default for -dbcachekeep, percentage of the UTXO cache budget kept in use after a flush (0 = empty the cache) */
+static const unsigned int DEFAULT_DB_CACHE_KEEP = 70;
 /** Maximum length of reject messages. */
 static const unsigned int MAX_REJECT_MESSAGE_LENGTH = 111;
 /** Average delay between local address broadcasts in seconds. */
@@ -244,6 +249,7 @@ extern bool fProd;
 extern bool fLoadingIndex;
 
 extern size_t nCoinCacheUsage;
+extern unsigned int nCoinCacheKeepPercent;
 /** A fee rate smaller than this is considered zero fee (for relaying, mining and transaction creation) */
 extern CFeeRate minRelayTxFee;
 /** Absolute maximum transaction fee (in duffs) used by wallet and mempool (rejects high fee in sendrawtransaction) */
@@ -318,6 +324,28 @@ static const uint64_t MIN_DISK_SPACE_FOR_BLOCK_FILES = 945 * 1024 * 1024;
  */
 bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<const CBlock> pblock, bool fForceProcessing, bool* fNewBlock);
 
+/** Proof of work check of one header done ahead of AcceptBlockHeader, and the previous block data it was done with */
+struct CHeaderPoWPrecheck
+{
+    int64_t nPrevBlockTime;
+    int nPrevHeight;
+    //! header is in the block index already, its proof of work was not checked
+    bool fKnown;
+    //! proof of work was checked and is valid
+    bool fValid;
+
+    CHeaderPoWPrecheck() : nPrevBlockTime(0), nPrevHeight(0), fKnown(false), fValid(false) {}
+};
+
+/**
+ * Prepare the proof of work check of a run of incoming headers, which ProcessNewBlockHeaders then does outside of
+ * cs_main: mark the headers which are in the block index already and note the block the run builds on in the first
+ * entry. vPrecheck is left empty if the run does not connect or there is nothing to check.
+ *
+ * Requires cs_main, so that callers can do this along with their own checks of the headers.
+ */
+void PrepareHeadersPoW(const std::vector<CBlockHeader>& headers, std::vector<CHeaderPoWPrecheck>& vPrecheck);
+
 /**
  * Process incoming block headers.
  *
@@ -327,8 +355,18 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  * @param[out] state This may be set to an Error state if any error occurred processing them
  * @param[in]  chainparams The params for the chain we want to connect to
  * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
+ * @param[in]  pvPrecheck If set, the result of PrepareHeadersPoW for these headers, else it is prepared here
+ */
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL, std::vector<CHeaderPoWPrecheck>* pvPrecheck=NULL);
+
+/**
+ * Check the proof of work of a run of headers, each building on the one before, on the header check threads.
+ * The first header builds on a block with time nPrevBlockTime at height nPrevHeight. vPrecheck has one entry per
+ * header; the ones marked fKnown are skipped.
+ *
+ * @return True if the proof of work of all checked headers is valid
  */
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL);
+bool CheckHeadersPoW(const std::vector<CBlockHeader>& headers, int64_t nPrevBlockTime, int nPrevHeight, const Consensus::Params& params, std::vector<CHeaderPoWPrecheck>& vPrecheck);
 
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
@@ -348,6 +386,10 @@ bool LoadBlockIndex(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the thread reading block inputs from the coins database ahead of ConnectBlock */
+void ThreadCoinsPrefetch();
+/** Run an instance of the thread checking the proof of work of incoming headers */
+void ThreadHeaderPoWCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -404,6 +446,18 @@ void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune);
 CBlockIndex * InsertBlockIndex(uint256 hash);
 /** Flush all state, indexes and buffers to disk. */
 void FlushStateToDisk();
+
+/** Durations of the chainstate flushes done by FlushStateToDisk, as returned by GetCoinsFlushStats */
+struct CCoinsFlushStats
+{
+    uint64_t nFullFlushes;
+    uint64_t nTrimFlushes;
+    int64_t nLastFlushTime;
+    int64_t nMaxFlushTime;
+    int64_t nTotalFlushTime;
+    size_t nLastFlushEntries;
+};
+CCoinsFlushStats GetCoinsFlushStats();
 /** Prune block files and flush state to disk. */
 void PruneAndFlush();
 /** Prune block files up to a given height */
@@ -553,9 +607,12 @@ bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::v
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
 bool GetAddressIndex(uint160 addressHash, int type,
                      std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                     int start = 0, int end = 0);
+                     int start = 0, int end = 0,
+                     size_t nLimit = 0, const CAddressIndexKey* pResumeKey = nullptr);
 bool GetAddressUnspent(uint160 addressHash, int type,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       size_t nLimit = 0, const CAddressUnspentKey* pResumeKey = nullptr);
+bool GetAddressBalance(uint160 addressHash, int type, CAddressBalance &balance);
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
@@ -658,4 +715,28 @@ void DumpMempool();
 /** Load the mempool from disk. */
 bool LoadMempool();
 
+/** Write one chunk of mempool.dat: a marker, the number of transactions, the length of the data, the data and a checksum */
+void WriteMempoolChunk(CAutoFile& file, uint32_t nChunkTxs, const CDataStream& ssChunk);
+
+/**
+ * Call fnChunk with the number of transactions and the data of each intact chunk of
+ * mempool.dat until the end of fileIn, which is closed afterwards. A corrupt chunk is
+ * skipped by searching for the next chunk marker, and counted in nCorrupt. Returns
+ * false if fnChunk did.
+ */
+bool ReadMempoolChunks(FILE* fileIn, const std::function<bool(uint32_t, CDataStream&)>& fnChunk, int64_t& nCorrupt);
+
+/** Progress of LoadMempool, as returned by GetMempoolLoadStats */
+struct CMempoolLoadStats
+{
+    bool fLoading;
+    bool fLoaded;
+    uint64_t nTotal;
+    int64_t nAccepted;
+    int64_t nFailed;
+    int64_t nExpired;
+    int64_t nLoadTime;
+};
+CMempoolLoadStats GetMempoolLoadStats();
+
 #endif // BITCOIN_VALIDATION_H